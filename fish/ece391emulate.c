@@ -2,6 +2,7 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -176,6 +177,24 @@ ece391_vidmap (uint8_t** screen_start)
     return 0;
 }
 
+int32_t
+ece391_blit (const uint16_t* cells, uint32_t pos, uint32_t size)
+{
+    static uint8_t* screen = NULL;
+    uint32_t x = pos & 0xffff, y = pos >> 16;
+    uint32_t width = size & 0xffff, height = size >> 16;
+    uint32_t row;
+
+    if (NULL == screen && -1 == ece391_vidmap (&screen))
+        return -1;
+    if (x + width > 80 || y + height > 25)
+        return -1;
+    for (row = 0; row < height; row++)
+        memcpy (screen + ((y + row) * 80 + x) * 2, cells + row * width,
+                width * 2);
+    return 0;
+}
+
 int32_t 
 ece391_read (int32_t fd, void* buf, int32_t nbytes)
 {
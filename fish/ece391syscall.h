@@ -19,6 +19,8 @@ extern int32_t ece391_open (const uint8_t* filename);
 extern int32_t ece391_close (int32_t fd);
 extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
+/* pos is x | (y << 16), size is width | (height << 16) */
+extern int32_t ece391_blit (const uint16_t* cells, uint32_t pos, uint32_t size);
 
 #endif /* ECE391SYSCALL_H */
 
@@ -5,8 +5,11 @@
 
 #define NULL 0
 #define WAIT 100
+#define SCREEN_COLS 80
+#define SCREEN_ROWS 25
 uint8_t *vmem_base_addr;
 uint8_t *mp1_set_video_mode (void);
+void mp1_show_frame (void);
 void add_frames(uint8_t *, uint8_t *, int32_t);
 void ece391_memset(void* memory, char c, int n);
 int32_t ece391_memcpy(void* dest, const void* src, int32_t n);
@@ -20,6 +23,9 @@ extern void mp1_rtc_tasklet(unsigned long trash);
 
 static struct mp1_blink_struct blink_array[80*25];
 
+/* blink.S draws here; each frame is sent to the screen with one blit */
+static uint16_t screen_buf[SCREEN_COLS*SCREEN_ROWS];
+
 int main(void)
 {
     int rtc_fd, ret_val, i, garbage;
@@ -41,6 +47,7 @@ int main(void)
     for(i=0; i<WAIT; i++) {
         ece391_read(rtc_fd, &garbage, 4);
         mp1_rtc_tasklet(garbage);
+        mp1_show_frame();
     }
 
     blink_struct.on_char = 'I';
@@ -54,6 +61,7 @@ int main(void)
     for(i=0; i<WAIT; i++) {
         ece391_read(rtc_fd, &garbage, 4);
         mp1_rtc_tasklet(garbage);
+        mp1_show_frame();
     }
 
     mp1_ioctl((40 << 16 | (6*80+60)), RTC_SYNC);
@@ -61,6 +69,7 @@ int main(void)
     for(i=0; i<WAIT; i++) {
         ece391_read(rtc_fd, &garbage, 4);
         mp1_rtc_tasklet(garbage);
+        mp1_show_frame();
     }
 
     mp1_ioctl(6*80+60, RTC_REMOVE);
@@ -68,6 +77,7 @@ int main(void)
     for(i=0; i<WAIT; i++) {
         ece391_read(rtc_fd, &garbage, 4);
         mp1_rtc_tasklet(garbage);
+        mp1_show_frame();
     }
 
     ece391_close(rtc_fd);
@@ -150,11 +160,18 @@ add_frames(uint8_t *f0, uint8_t *f1, int32_t rtc_fd)
 uint8_t*
 mp1_set_video_mode (void)
 {
-    if(ece391_vidmap(&vmem_base_addr) == -1) {
-        return NULL;
-    } else {
-        return vmem_base_addr;
+    int32_t i;
+    for(i=0; i<SCREEN_COLS*SCREEN_ROWS; i++) {
+        screen_buf[i] = 0x0720;
     }
+    vmem_base_addr = (uint8_t*)screen_buf;
+    return vmem_base_addr;
+}
+
+void
+mp1_show_frame (void)
+{
+    ece391_blit(screen_buf, 0, SCREEN_COLS | (SCREEN_ROWS << 16));
 }
 
 void* mp1_malloc(int32_t size)
@@ -0,0 +1,519 @@
+/* assetenc.c - Host side encoder for the kernel's built in assets
+ *
+ * Takes the raw arrays generated by the notebooks in this folder
+ * (uiuc_array.c, chinese.c) and writes the compressed C sources that get
+ * linked into the kernel (student-distrib/data/). See Makefile for usage.
+ *
+ * Formats, matching the decoders in student-distrib/lib/decompress.c:
+ *  - lzss16: array of 16 bit values, stored little endian and LZSS encoded.
+ *    Each flag byte describes the next 8 items, LSB first, 1 = literal byte,
+ *    0 = match of 2 bytes: 12 bit (distance - 1), 4 bit (length - 3).
+ *  - glyph16x16: array of bytes, 32 per 16x16 glyph. Blank, unused and
+ *    duplicate glyphs are dropped; a table of font_run_t {first code point,
+ *    count, first stored glyph} maps code points to the stored glyphs. Each
+ *    byte is XORed with the byte one row above in the same glyph, then
+ *    Huffman encoded, with separate canonical codes for left and right
+ *    halves of a row. Bit offset of every GLYPH_BLOCK'th stored glyph is
+ *    kept for random access.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#define LZSS_WINDOW_SIZE 4096
+#define LZSS_MIN_MATCH 3
+#define LZSS_MAX_MATCH 18
+#define LZSS_HASH_SIZE 65536
+#define LZSS_MAX_CHAIN 256
+
+#define GLYPH_SIZE 32
+#define GLYPH_ROW_SIZE 2
+#define GLYPH_BLOCK 16
+#define HUFFMAN_MAX_LEN 16
+#define HUFFMAN_SYMBOLS 256
+
+#define GLYPH_HASH_SIZE 65536
+#define CODE_POINTS 65536
+
+#define LINE_ITEMS 16
+
+/* Growable byte buffer */
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+} buffer_t;
+
+static void buffer_push(buffer_t* b, uint8_t v) {
+    if(b->len == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 4096;
+        b->data = realloc(b->data, b->cap);
+        if(NULL == b->data) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    b->data[b->len++] = v;
+}
+
+/* int read_array(const char* path, buffer_t* out, int width)
+ * @input: path - C source containing a numeric array
+ *         width - bytes per value, 1 or 2
+ * @output: out - values appended little endian
+ *          ret val - 0 on success, -1 on failure
+ * @description: pulls every number out of the file, ignoring comments and
+ *     anything before the first '{' if there is one, so both the raw
+ *     notebook output and a full C array definition work.
+ */
+static int read_array(const char* path, buffer_t* out, int width) {
+    FILE* f = fopen(path, "r");
+    if(NULL == f) {
+        perror(path);
+        return -1;
+    }
+    buffer_t text = {0};
+    int c;
+    while(EOF != (c = fgetc(f))) buffer_push(&text, (uint8_t) c);
+    buffer_push(&text, '\0');
+    fclose(f);
+
+    char* p = (char*) text.data;
+    char* brace = strchr(p, '{');
+    if(brace) p = brace + 1;
+    while(*p && *p != '}') {
+        if(p[0] == '/' && p[1] == '/') {
+            while(*p && *p != '\n') p++;
+        } else if(p[0] == '/' && p[1] == '*') {
+            char* end = strstr(p + 2, "*/");
+            p = end ? end + 2 : p + strlen(p);
+        } else if(isdigit((unsigned char) *p)) {
+            char* end;
+            unsigned long v = strtoul(p, &end, 0);
+            if(width == 1) {
+                buffer_push(out, (uint8_t) v);
+            } else {
+                buffer_push(out, (uint8_t) v);
+                buffer_push(out, (uint8_t) (v >> 8));
+            }
+            p = end;
+            while(*p == 'u' || *p == 'U') p++;
+        } else {
+            p++;
+        }
+    }
+    free(text.data);
+    return 0;
+}
+
+/* void lzss_encode(const buffer_t* in, buffer_t* out)
+ * @input: in - data to be compressed
+ * @output: out - LZSS stream
+ * @description: greedy LZSS with hash chains on 3 byte prefixes.
+ */
+static void lzss_encode(const buffer_t* in, buffer_t* out) {
+    int32_t* head = malloc(sizeof(int32_t) * LZSS_HASH_SIZE);
+    int32_t* prev = malloc(sizeof(int32_t) * (in->len + 1));
+    size_t i = 0, flag_pos = 0;
+    int items = 8;
+    memset(head, -1, sizeof(int32_t) * LZSS_HASH_SIZE);
+
+    while(i < in->len) {
+        if(items == 8) {
+            flag_pos = out->len;
+            buffer_push(out, 0);
+            items = 0;
+        }
+
+        size_t best_len = 0, best_dist = 0;
+        uint32_t hash = 0;
+        if(i + LZSS_MIN_MATCH <= in->len) {
+            hash = (in->data[i] << 8 ^ in->data[i + 1] << 4 ^ in->data[i + 2]) % LZSS_HASH_SIZE;
+            int32_t cand = head[hash];
+            int chain = 0;
+            while(cand >= 0 && i - cand <= LZSS_WINDOW_SIZE && chain++ < LZSS_MAX_CHAIN) {
+                size_t len = 0;
+                while(len < LZSS_MAX_MATCH && i + len < in->len
+                    && in->data[cand + len] == in->data[i + len]) len++;
+                if(len > best_len) {
+                    best_len = len;
+                    best_dist = i - cand;
+                    if(len == LZSS_MAX_MATCH) break;
+                }
+                cand = prev[cand];
+            }
+        }
+
+        size_t step = best_len >= LZSS_MIN_MATCH ? best_len : 1;
+        if(best_len >= LZSS_MIN_MATCH) {
+            buffer_push(out, (uint8_t) (best_dist - 1));
+            buffer_push(out, (uint8_t) (((best_dist - 1) >> 8) << 4 | (best_len - LZSS_MIN_MATCH)));
+        } else {
+            out->data[flag_pos] |= 1 << items;
+            buffer_push(out, in->data[i]);
+        }
+        items++;
+
+        // Insert every covered position into the hash chains
+        while(step--) {
+            if(i + LZSS_MIN_MATCH <= in->len) {
+                hash = (in->data[i] << 8 ^ in->data[i + 1] << 4 ^ in->data[i + 2]) % LZSS_HASH_SIZE;
+                prev[i] = head[hash];
+                head[hash] = i;
+            }
+            i++;
+        }
+    }
+    free(head);
+    free(prev);
+}
+
+/* void huffman_lengths(const uint32_t* freq, uint8_t* len)
+ * @input: freq - frequency of each of the 256 symbols
+ * @output: len - code length of each symbol, 0 if unused,
+ *                no longer than HUFFMAN_MAX_LEN
+ * @description: plain Huffman construction; if the tree gets too deep,
+ *     frequencies are flattened and the tree rebuilt.
+ */
+static void huffman_lengths(const uint32_t* freq, uint8_t* len) {
+    uint32_t f[HUFFMAN_SYMBOLS];
+    memcpy(f, freq, sizeof(f));
+    while(1) {
+        uint64_t weight[HUFFMAN_SYMBOLS * 2];
+        int parent[HUFFMAN_SYMBOLS * 2];
+        int alive[HUFFMAN_SYMBOLS * 2];
+        int nodes = 0, used = 0, i;
+        for(i = 0; i < HUFFMAN_SYMBOLS; i++) {
+            weight[nodes] = f[i];
+            parent[nodes] = -1;
+            alive[nodes] = f[i] > 0;
+            used += f[i] > 0;
+            nodes++;
+        }
+        memset(len, 0, HUFFMAN_SYMBOLS);
+        if(used == 1) {
+            for(i = 0; i < HUFFMAN_SYMBOLS; i++) if(f[i]) len[i] = 1;
+            return;
+        }
+        while(1) {
+            int a = -1, b = -1;
+            for(i = 0; i < nodes; i++) {
+                if(!alive[i]) continue;
+                if(a < 0 || weight[i] < weight[a]) {
+                    b = a;
+                    a = i;
+                } else if(b < 0 || weight[i] < weight[b]) {
+                    b = i;
+                }
+            }
+            if(b < 0) break;
+            weight[nodes] = weight[a] + weight[b];
+            parent[nodes] = -1;
+            alive[nodes] = 1;
+            parent[a] = parent[b] = nodes;
+            alive[a] = alive[b] = 0;
+            nodes++;
+        }
+        int max = 0;
+        for(i = 0; i < HUFFMAN_SYMBOLS; i++) {
+            if(!f[i]) continue;
+            int depth = 0, n = i;
+            while(parent[n] >= 0) {
+                n = parent[n];
+                depth++;
+            }
+            len[i] = depth;
+            if(depth > max) max = depth;
+        }
+        if(max <= HUFFMAN_MAX_LEN) return;
+        for(i = 0; i < HUFFMAN_SYMBOLS; i++) if(f[i]) f[i] = (f[i] + 1) / 2;
+    }
+}
+
+/* Canonical Huffman code, as seen by the kernel decoder */
+typedef struct {
+    uint16_t count[HUFFMAN_MAX_LEN + 1];
+    uint8_t symbol[HUFFMAN_SYMBOLS];
+    uint8_t len[HUFFMAN_SYMBOLS];
+    uint16_t code[HUFFMAN_SYMBOLS];
+} huffman_t;
+
+static void huffman_build(const uint32_t* freq, huffman_t* h) {
+    uint16_t next[HUFFMAN_MAX_LEN + 1];
+    int i, l, n = 0;
+    uint16_t code = 0;
+    memset(h, 0, sizeof(*h));
+    huffman_lengths(freq, h->len);
+    for(i = 0; i < HUFFMAN_SYMBOLS; i++) h->count[h->len[i]]++;
+    h->count[0] = 0;
+    for(l = 1; l <= HUFFMAN_MAX_LEN; l++) {
+        code = (code + h->count[l - 1]) << 1;
+        next[l] = code;
+    }
+    for(l = 1; l <= HUFFMAN_MAX_LEN; l++) {
+        for(i = 0; i < HUFFMAN_SYMBOLS; i++) {
+            if(h->len[i] != l) continue;
+            h->symbol[n++] = i;
+            h->code[i] = next[l]++;
+        }
+    }
+}
+
+/* MSB first bit writer */
+typedef struct {
+    buffer_t* out;
+    uint32_t bits;
+    uint8_t acc;
+    int fill;
+} bit_writer_t;
+
+static void bits_put(bit_writer_t* w, uint16_t code, int len) {
+    while(len--) {
+        w->acc = w->acc << 1 | ((code >> len) & 1);
+        w->bits++;
+        if(++w->fill == 8) {
+            buffer_push(w->out, w->acc);
+            w->acc = 0;
+            w->fill = 0;
+        }
+    }
+}
+
+static void bits_flush(bit_writer_t* w) {
+    if(w->fill) buffer_push(w->out, w->acc << (8 - w->fill));
+    w->acc = 0;
+    w->fill = 0;
+}
+
+/* uint8_t glyph_filtered(const buffer_t* in, size_t i)
+ * @description: byte i of the font, XORed with the same byte one row above
+ */
+static uint8_t glyph_filtered(const buffer_t* in, size_t i) {
+    if(i % GLYPH_SIZE < GLYPH_ROW_SIZE) return in->data[i];
+    return in->data[i] ^ in->data[i - GLYPH_ROW_SIZE];
+}
+
+static void write_bytes(FILE* f, const char* type, const char* name, const uint8_t* data, size_t len) {
+    size_t i;
+    fprintf(f, "const %s %s[%lu] = {\n", type, name, (unsigned long) len);
+    for(i = 0; i < len; i++) {
+        if(i % LINE_ITEMS == 0) fprintf(f, "    ");
+        fprintf(f, "0x%02x,", data[i]);
+        if(i % LINE_ITEMS == LINE_ITEMS - 1 || i == len - 1) fprintf(f, "\n");
+    }
+    fprintf(f, "};\n\n");
+}
+
+static void write_header(FILE* f, const char* in, const char* header) {
+    fprintf(f, "/* Generated by helpers/assetenc from %s, do not edit. */\n", in);
+    fprintf(f, "#include \"%s\"\n\n", header);
+}
+
+static int encode_lzss16(const char* in, const char* out, const char* header, const char* name) {
+    buffer_t raw = {0}, enc = {0};
+    char sym[256];
+    if(read_array(in, &raw, 2)) return -1;
+    lzss_encode(&raw, &enc);
+
+    FILE* f = fopen(out, "w");
+    if(NULL == f) {
+        perror(out);
+        return -1;
+    }
+    write_header(f, in, header);
+    fprintf(f, "const uint32_t %s_LZSS_SIZE = %lu;\n\n", name, (unsigned long) enc.len);
+    snprintf(sym, sizeof(sym), "%s_LZSS", name);
+    write_bytes(f, "uint8_t", sym, enc.data, enc.len);
+    fclose(f);
+    fprintf(stderr, "%s: %lu -> %lu bytes\n", out, (unsigned long) raw.len, (unsigned long) enc.len);
+    return 0;
+}
+
+/* int read_used(const char* path, uint8_t* used)
+ * @input: path - file naming characters that may be displayed
+ * @output: used - flag set for every such code point
+ *          ret val - 0 on success, -1 on failure
+ * @description: picks up both UTF-8 encoded characters in text files
+ *     and 0xXXXX code point literals in C tables (like the pinyin table).
+ */
+static int read_used(const char* path, uint8_t* used) {
+    FILE* f = fopen(path, "r");
+    if(NULL == f) {
+        perror(path);
+        return -1;
+    }
+    buffer_t text = {0};
+    int c;
+    while(EOF != (c = fgetc(f))) buffer_push(&text, (uint8_t) c);
+    buffer_push(&text, '\0');
+    fclose(f);
+
+    uint8_t* p = text.data;
+    while(*p) {
+        if((p[0] & 0xf0) == 0xe0 && (p[1] & 0xc0) == 0x80 && (p[2] & 0xc0) == 0x80) {
+            used[(p[0] & 0xf) << 12 | (p[1] & 0x3f) << 6 | (p[2] & 0x3f)] = 1;
+            p += 3;
+        } else if(p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && isxdigit(p[2])
+            && isxdigit(p[3]) && isxdigit(p[4]) && isxdigit(p[5]) && !isxdigit(p[6])) {
+            used[strtoul((char*) p, NULL, 16)] = 1;
+            p += 6;
+        } else {
+            p++;
+        }
+    }
+    free(text.data);
+    return 0;
+}
+
+/* int encode_glyph16x16(...)
+ * @input: in - raw font, 32 bytes per glyph for consecutive code points
+ *         first_code - code point of the first glyph
+ *         used_files, used_count - files naming the characters to keep,
+ *                                  all are kept if there are none
+ * @description: only keeps glyphs that are drawn (not blank) and used,
+ *     stores identical glyphs once, and writes a table of runs mapping
+ *     consecutive code points to consecutive stored glyphs.
+ */
+static int encode_glyph16x16(const char* in, const char* out, const char* header, const char* name,
+                             uint32_t first_code, char** used_files, int used_count) {
+    buffer_t raw = {0}, kept = {0}, enc = {0};
+    uint32_t freq[GLYPH_ROW_SIZE][HUFFMAN_SYMBOLS];
+    huffman_t h[GLYPH_ROW_SIZE];
+    bit_writer_t w = {&enc, 0, 0, 0};
+    char sym[256];
+    size_t i, j, glyphs, slots = 0, runs = 0;
+    int t;
+    static uint8_t used[CODE_POINTS];
+    static int32_t hash_head[GLYPH_HASH_SIZE];
+
+    if(read_array(in, &raw, 1)) return -1;
+    if(raw.len % GLYPH_SIZE) {
+        fprintf(stderr, "%s: size not a multiple of %d\n", in, GLYPH_SIZE);
+        return -1;
+    }
+    glyphs = raw.len / GLYPH_SIZE;
+
+    memset(used, used_count ? 0 : 1, sizeof(used));
+    for(t = 0; t < used_count; t++) {
+        if(read_used(used_files[t], used)) return -1;
+    }
+
+    // Pick the glyphs to store, and build runs of code point -> stored glyph
+    uint32_t* slot_of = malloc(sizeof(uint32_t) * glyphs);
+    int32_t* hash_next = malloc(sizeof(int32_t) * glyphs);
+    uint16_t (*run)[3] = malloc(sizeof(*run) * glyphs);
+    memset(hash_head, -1, sizeof(hash_head));
+    for(i = 0; i < glyphs; i++) {
+        const uint8_t* g = raw.data + i * GLYPH_SIZE;
+        uint32_t hash = 2166136261u;
+        int blank = 1;
+        slot_of[i] = UINT32_MAX;
+        for(j = 0; j < GLYPH_SIZE; j++) {
+            hash = (hash ^ g[j]) * 16777619u;
+            if(g[j]) blank = 0;
+        }
+        if(blank || first_code + i >= CODE_POINTS || !used[first_code + i]) continue;
+
+        int32_t other;
+        for(other = hash_head[hash % GLYPH_HASH_SIZE]; other >= 0; other = hash_next[other]) {
+            if(0 == memcmp(kept.data + slot_of[other] * GLYPH_SIZE, g, GLYPH_SIZE)) break;
+        }
+        if(other >= 0) {
+            slot_of[i] = slot_of[other];
+        } else {
+            slot_of[i] = slots++;
+            for(j = 0; j < GLYPH_SIZE; j++) buffer_push(&kept, g[j]);
+            hash_next[i] = hash_head[hash % GLYPH_HASH_SIZE];
+            hash_head[hash % GLYPH_HASH_SIZE] = i;
+        }
+
+        if(runs > 0 && run[runs - 1][0] + run[runs - 1][1] == first_code + i
+            && run[runs - 1][2] + run[runs - 1][1] == slot_of[i]) {
+            run[runs - 1][1]++;
+        } else {
+            run[runs][0] = first_code + i;
+            run[runs][1] = 1;
+            run[runs][2] = slot_of[i];
+            runs++;
+        }
+    }
+
+    memset(freq, 0, sizeof(freq));
+    for(i = 0; i < kept.len; i++) freq[i % GLYPH_ROW_SIZE][glyph_filtered(&kept, i)]++;
+    for(t = 0; t < GLYPH_ROW_SIZE; t++) huffman_build(freq[t], &h[t]);
+
+    uint32_t* block = malloc(sizeof(uint32_t) * (slots / GLYPH_BLOCK + 1));
+    for(i = 0; i < kept.len; i++) {
+        if(i % (GLYPH_SIZE * GLYPH_BLOCK) == 0) block[i / (GLYPH_SIZE * GLYPH_BLOCK)] = w.bits;
+        uint8_t v = glyph_filtered(&kept, i);
+        bits_put(&w, h[i % GLYPH_ROW_SIZE].code[v], h[i % GLYPH_ROW_SIZE].len[v]);
+    }
+    bits_flush(&w);
+
+    FILE* f = fopen(out, "w");
+    if(NULL == f) {
+        perror(out);
+        return -1;
+    }
+    write_header(f, in, header);
+    fprintf(f, "const uint32_t %s_RUN_COUNT = %lu;\n\n", name, (unsigned long) runs);
+    fprintf(f, "const font_run_t %s_RUNS[%lu] = {\n", name, (unsigned long) runs);
+    for(i = 0; i < runs; i++) {
+        fprintf(f, "    {0x%04x, %u, %u},\n", run[i][0], run[i][1], run[i][2]);
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "const uint16_t %s_HUFFMAN_COUNT[%d][%d] = {\n", name, GLYPH_ROW_SIZE, HUFFMAN_MAX_LEN + 1);
+    for(t = 0; t < GLYPH_ROW_SIZE; t++) {
+        fprintf(f, "    {");
+        for(i = 0; i <= HUFFMAN_MAX_LEN; i++) fprintf(f, "%u,", h[t].count[i]);
+        fprintf(f, "},\n");
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "const uint8_t %s_HUFFMAN_SYMBOL[%d][%d] = {\n", name, GLYPH_ROW_SIZE, HUFFMAN_SYMBOLS);
+    for(t = 0; t < GLYPH_ROW_SIZE; t++) {
+        fprintf(f, "    {");
+        for(i = 0; i < HUFFMAN_SYMBOLS; i++) {
+            if(i % LINE_ITEMS == 0) fprintf(f, "\n        ");
+            fprintf(f, "0x%02x,", h[t].symbol[i]);
+        }
+        fprintf(f, "\n    },\n");
+    }
+    fprintf(f, "};\n\n");
+    fprintf(f, "const uint32_t %s_BLOCK_OFFSET[%lu] = {\n", name,
+        (unsigned long) ((slots + GLYPH_BLOCK - 1) / GLYPH_BLOCK));
+    for(i = 0; i < (slots + GLYPH_BLOCK - 1) / GLYPH_BLOCK; i++) {
+        if(i % 8 == 0) fprintf(f, "    ");
+        fprintf(f, "%u,", block[i]);
+        if(i % 8 == 7) fprintf(f, "\n");
+    }
+    fprintf(f, "\n};\n\n");
+    snprintf(sym, sizeof(sym), "%s_STREAM", name);
+    write_bytes(f, "uint8_t", sym, enc.data, enc.len);
+    fclose(f);
+    fprintf(stderr, "%s: %lu glyphs, %lu stored, %lu runs, %lu -> %lu bytes\n", out,
+        (unsigned long) glyphs, (unsigned long) slots, (unsigned long) runs, (unsigned long) raw.len,
+        (unsigned long) (enc.len + ((slots + GLYPH_BLOCK - 1) / GLYPH_BLOCK) * 4 + runs * 6));
+    free(block);
+    free(slot_of);
+    free(hash_next);
+    free(run);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if(argc == 6 && 0 == strcmp(argv[1], "lzss16")) {
+        return encode_lzss16(argv[2], argv[3], argv[4], argv[5]) ? 1 : 0;
+    } else if(argc >= 7 && 0 == strcmp(argv[1], "glyph16x16")) {
+        return encode_glyph16x16(argv[2], argv[3], argv[4], argv[5],
+            strtoul(argv[6], NULL, 0), argv + 7, argc - 7) ? 1 : 0;
+    } else if(argc < 6) {
+        fprintf(stderr, "usage: %s lzss16 input.c output.c header.h SYMBOL\n", argv[0]);
+        fprintf(stderr, "       %s glyph16x16 input.c output.c header.h SYMBOL "
+            "first_code [used_chars_file...]\n", argv[0]);
+        return 1;
+    }
+    fprintf(stderr, "unknown format %s\n", argv[1]);
+    return 1;
+}
@@ -5,6 +5,13 @@
 
 /* All calls return >= 0 on success or -1 on failure. */
 
+/* One cell update for ece391_poke_batch; data is the same as ece391_poke. */
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint16_t data;
+} ece391_poke_t;
+
 /*
  * Note that the system call for halt will have to make sure that only
  * the low byte of EBX (the status argument) is returned to the calling
@@ -27,6 +34,9 @@ extern int32_t ece391_reboot (void);
 extern int32_t ece391_ps (void);
 extern int32_t ece391_poke (uint32_t x, uint32_t y, uint32_t data);
 extern int32_t ece391_status_msg (char* msg, uint32_t len, uint8_t attr);
+extern int32_t ece391_poke_batch (const ece391_poke_t* pokes, uint32_t count);
+/* pos is x | (y << 16), size is width | (height << 16) */
+extern int32_t ece391_blit (const uint16_t* cells, uint32_t pos, uint32_t size);
 
 enum signums {
 	DIV_ZERO = 0,
@@ -17,5 +17,7 @@
 #define SYS_PS 14
 #define SYS_POKE 15
 #define SYS_STATUS_MSG 16
+#define SYS_POKE_BATCH 17
+#define SYS_BLIT 18
 
 #endif /* ECE391SYSNUM_H */
@@ -14,12 +14,19 @@ extern void init_screen();
 extern void write_char(char, int x, int y);
 extern void write_string(char*, int x, int y);
 extern void clear_screen();
+extern void flush_screen();
 
 /* Static data */
 int rtc_fd = -1;		// RTC file descriptor
 int rng_fd = -1;		// RNG file descriptor
 int tux_fd = -1;		// Tux Controller file descriptor
 int mouse_fd = -1;		// Mouse file descriptor
+int vga_fd = -1;		// QEMU VGA double buffer file descriptor
+
+/* ioctl ops of the vga device */
+#define VGA_DOUBLE_BUFFER_ON	1
+#define VGA_PRESENT		3
+#define VGA_GET_FPS		4
 
 int fired = 0;		/* Count of user-fired missiles */
 int score = 0;		/* score, as reported by ioctl(GETSTATUS) */
@@ -206,8 +213,10 @@ void draw_starting_screen(){
 }
 
 void draw_status_bar(){
-	char buf[80] = "[score    ] [fired    ] [accuracy    %]";
+	char buf[80] = "[score    ] [fired    ] [accuracy    %] [fps   ]";
 	int percent = fired ? (100*score)/fired : 0;
+	int fps = vga_fd >= 0 ? ece391_ioctl(vga_fd, VGA_GET_FPS) : 0;
+	if(fps < 0) fps = 0;
 
 	ece391_itoa(score, (uint8_t*) (buf + (score >= 100 ? 7 : (score >= 10 ? 8 : 9))), 10);
 	buf[10] = ']';
@@ -215,6 +224,8 @@ void draw_status_bar(){
 	buf[22] = ']';
 	ece391_itoa(percent, (uint8_t*) (buf + (percent >= 100 ? 34 : (percent >= 10 ? 35 : 36))), 10);
 	buf[37] = '%';
+	ece391_itoa(fps, (uint8_t*) (buf + (fps >= 100 ? 44 : (fps >= 10 ? 45 : 46))), 10);
+	buf[47] = ']';
 
 	ece391_status_msg(buf, 80, 0x02);
 	// write_string(buf, 0, 0);
@@ -244,11 +255,18 @@ int main(){
 	rtc_fd = ece391_open((uint8_t*) "rtc");
 	tux_fd = ece391_open((uint8_t*) "tux");
 	mouse_fd = ece391_open((uint8_t*) "mouse");
+	vga_fd = ece391_open((uint8_t*) "vga");
+	if(vga_fd >= 0 && -1 == ece391_ioctl(vga_fd, VGA_DOUBLE_BUFFER_ON)) {
+		ece391_close(vga_fd);
+		vga_fd = -1;
+	}
 	int rtc_interval = 32;
 	ece391_write(rtc_fd, &rtc_interval, sizeof(int));
 
 	/* On with the game! */
 	draw_starting_screen();
+	flush_screen();
+	if(vga_fd >= 0) ece391_ioctl(vga_fd, VGA_PRESENT);
 	int16_t dx = 0, dy = 0;
 	while(FIRE != get_command(&dx, &dy));
 	clear_screen();
@@ -259,6 +277,8 @@ int main(){
 		draw_status_bar();
 		update_crosshairs(cmd, dx, dy);
 		mp1_rtc_tasklet();
+		flush_screen();
+		if(vga_fd >= 0) ece391_ioctl(vga_fd, VGA_PRESENT);
 		ece391_read(rtc_fd, (void*) 0, 0);
 
 		if(rand() % 127 == 0) {
@@ -269,11 +289,14 @@ int main(){
 	draw_centered_string("+------------+", (25/2)-1);
 	draw_centered_string("| Game over. |",  25/2);
 	draw_centered_string("+------------+", (25/2)+1);
+	flush_screen();
 
 	ece391_close(rng_fd);
 	ece391_close(rtc_fd);
 	ece391_close(tux_fd);
 	ece391_close(mouse_fd);
+	/* Closing vga presents the last frame and turns double buffering off */
+	if(vga_fd >= 0) ece391_close(vga_fd);
 
 	return 0;
 }
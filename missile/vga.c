@@ -1,35 +1,60 @@
-
 /* vga.c
  * A small set of functions to interface (from userspace) to the VGA in
  * text-mode.
  * Mark Murphy 2007
+ *
+ * Cell writes are queued and sent to the kernel in one batch by
+ * flush_screen(), instead of one poke system call per cell.
  */
 
 #include <stdint.h>
 #include "ece391support.h"
 #include "ece391syscall.h"
 
+#define SCREEN_COLS 80
+#define SCREEN_ROWS 25
+#define POKE_QUEUE_LEN 512
+
+static ece391_poke_t poke_queue[POKE_QUEUE_LEN];
+static uint32_t poke_queue_len = 0;
+static uint16_t blank_screen[SCREEN_COLS * SCREEN_ROWS];
+
+void flush_screen(){
+	if(poke_queue_len == 0) return;
+	ece391_poke_batch(poke_queue, poke_queue_len);
+	poke_queue_len = 0;
+}
+
+static void queue_poke(int x, int y, uint16_t data){
+	if(poke_queue_len == POKE_QUEUE_LEN) flush_screen();
+	poke_queue[poke_queue_len].x = x;
+	poke_queue[poke_queue_len].y = y;
+	poke_queue[poke_queue_len].data = data;
+	poke_queue_len++;
+}
+
 void mp1_poke_helper(int pos, int data) {
-	ece391_poke((pos / 2) % 80, (pos / 2) / 80, data);
+	queue_poke((pos / 2) % SCREEN_COLS, (pos / 2) / SCREEN_COLS, data);
 }
 
 void clear_screen(){
-	int x, y;
-	for(x = 0; x < 80; x++){
-		for(y = 0; y < 25; y++) {
-			ece391_poke(x, y, 0x720);
-		}
+	int i;
+	/* Anything still queued would land on top of the cleared screen */
+	poke_queue_len = 0;
+	for(i = 0; i < SCREEN_COLS * SCREEN_ROWS; i++) {
+		blank_screen[i] = 0x720;
 	}
+	ece391_blit(blank_screen, 0, SCREEN_COLS | (SCREEN_ROWS << 16));
 }
 
 void write_char(char c, int x, int y){
-	ece391_poke(x, y, (uint32_t) (0x700 | c));
+	queue_poke(x, y, (uint16_t) (0x700 | (uint8_t) c));
 }
 
 void write_string(char *s, int x, int y){
 	while(*s){
-		ece391_poke(x, y, (uint32_t) (0x700 | (*s++)));
+		queue_poke(x, y, (uint16_t) (0x700 | (uint8_t) (*s++)));
 		x++;
-		if(x >= 80) { x = 0; y++; }
+		if(x >= SCREEN_COLS) { x = 0; y++; }
 	}
 }
@@ -10,6 +10,25 @@
 #define CHINESE_ENCODE_START 0x4e00
 #define CHINESE_ENCODE_END 0x9fa5
 
-extern uint8_t CHINESE_FONT_DATA[];
+// Compressed font, generated by helpers/assetenc
+#define CHINESE_FONT_GLYPH_SIZE (CHINESE_FONT_WIDTH * CHINESE_FONT_HEIGHT / 8)
+#define CHINESE_FONT_ROW_SIZE (CHINESE_FONT_WIDTH / 8)
+#define CHINESE_FONT_BLOCK 16
+#define CHINESE_FONT_HUFFMAN_LEN 16
+#define CHINESE_FONT_HUFFMAN_SYMBOLS 256
+
+// Consecutive characters stored as consecutive glyphs
+typedef struct {
+    uint16_t code;      // First character in run
+    uint16_t count;     // Number of characters in run
+    uint16_t glyph;     // Index of glyph of first character
+} font_run_t;
+
+extern const uint32_t CHINESE_FONT_RUN_COUNT;
+extern const font_run_t CHINESE_FONT_RUNS[];
+extern const uint16_t CHINESE_FONT_HUFFMAN_COUNT[CHINESE_FONT_ROW_SIZE][CHINESE_FONT_HUFFMAN_LEN + 1];
+extern const uint8_t CHINESE_FONT_HUFFMAN_SYMBOL[CHINESE_FONT_ROW_SIZE][CHINESE_FONT_HUFFMAN_SYMBOLS];
+extern const uint32_t CHINESE_FONT_BLOCK_OFFSET[];
+extern const uint8_t CHINESE_FONT_STREAM[];
 
 #endif
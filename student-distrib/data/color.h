@@ -4,6 +4,14 @@
 #include "../lib/lib.h"
 #include "../devices/qemu_vga.h"
 
+// Palette mode, VGA DAC is loaded with terminal_color_32
+static vga_color_t terminal_color_8[16] = {
+    {0x00}, {0x01}, {0x02}, {0x03},
+    {0x04}, {0x05}, {0x06}, {0x07},
+    {0x08}, {0x09}, {0x0a}, {0x0b},
+    {0x0c}, {0x0d}, {0x0e}, {0x0f}
+};
+
 static vga_color_t terminal_color_16[16] = {
     {0x0000}, {0x0015}, {0x0540}, {0x0555},
     {0xa800}, {0xa815}, {0xaaa0}, {0xad55},
@@ -5,6 +5,8 @@
 
 #define UIUC_IMAGE_WIDTH 720
 #define UIUC_IMAGE_HEIGHT 200
-extern const uint16_t UIUC_IMAGE_DATA[720 * 200];
+// LZSS compressed 16 bit image, generated by helpers/assetenc
+extern const uint32_t UIUC_IMAGE_LZSS_SIZE;
+extern const uint8_t UIUC_IMAGE_LZSS[];
 
 #endif
@@ -0,0 +1,163 @@
+#include "clock.h"
+#include "cpuid.h"
+#include "cmos.h"
+#include "pit.h"
+#include "../interrupts/multiprocessing.h"
+
+// TSC frequency, 0 if TSC isn't used and time comes from PIT ticks
+uint32_t clock_tsc_khz = 0;
+
+// Nanoseconds per cycle << CLOCK_MULT_SHIFT
+static uint32_t clock_mult = 0;
+// TSC and pit_timer when clock_init ran, start of monotonic time
+static uint64_t clock_tsc_base = 0;
+static uint32_t clock_pit_base = 0;
+// CLOCK_REALTIME at clock_init, in seconds
+static uint32_t clock_boot_sec = 0;
+
+// A whole page, so nothing else of the kernel is visible to user programs
+static uint8_t clock_page_mem[PAGE_SIZE_4KB] __attribute__((aligned (PAGE_SIZE_4KB)));
+clock_page_t* clock_page = (clock_page_t*) clock_page_mem;
+// TSC when the kernel started, 0 if unknown
+static uint64_t clock_boot_tsc = 0;
+
+/* uint32_t clock_days_from_civil(uint32_t year, uint32_t month, uint32_t day)
+ * @input: year, month, day - a date from 1970 on
+ * @output: ret val - days since 1970-01-01
+ * @description: counts in 400 year eras starting from March,
+ *     so the leap day comes last.
+ */
+static uint32_t clock_days_from_civil(uint32_t year, uint32_t month, uint32_t day) {
+    if(month <= 2) year--;
+    uint32_t era = year / 400;
+    uint32_t year_of_era = year - era * 400;
+    uint32_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+/* uint32_t clock_calibrate()
+ * @output: ret val - TSC cycles in CLOCK_CALIBRATE_NS, 0 if it can't be measured
+ * @description: counts PIT channel 2 down once with speaker off,
+ *     waiting for its output with interrupts off.
+ */
+static uint32_t clock_calibrate() {
+    uint8_t gate = inb(CLOCK_PIT_GATE);
+    uint32_t polls = CLOCK_CALIBRATE_POLLS;
+    outb((gate & ~CLOCK_GATE_SPEAKER) | CLOCK_GATE_ON, CLOCK_PIT_GATE);
+    outb(CLOCK_PIT_CH2_MODE, CLOCK_PIT_CMD);
+    outb((uint8_t) CLOCK_CALIBRATE_COUNT, CLOCK_PIT_CH2);
+    outb((uint8_t) (CLOCK_CALIBRATE_COUNT >> 8), CLOCK_PIT_CH2);
+
+    uint64_t start = rdtsc();
+    while(!(inb(CLOCK_PIT_GATE) & CLOCK_GATE_OUT) && --polls);
+    uint64_t end = rdtsc();
+    outb(gate, CLOCK_PIT_GATE);
+
+    if(0 == polls || end - start > 0xffffffff) return 0;
+    return end - start;
+}
+
+/* void clock_init()
+ * @output: TSC frequency measured, realtime clock set from CMOS
+ * @description: must run after cpuid_init and acpi_init, with interrupts off.
+ *     Without a usable TSC, clocks count PIT ticks instead.
+ */
+void clock_init() {
+    uint32_t flags;
+    cli_and_save(flags);
+    if(cpu_info.features.tsc) {
+        uint32_t cycles = clock_calibrate();
+        // Faster than 4 MHz, so the multiplier fits 32 bits
+        if(cycles > (CLOCK_CALIBRATE_NS >> (32 - CLOCK_MULT_SHIFT))) {
+            clock_mult = div64_32((uint64_t) CLOCK_CALIBRATE_NS << CLOCK_MULT_SHIFT, cycles, NULL);
+            clock_tsc_khz = cycles / (CLOCK_CALIBRATE_NS / (NS_IN_S / MS_IN_S));
+        }
+    }
+
+    datetime_t now = cmos_datetime();
+    clock_boot_sec = clock_days_from_civil(now.year, now.month, now.day) * SECONDS_PER_DAY
+        + now.hour * 3600 + now.minute * 60 + now.second;
+    clock_tsc_base = clock_tsc_khz ? rdtsc() : 0;
+    clock_pit_base = pit_timer;
+
+    clock_page->pit_base = clock_pit_base;
+    clock_page->ns_per_tick = NS_PER_TICK;
+    clock_page->tsc_base = clock_tsc_base;
+    clock_page->tsc_mult = clock_tsc_khz ? clock_mult : 0;
+    clock_page->tsc_shift = CLOCK_MULT_SHIFT;
+    clock_page->tsc_khz = clock_tsc_khz;
+    clock_page->boot_sec = clock_boot_sec;
+    clock_page_update();
+    restore_flags(flags);
+}
+
+/* void clock_mark_boot()
+ * @output: TSC saved as the time the kernel started
+ * @description: called first thing in entry, after cpuid_init.
+ */
+void clock_mark_boot() {
+    if(cpu_info.features.tsc) clock_boot_tsc = rdtsc();
+}
+
+/* int32_t clock_boot_ms()
+ * @output: ret val - ms since clock_mark_boot, FAIL without a usable TSC
+ * @description: covers kernel init, unlike pit_timer, which only counts
+ *     once interrupts are enabled.
+ */
+int32_t clock_boot_ms() {
+    if(0 == clock_tsc_khz || 0 == clock_boot_tsc) return FAIL;
+    return div64_32(rdtsc() - clock_boot_tsc, clock_tsc_khz, NULL);
+}
+
+/* void clock_page_update()
+ * @output: ticks and terminal state on the time page refreshed
+ * @description: called on PIT ticks, short enough for the interrupt handler.
+ */
+void clock_page_update() {
+    uint32_t flags;
+    int32_t tid;
+    cli_and_save(flags);
+    clock_page->seq++;
+    asm volatile("" : : : "memory");
+    clock_page->ticks = pit_timer;
+    clock_page->displayed_terminal = displayed_terminal_id;
+    for(tid = 0; tid < CLOCK_PAGE_TERMINALS && tid < TERMINAL_COUNT; tid++) {
+        clock_page->terminals[tid].active_process = terminals[tid].active_process;
+        clock_page->terminals[tid].screen_x = terminals[tid].screen_x;
+        clock_page->terminals[tid].screen_y = terminals[tid].screen_y;
+    }
+    asm volatile("" : : : "memory");
+    clock_page->seq++;
+    restore_flags(flags);
+}
+
+/* uint64_t clock_monotonic_ns()
+ * @output: ret val - nanoseconds since clock_init
+ * @description: cycles * mult is split into 32 bit halves,
+ *     so it doesn't overflow 64 bits.
+ */
+uint64_t clock_monotonic_ns() {
+    if(0 == clock_tsc_khz) return (uint64_t) (pit_timer - clock_pit_base) * NS_PER_TICK;
+    uint64_t cycles = rdtsc() - clock_tsc_base;
+    uint32_t high = cycles >> 32;
+    uint32_t low = cycles;
+    return (((uint64_t) high * clock_mult) << (32 - CLOCK_MULT_SHIFT))
+        + (((uint64_t) low * clock_mult) >> CLOCK_MULT_SHIFT);
+}
+
+/* int32_t clock_gettime(uint32_t clock_id, timespec_t* ts)
+ * @input: clock_id - CLOCK_REALTIME / CLOCK_MONOTONIC
+ *         ts - receives the time
+ * @output: ret val - SUCCESS / FAIL
+ */
+int32_t clock_gettime(uint32_t clock_id, timespec_t* ts) {
+    if(NULL == ts) return FAIL;
+    if(CLOCK_REALTIME != clock_id && CLOCK_MONOTONIC != clock_id) return FAIL;
+    uint32_t nsec;
+    uint32_t sec = div64_32(clock_monotonic_ns(), NS_IN_S, &nsec);
+    if(CLOCK_REALTIME == clock_id) sec += clock_boot_sec;
+    ts->sec = sec;
+    ts->nsec = nsec;
+    return SUCCESS;
+}
@@ -0,0 +1,77 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include "../lib/lib.h"
+#include "../paging.h"
+
+#define CLOCK_REALTIME  0       // Seconds since 1970, from CMOS time at boot
+#define CLOCK_MONOTONIC 1       // Time since boot, never goes back
+
+// PIT channel 2, counted down once to measure TSC frequency at boot
+#define CLOCK_PIT_CMD       0x43
+#define CLOCK_PIT_CH2       0x42
+#define CLOCK_PIT_GATE      0x61
+#define CLOCK_PIT_CH2_MODE  0xb0    // Channel 2, Two byte, Mode 0
+#define CLOCK_GATE_ON       0x01
+#define CLOCK_GATE_SPEAKER  0x02
+#define CLOCK_GATE_OUT      0x20
+#define CLOCK_CALIBRATE_COUNT 11932     // 10 ms as PIT is 1.19318 MHz
+#define CLOCK_CALIBRATE_NS    10000000
+#define CLOCK_CALIBRATE_POLLS 0x100000  // Give up if channel 2 never fires
+
+// Nanoseconds per TSC cycle are kept as a fixed point number
+#define CLOCK_MULT_SHIFT 24
+
+#define SECONDS_PER_DAY 86400
+
+// Page of page_table_usermap mapped read only into every process,
+// at 132MB, the table's first page
+#define CLOCK_PAGE_INDEX 0
+#define USER_CLOCK_PAGE ((PAGE_TABLE_USERMAP_LOCATION << TB_ADDR_OFFSET_MB) + (CLOCK_PAGE_INDEX << TB_ADDR_OFFSET))
+// Layout is seen by user programs, so it's not TERMINAL_COUNT
+#define CLOCK_PAGE_TERMINALS 3
+
+typedef struct {
+    uint32_t sec;
+    uint32_t nsec;
+} timespec_t;
+
+typedef struct {
+    int32_t active_process;     // Foreground process, -1 if none
+    uint32_t screen_x;          // Cursor position
+    uint32_t screen_y;
+} clock_page_terminal_t;
+
+/* Time page read by user programs without a system call. Fields are
+ * updated between two increments of seq, so readers retry while seq is
+ * odd or changes during the read.
+ * Monotonic ns = ((rdtsc - tsc_base) * tsc_mult) >> tsc_shift if tsc_mult
+ * isn't 0, otherwise (ticks - pit_base) * ns_per_tick.
+ * Realtime seconds = boot_sec + monotonic seconds.
+ * Ticks and terminal state are as of the last PIT tick.
+ */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t ticks;             // pit_timer, PIT_FREQ per second
+    uint32_t pit_base;
+    uint32_t ns_per_tick;
+    uint64_t tsc_base;
+    uint32_t tsc_mult;
+    uint32_t tsc_shift;
+    uint32_t tsc_khz;
+    uint32_t boot_sec;
+    uint32_t displayed_terminal;
+    clock_page_terminal_t terminals[CLOCK_PAGE_TERMINALS];
+} clock_page_t;
+
+extern uint32_t clock_tsc_khz;
+extern clock_page_t* clock_page;
+
+void clock_init();
+void clock_mark_boot();
+int32_t clock_boot_ms();
+void clock_page_update();
+uint64_t clock_monotonic_ns();
+int32_t clock_gettime(uint32_t clock_id, timespec_t* ts);
+
+#endif
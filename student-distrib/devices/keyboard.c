@@ -3,6 +3,9 @@
 #include "../data/keyboard-scancode.h"
 #include "../lib/chinese_input.h"
 #include "../devices/qemu_vga.h"
+#include "../lib/scrollback.h"
+#include "../lib/status_bar.h"
+#include "../lib/deferred.h"
 
 // Unified FS interface definition for STDIN.
 unified_fs_interface_t terminal_stdin_if = {
@@ -27,6 +30,10 @@ unified_fs_interface_t terminal_stdout_if = {
 uint8_t shift_pressed = 0;
 uint8_t ctrl_pressed = 0;
 uint8_t alt_pressed = 0;
+// Whether shift was used with another key, so releasing it doesn't toggle IME
+uint8_t shift_combined = 0;
+// Whether last scancode was SCANCODE_EXTENDED
+uint8_t extended_pending = 0;
 uint8_t capslock_pressed = 0;
 uint8_t capslock = 0;
 
@@ -40,25 +47,34 @@ void keyboard_init() {
     enable_irq(KEYBOARD_IRQ);
 }
 
-/* void keyboard_interrupt()
- * @input: PORT(KEYBOARD_PORT) - scancode sent from keyboard.
- * @description: Handle keyboard interrupt
+/* void keyboard_handle_scancode(uint32_t scancode_idx)
+ * @input: scancode_idx - scancode sent from keyboard
+ * @description: deferred work of keyboard interrupt, does what the key means.
+ *     Runs with interrupts enabled, keys are handled in order they arrive.
  */
-void keyboard_interrupt() {
-    cli();
-    terminal_switch_active(displayed_terminal_id);
-
-    uint8_t scancode_idx = inb(KEYBOARD_PORT);
+static void keyboard_handle_scancode(uint32_t scancode_idx) {
     char key;
     int is_special_key;
 
     volatile terminal_t* t = &terminals[displayed_terminal_id];
 
+    // Extended keys may come with fake shift press / release, ignore them
+    uint8_t extended = extended_pending;
+    extended_pending = (scancode_idx == SCANCODE_EXTENDED);
+    if(extended_pending || (extended && ((scancode_idx & 0x7f) == LEFT_SHIFT_PRESS
+                                      || (scancode_idx & 0x7f) == RIGHT_SHIFT_PRESS))) {
+        return;
+    }
+
     is_special_key = update_special_key_stat(scancode_idx);
     if (is_special_key == 1){
-        // send End Of Interrupt
-        send_eoi(KEYBOARD_IRQ);
-        sti();
+        return;
+    }
+
+    if(shift_pressed && (scancode_idx == SCANCODE_PAGE_UP || scancode_idx == SCANCODE_PAGE_DOWN)) {
+        // Shift+PgUp / Shift+PgDn received, scroll through history
+        shift_combined = 1;
+        scrollback_scroll(scancode_idx == SCANCODE_PAGE_UP ? SCROLLBACK_PAGE : -SCROLLBACK_PAGE);
         return;
     }
 
@@ -71,21 +87,16 @@ void keyboard_interrupt() {
             t->keyboard_buffer_top = 0;
         }
 
-        // send End Of Interrupt
-        send_eoi(KEYBOARD_IRQ);
-
         if(key == 'c') {
-            // Ctrl+C received, schedule killing current process
-            if(displayed_terminal_id == active_terminal_id) {
-                syscall_halt(255);  // 255 is return code, indicate that process exited abnormally
-            } else {
-                ctrl_c_pending = 1;
-            }
+            // Ctrl+C received, foreground process of displayed terminal gets INTERRUPT signal.
+            // Without a handler, schedule killing it. The scheduler does it,
+            // as it can't be done halfway through deferred work
+            int32_t pid = terminals[displayed_terminal_id].active_process;
+            if(FAIL == signal_send(pid, SIGNAL_INTERRUPT)) ctrl_c_pending = 1;
+            process_cancel_sleep(pid);
         }
-        sti();
         return;
     } else if(alt_pressed == 1) {
-        send_eoi(KEYBOARD_IRQ);
         if(scancode_idx == SCANCODE_F1) {
             terminal_switch_display(0);
         } else if(scancode_idx == SCANCODE_F2) {
@@ -93,7 +104,6 @@ void keyboard_interrupt() {
         } else if(scancode_idx == SCANCODE_F3) {
             terminal_switch_display(2);
         }
-        sti();
         return;
     } else if(scancode_idx < SCANCODE_TABLE_SIZE) {
         // Caps check, modified by jinghua3.
@@ -143,6 +153,8 @@ void keyboard_interrupt() {
                 t->keyboard_buffer_top++;
                 // disable keyboard buffer
                 t->keyboard_buffer_enable = 0;
+                // Line is ready to be read by foreground process
+                signal_send(t->active_process, SIGNAL_IO);
             } else if (t->keyboard_buffer_top >= KEYBOARD_BUFFER_SIZE) {
                 // Prevent entering more keys
 
@@ -164,8 +176,20 @@ void keyboard_interrupt() {
             ONTO_DISPLAY_WRAP(putc(key));
         }
     }
+}
+
+/* void keyboard_interrupt()
+ * @input: PORT(KEYBOARD_PORT) - scancode sent from keyboard.
+ * @description: Handle keyboard interrupt. Only takes the scancode,
+ *     handling it is deferred work.
+ */
+void keyboard_interrupt() {
+    cli();
+    uint8_t scancode_idx = inb(KEYBOARD_PORT);
     // send End Of Interrupt
     send_eoi(KEYBOARD_IRQ);
+    deferred_queue(keyboard_handle_scancode, scancode_idx);
+    deferred_run();
     sti();
 }
 
@@ -198,10 +222,18 @@ int32_t terminal_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len)
     {
       return -1;
     }
+    // Keyboard belongs to foreground process of the terminal
+    process_t* process = process_get_active_pcb();
+    if (process != NULL && process->background)
+    {
+      return -1;
+    }
     // loop index
     int index;
     // return value
     int min_size;
+    // First shell prompt is up
+    status_bar_report_boot();
     // enable keyboard buffer
     terminals[active_terminal_id].keyboard_buffer_enable = 1;
 
@@ -247,7 +279,7 @@ int32_t terminal_write(int32_t* inode, uint32_t* offset, const char* buf, uint32
     for (index = 0; index < len; index++)
     {
         // if (*(uint8_t *)(buf + index) == 0) break;
-        putc(*(uint8_t *)(buf +index));
+        ansi_putc(*(uint8_t *)(buf +index));
     }
     return index;
 }
@@ -279,6 +311,7 @@ int update_special_key_stat(uint8_t keyboard_input){
 
     case LEFT_SHIFT_PRESS:
     case RIGHT_SHIFT_PRESS:
+      if(!shift_pressed) shift_combined = 0;
       shift_pressed = 1;
       return 1;
 
@@ -286,7 +319,7 @@ int update_special_key_stat(uint8_t keyboard_input){
     case RIGHT_SHIFT_RELEASE:
       shift_pressed = 0;
       // If QEMU VGA is enabled, Chinese IME can work, so toggle it
-      if(qemu_vga_enabled) t->chinese_input_buf.enabled = 1 - t->chinese_input_buf.enabled;
+      if(qemu_vga_enabled && !shift_combined) t->chinese_input_buf.enabled = 1 - t->chinese_input_buf.enabled;
       return 1;
 
     case LEFT_ALT_PRESS:
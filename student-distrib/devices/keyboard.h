@@ -24,6 +24,10 @@
 #define SCANCODE_F1         0x3B
 #define SCANCODE_F2         0x3C
 #define SCANCODE_F3         0x3D
+#define SCANCODE_PAGE_UP    0x49
+#define SCANCODE_PAGE_DOWN  0x51
+// Prefix of extended keys, like the PgUp / PgDn not on keypad
+#define SCANCODE_EXTENDED   0xE0
 
 #include "i8259.h"
 #include "vga_text.h"
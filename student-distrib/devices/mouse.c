@@ -1,11 +1,18 @@
 #include "mouse.h"
 #include "i8259.h"
 #include "keyboard.h"
+#include "mouse_cursor.h"
+#include "../lib/deferred.h"
+#include "../interrupts/signal.h"
 
 volatile int32_t mouse_x_cumulative = 0, mouse_y_cumulative = 0;
 volatile uint8_t mouse_left = 0, mouse_right = 0;
 volatile uint8_t mouse_used = 0;
 
+// Cursor movement not yet drawn, and whether drawing it is queued
+volatile int32_t mouse_cursor_dx = 0, mouse_cursor_dy = 0;
+volatile uint8_t mouse_cursor_pending = 0;
+
 /* void mouse_reg_wait_out()
  * @description: wait until mouse can accept another packet.
  */
@@ -68,8 +75,27 @@ void mouse_init() {
     enable_irq(MOUSE_IRQ);
 }
 
+/* void mouse_cursor_deferred(uint32_t arg)
+ * @input: arg - ignored
+ * @output: cursor moved by all movement since it was last drawn
+ * @description: deferred work of mouse interrupt, so packets arriving
+ *     while the cursor is drawn are merged into one move.
+ */
+static void mouse_cursor_deferred(uint32_t arg) {
+    uint32_t flags;
+    cli_and_save(flags);
+    int32_t dx = mouse_cursor_dx;
+    int32_t dy = mouse_cursor_dy;
+    mouse_cursor_dx = 0;
+    mouse_cursor_dy = 0;
+    mouse_cursor_pending = 0;
+    restore_flags(flags);
+    mouse_cursor_move(dx, dy);
+}
+
 /* void mouse_interrupt()
- * @description: mouse interrupt handler, updates mouse values
+ * @description: mouse interrupt handler, updates mouse values.
+ *     Cursor is drawn as deferred work.
  */
 void mouse_interrupt() {
     cli();
@@ -87,17 +113,25 @@ void mouse_interrupt() {
     mouse_y_cumulative = mouse_y;
     mouse_left = mouse.btn_left;
     mouse_right = mouse.btn_right;
+    // Mouse reports Y going upwards
+    mouse_cursor_dx += mouse_x;
+    mouse_cursor_dy -= mouse_y;
+    if(!mouse_cursor_pending) {
+        mouse_cursor_pending = (SUCCESS == deferred_queue(mouse_cursor_deferred, 0));
+    }
+    signal_send_io(&mouse_if);
     // printf("mouse %c%c %d %d\n", mouse.btn_left ? 'L' : ' ', mouse.btn_right ? 'R' : ' ',
     //     mouse_x_cumulative, mouse_y_cumulative);
-    sti();
     send_eoi(MOUSE_IRQ);
+    deferred_run();
+    sti();
 }
 
 unified_fs_interface_t mouse_if = {
     .open = mouse_open,
     .read = mouse_read,
     .write = NULL,
-    .ioctl = NULL,
+    .ioctl = mouse_ioctl,
     .close = mouse_close
 };
 
@@ -144,12 +178,37 @@ int32_t mouse_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len) {
     return SUCCESS;
 }
 
+/* int32_t mouse_ioctl(int32_t* inode, uint32_t* offset, int32_t op)
+ * @input: inode, offset - ignored
+ *         op - MOUSE_IOCTL_CURSOR_SHOW / HIDE to show or hide the cursor,
+ *              MOUSE_IOCTL_GET_POS to get cursor position
+ * @output: ret val - SUCCESS / FAIL, or X << 16 | Y for MOUSE_IOCTL_GET_POS
+ * @description: controls the cursor drawn by kernel, so programs can
+ *     follow the mouse without drawing a pointer themselves.
+ */
+int32_t mouse_ioctl(int32_t* inode, uint32_t* offset, int32_t op) {
+    switch(op) {
+        case MOUSE_IOCTL_CURSOR_SHOW:
+            mouse_cursor_set_visible(1);
+            return SUCCESS;
+        case MOUSE_IOCTL_CURSOR_HIDE:
+            mouse_cursor_set_visible(0);
+            return SUCCESS;
+        case MOUSE_IOCTL_GET_POS:
+            return mouse_cursor_get_pos();
+        default:
+            return FAIL;
+    }
+}
+
 /* int32_t mouse_close(int32_t* inode)
  * @input: inode - ignored
  * @output: 0 (SUCCESS)
- * @description: release mouse for use with other programs.
+ * @description: release mouse for use with other programs,
+ *     cursor is shown again in case it was hidden.
  */
 int32_t mouse_close(int32_t* inode) {
     mouse_used = 0;
+    mouse_cursor_set_visible(1);
     return SUCCESS;
 }
@@ -16,6 +16,10 @@
 #define MOUSE_ACK               0xfa
 #define MOUSE_IRQ               12
 
+#define MOUSE_IOCTL_CURSOR_SHOW 1
+#define MOUSE_IOCTL_CURSOR_HIDE 2
+#define MOUSE_IOCTL_GET_POS     3
+
 typedef union {
     int8_t val;
     struct __attribute__ ((packed)) {
@@ -39,6 +43,7 @@ void mouse_interrupt();
 
 int32_t mouse_open(int32_t* inode, char* filename);
 int32_t mouse_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len);
+int32_t mouse_ioctl(int32_t* inode, uint32_t* offset, int32_t op);
 int32_t mouse_close(int32_t* inode);
 
 extern unified_fs_interface_t mouse_if;
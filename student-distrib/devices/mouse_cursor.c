@@ -0,0 +1,181 @@
+#include "mouse_cursor.h"
+#include "qemu_vga.h"
+#include "vga2d.h"
+#include "../interrupts/multiprocessing.h"
+
+// Arrow sprite, 1 bit per pixel with MSB leftmost.
+// Shape is drawn in border color, then inside in fill color
+static const uint8_t mouse_cursor_shape[MOUSE_CURSOR_HEIGHT][MOUSE_CURSOR_MASK_PITCH] = {
+    {0x80, 0x00}, // X
+    {0xc0, 0x00}, // XX
+    {0xe0, 0x00}, // X.X
+    {0xf0, 0x00}, // X..X
+    {0xf8, 0x00}, // X...X
+    {0xfc, 0x00}, // X....X
+    {0xfe, 0x00}, // X.....X
+    {0xff, 0x00}, // X......X
+    {0xff, 0x80}, // X.......X
+    {0xff, 0xc0}, // X........X
+    {0xff, 0xe0}, // X.........X
+    {0xff, 0xf0}, // X......XXXXX
+    {0xff, 0x00}, // X...X..X
+    {0xff, 0x00}, // X..XX..X
+    {0xe7, 0x80}, // X.X  X..X
+    {0xc7, 0x80}, // XX   X..X
+    {0x83, 0xc0}, // X     X..X
+    {0x03, 0xc0}, //       X..X
+    {0x01, 0x80}, //        XX
+};
+static const uint8_t mouse_cursor_fill[MOUSE_CURSOR_HEIGHT][MOUSE_CURSOR_MASK_PITCH] = {
+    {0x00, 0x00}, {0x00, 0x00}, {0x40, 0x00}, {0x60, 0x00}, {0x70, 0x00},
+    {0x78, 0x00}, {0x7c, 0x00}, {0x7e, 0x00}, {0x7f, 0x00}, {0x7f, 0x80},
+    {0x7f, 0xc0}, {0x7e, 0x00}, {0x76, 0x00}, {0x66, 0x00}, {0x43, 0x00},
+    {0x03, 0x00}, {0x01, 0x80}, {0x01, 0x80}, {0x00, 0x00},
+};
+
+static mouse_cursor_t mouse_cursor = {
+    .x = QEMU_VGA_DEFAULT_WIDTH / 2,
+    .y = QEMU_VGA_DEFAULT_HEIGHT / 2,
+    .visible = 1,
+    .drawn = 0,
+    .busy = 0,
+};
+static uint8_t mouse_cursor_save[MOUSE_CURSOR_SAVE_SIZE];
+
+/* void mouse_cursor_hide()
+ * @output: pixels under the sprite put back, if it's drawn
+ * @description: must be called with interrupts off.
+ */
+static void mouse_cursor_hide() {
+    if(!mouse_cursor.drawn) return;
+    uint32_t row_bytes = mouse_cursor.width * qemu_vga_ops->bytes_per_pixel;
+    vga2d_copy(mouse_cursor.addr, qemu_vga_pitch,
+        (uint32_t) mouse_cursor_save, row_bytes, row_bytes, mouse_cursor.height);
+    mouse_cursor.drawn = 0;
+}
+
+/* void mouse_cursor_draw()
+ * @output: sprite drawn at current position on displayed terminal,
+ *     pixels under it saved, unless drawing is in progress
+ * @description: must be called with interrupts off. Moves the sprite
+ *     if it's drawn somewhere else.
+ */
+static void mouse_cursor_draw() {
+    if(!qemu_vga_enabled || mouse_cursor.busy) return;
+    if(mouse_cursor.drawn) {
+        if(mouse_cursor.tid == displayed_terminal_id
+            && mouse_cursor.drawn_x == mouse_cursor.x && mouse_cursor.drawn_y == mouse_cursor.y) return;
+        mouse_cursor_hide();
+    }
+    if(!mouse_cursor.visible) return;
+
+    // Resolution may have changed since last move
+    if(mouse_cursor.x >= qemu_vga_xres) mouse_cursor.x = qemu_vga_xres - 1;
+    if(mouse_cursor.y >= qemu_vga_yres) mouse_cursor.y = qemu_vga_yres - 1;
+
+    // Sprite is clipped on right and bottom edges
+    uint32_t bytes_per_pixel = qemu_vga_ops->bytes_per_pixel;
+    uint16_t width = MOUSE_CURSOR_WIDTH;
+    uint16_t height = MOUSE_CURSOR_HEIGHT;
+    if(mouse_cursor.x + width > qemu_vga_xres) width = qemu_vga_xres - mouse_cursor.x;
+    if(mouse_cursor.y + height > qemu_vga_yres) height = qemu_vga_yres - mouse_cursor.y;
+
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[displayed_terminal_id];
+    uint32_t addr = qemu_vga_page_addr(displayed_terminal_id, buffer->front)
+        + mouse_cursor.y * qemu_vga_pitch + mouse_cursor.x * bytes_per_pixel;
+    uint32_t row_bytes = width * bytes_per_pixel;
+
+    vga2d_copy((uint32_t) mouse_cursor_save, row_bytes, addr, qemu_vga_pitch, row_bytes, height);
+    qemu_vga_ops->expand(addr, qemu_vga_pitch, (const uint8_t*) mouse_cursor_shape,
+        MOUSE_CURSOR_MASK_PITCH, width, height,
+        qemu_vga_get_terminal_color(MOUSE_CURSOR_BORDER_COLOR).val, 0, VGA2D_TRANSPARENT);
+    qemu_vga_ops->expand(addr, qemu_vga_pitch, (const uint8_t*) mouse_cursor_fill,
+        MOUSE_CURSOR_MASK_PITCH, width, height,
+        qemu_vga_get_terminal_color(MOUSE_CURSOR_FILL_COLOR).val, 0, VGA2D_TRANSPARENT);
+
+    mouse_cursor.tid = displayed_terminal_id;
+    mouse_cursor.addr = addr;
+    mouse_cursor.drawn_x = mouse_cursor.x;
+    mouse_cursor.drawn_y = mouse_cursor.y;
+    mouse_cursor.width = width;
+    mouse_cursor.height = height;
+    mouse_cursor.drawn = 1;
+}
+
+/* void mouse_cursor_enter(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+ * @input: tid - terminal being drawn on, or MOUSE_CURSOR_ANY_TERMINAL
+ *         x, y, width, height - rectangle being drawn
+ * @output: sprite taken off screen if it overlaps with the rectangle,
+ *     and kept off until the matching mouse_cursor_leave
+ * @description: called by QEMU VGA before it writes to the framebuffer,
+ *     so drawing neither paints over the sprite nor goes stale under it.
+ *     Mouse moves in between are applied on leave.
+ */
+void mouse_cursor_enter(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    uint32_t flags;
+    cli_and_save(flags);
+    mouse_cursor.busy++;
+    if(mouse_cursor.drawn
+        && (MOUSE_CURSOR_ANY_TERMINAL == tid || mouse_cursor.tid == tid)
+        && x < mouse_cursor.drawn_x + mouse_cursor.width && mouse_cursor.drawn_x < x + width
+        && y < mouse_cursor.drawn_y + mouse_cursor.height && mouse_cursor.drawn_y < y + height) {
+        mouse_cursor_hide();
+    }
+    restore_flags(flags);
+}
+
+/* void mouse_cursor_leave()
+ * @output: sprite put back on screen, at its latest position,
+ *     once all drawing is done
+ */
+void mouse_cursor_leave() {
+    uint32_t flags;
+    cli_and_save(flags);
+    if(mouse_cursor.busy) mouse_cursor.busy--;
+    mouse_cursor_draw();
+    restore_flags(flags);
+}
+
+/* void mouse_cursor_move(int32_t dx, int32_t dy)
+ * @input: dx, dy - movement in pixels, Y going downwards
+ * @output: sprite moved, bounded by the screen
+ * @description: called from mouse interrupt. If drawing is in progress,
+ *     the sprite is moved when it finishes.
+ */
+void mouse_cursor_move(int32_t dx, int32_t dy) {
+    uint32_t flags;
+    cli_and_save(flags);
+    mouse_cursor.x += dx;
+    mouse_cursor.y += dy;
+    if(mouse_cursor.x < 0) mouse_cursor.x = 0;
+    if(mouse_cursor.y < 0) mouse_cursor.y = 0;
+    if(qemu_vga_enabled) {
+        if(mouse_cursor.x >= qemu_vga_xres) mouse_cursor.x = qemu_vga_xres - 1;
+        if(mouse_cursor.y >= qemu_vga_yres) mouse_cursor.y = qemu_vga_yres - 1;
+    }
+    mouse_cursor_draw();
+    restore_flags(flags);
+}
+
+/* void mouse_cursor_set_visible(uint8_t visible)
+ * @input: visible - 1 to show the sprite, 0 to hide it
+ * @output: sprite shown / hidden
+ */
+void mouse_cursor_set_visible(uint8_t visible) {
+    uint32_t flags;
+    cli_and_save(flags);
+    mouse_cursor.visible = visible;
+    if(visible) {
+        mouse_cursor_draw();
+    } else {
+        mouse_cursor_hide();
+    }
+    restore_flags(flags);
+}
+
+/* uint32_t mouse_cursor_get_pos()
+ * @output: ret val - sprite position on screen, X in high 16 bits, Y in low 16 bits
+ */
+uint32_t mouse_cursor_get_pos() {
+    return (mouse_cursor.x << 16) | mouse_cursor.y;
+}
@@ -0,0 +1,35 @@
+#ifndef _MOUSE_CURSOR_H_
+#define _MOUSE_CURSOR_H_
+
+#include "../lib/lib.h"
+
+#define MOUSE_CURSOR_WIDTH 12
+#define MOUSE_CURSOR_HEIGHT 19
+#define MOUSE_CURSOR_MASK_PITCH 2
+// Enough to save pixels under the sprite in 32 bit color
+#define MOUSE_CURSOR_SAVE_SIZE (MOUSE_CURSOR_WIDTH * MOUSE_CURSOR_HEIGHT * 4)
+
+// Drawing that may be on any terminal, like status bar
+#define MOUSE_CURSOR_ANY_TERMINAL -1
+
+#define MOUSE_CURSOR_BORDER_COLOR 0x0
+#define MOUSE_CURSOR_FILL_COLOR 0xf
+
+typedef struct {
+    int32_t x, y;           // Hot spot (left top corner) of the sprite on screen
+    uint8_t visible;        // Whether the sprite should be on screen
+    uint8_t drawn;          // Whether the sprite is on screen, over saved pixels
+    uint8_t busy;           // Nesting level of drawing in progress
+    int32_t tid;            // Terminal the sprite is drawn on
+    uint32_t addr;          // Left top corner of the drawn sprite on framebuffer
+    int32_t drawn_x, drawn_y;
+    uint16_t width, height; // Size of drawn sprite, clipped by the screen
+} mouse_cursor_t;
+
+void mouse_cursor_enter(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void mouse_cursor_leave();
+void mouse_cursor_move(int32_t dx, int32_t dy);
+void mouse_cursor_set_visible(uint8_t visible);
+uint32_t mouse_cursor_get_pos();
+
+#endif
@@ -1,10 +1,26 @@
 #include "pit.h"
 #include "i8259.h"
 #include "../interrupts/multiprocessing.h"
+#include "../lib/deferred.h"
+#include "clock.h"
 
 // Counter to maintain system time
 volatile uint32_t pit_timer = 0;
 
+static pit_timer_event_t pit_timer_events[PIT_TIMER_EVENTS];
+static volatile uint32_t pit_timer_count = 0;
+
+// Ticks the PIT is programmed to wait in one shot, 0 if ticking periodically
+static volatile uint32_t pit_idle_ticks = 0;
+
+/* int32_t pit_timer_before(uint32_t a, uint32_t b)
+ * @input: a, b - values of pit_timer
+ * @output: ret val - 1 if a comes before b, allowing the counter to wrap around
+ */
+static int32_t pit_timer_before(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b) < 0;
+}
+
 /* void pit_init()
  * @output: PIT generates interrupts at interval specified by PIT_INTERVAL
  * @description: initializes PIT for scheduling.
@@ -17,18 +33,142 @@ void pit_init() {
     enable_irq(PIT_IRQ);
 }
 
+/* void pit_periodic()
+ * @output: PIT back to ticking at PIT_FREQ after an idle period
+ * @description: must be called with interrupts off.
+ */
+static void pit_periodic() {
+    pit_idle_ticks = 0;
+    outb(PIT_MODE, PIT_REG_CMD);
+    outb((uint8_t) PIT_INTERVAL, PIT_REG_DATA);
+    outb((uint8_t) (PIT_INTERVAL >> 8), PIT_REG_DATA);
+}
+
+/* int32_t pit_timer_add(uint32_t deadline, pit_timer_func_t func, uint32_t arg)
+ * @input: deadline - value of pit_timer when func(arg) is to be called
+ *         func, arg - the event, called from the PIT interrupt with interrupts off,
+ *             so it must be short
+ * @output: ret val - SUCCESS, or FAIL if the queue is full
+ * @description: events with the same deadline fire in order they're added.
+ */
+int32_t pit_timer_add(uint32_t deadline, pit_timer_func_t func, uint32_t arg) {
+    if(NULL == func) return FAIL;
+    uint32_t flags;
+    cli_and_save(flags);
+    if(pit_timer_count >= PIT_TIMER_EVENTS) {
+        restore_flags(flags);
+        return FAIL;
+    }
+    uint32_t i = pit_timer_count;
+    while(i > 0 && pit_timer_before(deadline, pit_timer_events[i - 1].deadline)) {
+        pit_timer_events[i] = pit_timer_events[i - 1];
+        i--;
+    }
+    pit_timer_events[i].deadline = deadline;
+    pit_timer_events[i].func = func;
+    pit_timer_events[i].arg = arg;
+    pit_timer_count++;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* void pit_timer_cancel(pit_timer_func_t func, uint32_t arg)
+ * @input: func, arg - an event added with pit_timer_add
+ * @output: all pending events of func(arg) removed
+ * @description: frees the queue entries of events that are no longer
+ *     wanted, like an alarm that is set again.
+ */
+void pit_timer_cancel(pit_timer_func_t func, uint32_t arg) {
+    uint32_t flags;
+    cli_and_save(flags);
+    uint32_t i;
+    uint32_t kept = 0;
+    for(i = 0; i < pit_timer_count; i++) {
+        if(pit_timer_events[i].func == func && pit_timer_events[i].arg == arg) continue;
+        pit_timer_events[kept++] = pit_timer_events[i];
+    }
+    pit_timer_count = kept;
+    restore_flags(flags);
+}
+
+/* void pit_timer_expire()
+ * @output: events with deadline reached are called and removed
+ * @description: must be called with interrupts off.
+ */
+static void pit_timer_expire() {
+    uint32_t done = 0;
+    while(done < pit_timer_count && !pit_timer_before(pit_timer, pit_timer_events[done].deadline)) {
+        pit_timer_events[done].func(pit_timer_events[done].arg);
+        done++;
+    }
+    if(0 == done) return;
+    pit_timer_count -= done;
+    memmove(pit_timer_events, pit_timer_events + done, pit_timer_count * sizeof(pit_timer_event_t));
+}
+
+/* void pit_idle()
+ * @output: CPU halted until next interrupt
+ * @description: called with interrupts off when no process can run.
+ *     Instead of waking up on every tick, the PIT is programmed once for
+ *     the next timer deadline, and pit_timer is advanced by the ticks
+ *     that passed. Part of a tick is lost if another interrupt comes first.
+ */
+void pit_idle() {
+    uint32_t ticks = PIT_IDLE_MAX_TICKS;
+    if(pit_timer_count > 0) {
+        int32_t left = pit_timer_events[0].deadline - pit_timer;
+        if(left < (int32_t) ticks) ticks = left < 1 ? 1 : left;
+    }
+    if(ticks > 1) {
+        uint16_t count = ticks * PIT_INTERVAL;
+        pit_idle_ticks = ticks;
+        outb(PIT_MODE_ONESHOT, PIT_REG_CMD);
+        outb((uint8_t) count, PIT_REG_DATA);
+        outb((uint8_t) (count >> 8), PIT_REG_DATA);
+    }
+
+    sti();
+    wait_interrupt();
+    cli();
+
+    if(pit_idle_ticks) {
+        // Woken up by something else, count the whole ticks that passed
+        outb(PIT_LATCH, PIT_REG_CMD);
+        uint16_t remaining = inb(PIT_REG_DATA);
+        remaining |= inb(PIT_REG_DATA) << 8;
+        uint32_t elapsed = pit_idle_ticks * PIT_INTERVAL - remaining;
+        pit_periodic();
+        pit_timer += elapsed / PIT_INTERVAL;
+        clock_page_update();
+        pit_timer_expire();
+    }
+}
+
 /* void pit_interrupt()
  * @output: system switch to another process, for multiprocessing.
  * @description: switches between processes to achieve background multiprocessing.
+ *     Timer events are fired first. Then, runs work deferred by interrupt
+ *     handlers with interrupts enabled. A tick arriving meanwhile only counts time,
+ *     so the deferred work isn't switched away from halfway.
  */
 void pit_interrupt() {
     cli();
-    // Increment system time counter
-    pit_timer++;
+    // Increment system time counter, by all ticks of an idle period
+    if(pit_idle_ticks) {
+        pit_timer += pit_idle_ticks;
+        pit_periodic();
+    } else {
+        pit_timer++;
+    }
+    clock_page_update();
+    pit_timer_expire();
     send_eoi(PIT_IRQ);
+    if(deferred_running) return;
+
+    deferred_run();
+
     // Do a context switch
-    int32_t new_terminal = (active_terminal_id + 1) % TERMINAL_COUNT;
-    terminal_switch_active(new_terminal);
+    process_schedule();
     sti();
 }
 
@@ -7,14 +7,36 @@
 #define PIT_REG_CMD     0x43
 #define PIT_REG_DATA    0x40
 #define PIT_MODE        0x37    // Channel 0, Two byte, Mode 3
+#define PIT_MODE_ONESHOT 0x30   // Channel 0, Two byte, Mode 0, interrupt once count runs out
+#define PIT_LATCH       0x00    // Channel 0, latch count for reading
 #define PIT_INTERVAL    11932   // 100 Hz as PIT is 1.19318 MHz
 #define PIT_FREQ        100     // 100 Hz as PIT is 1.19318 MHz
 #define MS_IN_S         1000
+#define NS_IN_S         1000000000
+#define MS_PER_TICK     (MS_IN_S / PIT_FREQ)
+#define NS_PER_TICK     (NS_IN_S / PIT_FREQ)
+
+// Longest idle period, as the count is 16 bits
+#define PIT_IDLE_MAX_TICKS (0xffff / PIT_INTERVAL)
+
+// Pending timer events, kept sorted by deadline
+#define PIT_TIMER_EVENTS 32
+
+typedef void (*pit_timer_func_t)(uint32_t arg);
+
+typedef struct {
+    uint32_t deadline;          // Value of pit_timer to fire at
+    pit_timer_func_t func;
+    uint32_t arg;
+} pit_timer_event_t;
 
 extern volatile uint32_t pit_timer;
 
 void pit_init();
 void pit_interrupt();
 void pit_sleep(uint32_t ms);
+int32_t pit_timer_add(uint32_t deadline, pit_timer_func_t func, uint32_t arg);
+void pit_timer_cancel(pit_timer_func_t func, uint32_t arg);
+void pit_idle();
 
 #endif
@@ -4,6 +4,13 @@
 #include "../data/vga_fonts.h"
 #include "../data/color.h"
 #include "../data/chinese_font.h"
+#include "pit.h"
+#include "../lib/decompress.h"
+#include "../lib/glyph_cache.h"
+#include "../lib/status_bar.h"
+#include "vga2d.h"
+#include "mouse_cursor.h"
+#include "screen.h"
 
 // Address of linear buffer, set by PCI scanner on startup
 uint32_t qemu_vga_addr = 0;
@@ -16,6 +23,82 @@ uint32_t qemu_vga_enabled = 0;
 uint32_t qemu_vga_cursor_x = 0;
 uint32_t qemu_vga_cursor_y = 0;
 
+// Precomputed for current mode
+uint32_t qemu_vga_pitch = 0;        // Bytes per line
+uint32_t qemu_vga_page_size = 0;    // Bytes per terminal page
+
+// Height of the picture pre-rendered on terminals that haven't started, 0 for none
+uint16_t qemu_vga_splash_height = 0;
+
+// Front / back page state of each terminal
+qemu_vga_buffer_t qemu_vga_buffers[TERMINAL_COUNT];
+
+// Chinese characters on text area of each terminal, stored at left cell.
+// Text mode buffer only has spaces for them, so keep them here for redraws.
+uint16_t qemu_vga_wide_plane[TERMINAL_COUNT][SCREEN_HEIGHT][SCREEN_WIDTH];
+
+// Text rows of each terminal not rendered yet, 1 bit per row.
+// Terminals not on screen only update their text buffer.
+static uint32_t qemu_vga_text_stale[TERMINAL_COUNT];
+
+// Unified FS interface for double buffered drawing.
+unified_fs_interface_t qemu_vga_if = {
+    .open = qemu_vga_open,
+    .read = NULL,
+    .write = NULL,
+    .ioctl = qemu_vga_ioctl,
+    .close = qemu_vga_close
+};
+
+/* Single pixel routines of each color depth, the rest are in vga2d.c.
+ * Colors are already in the depth's format, as returned by
+ * qemu_vga_get_terminal_color.
+ */
+
+/* void qemu_vga_pixel_N(uint32_t addr, uint32_t color)
+ * @output: one pixel at addr set to color */
+static void qemu_vga_pixel_8(uint32_t addr, uint32_t color) {
+    *(uint8_t*) addr = color;
+}
+static void qemu_vga_pixel_16(uint32_t addr, uint32_t color) {
+    *(uint16_t*) addr = color;
+}
+static void qemu_vga_pixel_32(uint32_t addr, uint32_t color) {
+    *(uint32_t*) addr = color & 0xffffff;
+}
+
+// Routines and terminal colors of each supported color depth
+static const qemu_vga_ops_t qemu_vga_ops_8 = {
+    .bpp = 8, .bytes_per_pixel = 1, .palette = terminal_color_8,
+    .pixel = qemu_vga_pixel_8, .fill = vga2d_fill_8, .expand = vga2d_expand_8
+};
+static const qemu_vga_ops_t qemu_vga_ops_16 = {
+    .bpp = 16, .bytes_per_pixel = 2, .palette = terminal_color_16,
+    .pixel = qemu_vga_pixel_16, .fill = vga2d_fill_16, .expand = vga2d_expand_16
+};
+static const qemu_vga_ops_t qemu_vga_ops_32 = {
+    .bpp = 32, .bytes_per_pixel = 4, .palette = terminal_color_32,
+    .pixel = qemu_vga_pixel_32, .fill = vga2d_fill_32, .expand = vga2d_expand_32
+};
+
+// Routines of current mode. Colors are looked up even before init.
+const qemu_vga_ops_t* qemu_vga_ops = &qemu_vga_ops_16;
+
+// Colors of each attribute byte in current mode, so text drawing
+// takes one lookup per cell instead of two palette translations
+qemu_vga_attr_t qemu_vga_attrs[QEMU_VGA_ATTRS];
+
+/* void qemu_vga_build_attrs()
+ * @output: qemu_vga_attrs filled from palette of current mode
+ */
+static void qemu_vga_build_attrs() {
+    int i;
+    for(i = 0; i < QEMU_VGA_ATTRS; i++) {
+        qemu_vga_attrs[i].fg = qemu_vga_ops->palette[i & (QEMU_VGA_TERMINAL_COLORS - 1)];
+        qemu_vga_attrs[i].bg = qemu_vga_ops->palette[(i >> 4) & (QEMU_VGA_TERMINAL_COLORS - 1)];
+    }
+}
+
 /* uint16_t qemu_vga_read(uint16_t index)
  * @input: index - index of register in QEMU VGA
  * @output: ret val - data in that register
@@ -38,12 +121,111 @@ void qemu_vga_write(uint16_t index, uint16_t data) {
     outw(data, QEMU_VGA_PORT_DATA);
 }
 
+/* uint32_t qemu_vga_page_addr(int32_t tid, uint8_t page)
+ * @input: tid - terminal id
+ *         page - 0 or 1, which of the two pages of this terminal
+ * @output: ret val - address of that page on QEMU VGA linear buffer.
+ * @description: all first pages are stored before all second pages, so
+ *     the single buffered layout is the same as having only page 0.
+ */
+uint32_t qemu_vga_page_addr(int32_t tid, uint8_t page) {
+    return qemu_vga_addr + (page * TERMINAL_COUNT + tid) * qemu_vga_page_size;
+}
+
 /* uint32_t qemu_vga_active_window_addr()
  * @output: ret val - address of the active window on QEMU VGA linear buffer.
- * @description: calculates and returns said address.
+ * @description: calculates and returns said address. With double buffering
+ *     enabled on the active terminal, this is the back page.
  */
 uint32_t qemu_vga_active_window_addr() {
-    return qemu_vga_addr + active_terminal_id * (qemu_vga_xres * qemu_vga_yres * qemu_vga_bpp / BITS_IN_BYTE);
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[active_terminal_id];
+    return qemu_vga_page_addr(active_terminal_id,
+        buffer->enabled ? !buffer->front : buffer->front);
+}
+
+/* void qemu_vga_mark_dirty(uint32_t y_start, uint32_t y_end)
+ * @input: y_start, y_end - pixel lines [y_start, y_end) being drawn
+ * @output: dirty range of the active terminal's back page extended
+ * @description: remembers what changed since the last present, so only
+ *     those lines have to be copied to the new back page after a flip.
+ */
+static void qemu_vga_mark_dirty(uint32_t y_start, uint32_t y_end) {
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[active_terminal_id];
+    if(!buffer->enabled) return;
+    if(y_start < buffer->dirty_top) buffer->dirty_top = y_start;
+    if(y_end > buffer->dirty_bottom) buffer->dirty_bottom = y_end;
+}
+
+/* void qemu_vga_draw_begin(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+ * @input: tid - terminal being drawn on, or MOUSE_CURSOR_ANY_TERMINAL for all of them
+ *         x, y, width, height - rectangle about to be drawn
+ * @output: rectangle recorded as damage for screen device, if it's going
+ *     onto the front page, and mouse cursor lifted off it
+ * @description: goes before every write to the framebuffer, paired with
+ *     qemu_vga_draw_end. Back page changes are recorded on present instead.
+ */
+static void qemu_vga_draw_begin(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    int32_t i;
+    for(i = 0; i < TERMINAL_COUNT; i++) {
+        if(MOUSE_CURSOR_ANY_TERMINAL != tid && i != tid) continue;
+        if(qemu_vga_buffers[i].enabled && y + height <= QEMU_VGA_TEXT_AREA_HEIGHT) continue;
+        screen_damage(i, x, y, width, height);
+    }
+    mouse_cursor_enter(tid, x, y, width, height);
+}
+
+/* void qemu_vga_draw_end()
+ * @output: mouse cursor put back, see qemu_vga_draw_begin
+ */
+static void qemu_vga_draw_end() {
+    mouse_cursor_leave();
+}
+
+/* uint8_t qemu_vga_text_deferred(uint8_t grid_top, uint8_t grid_bottom)
+ * @input: grid_top, grid_bottom - text rows [grid_top, grid_bottom] about to change
+ * @output: ret val - 1 if rendering is skipped, rows marked stale
+ * @description: text of a terminal that isn't on screen only goes into its
+ *     text buffer, and is rendered by qemu_vga_text_flush when it's needed.
+ *     Double buffered terminals are always rendered, as they present themselves.
+ */
+static uint8_t qemu_vga_text_deferred(uint8_t grid_top, uint8_t grid_bottom) {
+    if(active_terminal_id == displayed_terminal_id) return 0;
+    if(qemu_vga_buffers[active_terminal_id].enabled) return 0;
+    qemu_vga_text_stale[active_terminal_id] |= QEMU_VGA_ROWS(grid_top, grid_bottom);
+    return 1;
+}
+
+/* void qemu_vga_text_flush(int32_t tid)
+ * @input: tid - terminal id
+ * @output: text rows of that terminal not rendered yet are drawn
+ * @description: done when the terminal is brought on screen, or captured.
+ *     Anything else drawn on those rows, like part of a picture, is lost.
+ */
+void qemu_vga_text_flush(int32_t tid) {
+    if(!qemu_vga_enabled) return;
+    if(tid < 0 || tid >= TERMINAL_COUNT) return;
+    uint32_t flags;
+    cli_and_save(flags);
+    uint32_t stale = qemu_vga_text_stale[tid];
+    if(stale) {
+        qemu_vga_text_stale[tid] = 0;
+        char* saved_video_mem = video_mem;
+        int32_t saved_tid = active_terminal_id;
+        int row;
+
+        // Text of displayed terminal is in VGA text buffer, others are saved aside
+        active_terminal_id = tid;
+        video_mem = (char*) (tid == displayed_terminal_id ? TERMINAL_DIRECT_ADDR
+            : TERMINAL_ALT_START + tid * TERMINAL_ALT_SIZE);
+        for(row = 0; row < SCREEN_HEIGHT; row++) {
+            if(!(stale & QEMU_VGA_ROWS(row, row))) continue;
+            qemu_vga_draw_text_row(row, (uint8_t*) (video_mem + ((row * NUM_COLS) << 1)),
+                qemu_vga_wide_plane[tid][row]);
+        }
+        video_mem = saved_video_mem;
+        active_terminal_id = saved_tid;
+    }
+    restore_flags(flags);
 }
 
 /* void qemu_vga_switch_terminal(int32_t tid)
@@ -58,21 +240,28 @@ uint32_t qemu_vga_active_window_addr() {
  * | Terminal 3 |
  * +------------+
  * so with a change of Y display offset, we can switch between these terminals.
+ * The back pages used for double buffering follow in the same order.
+ * Text not rendered while the terminal was in background is drawn first.
  */
 void qemu_vga_switch_terminal(int32_t tid) {
     if(!qemu_vga_enabled) return;
     if(tid >= TERMINAL_COUNT) return;
-    qemu_vga_write(QEMU_VGA_IDX_Y_OFFSET, tid * qemu_vga_yres);
+    qemu_vga_text_flush(tid);
+    // Mouse cursor goes along to the new page
+    mouse_cursor_enter(MOUSE_CURSOR_ANY_TERMINAL, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    qemu_vga_write(QEMU_VGA_IDX_Y_OFFSET,
+        (qemu_vga_buffers[tid].front * TERMINAL_COUNT + tid) * qemu_vga_yres);
+    mouse_cursor_leave();
 }
 
 /* uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp)
- * @input: xres - X resolution
- *         yres - Y resolution
+ * @input: xres - X resolution, at least QEMU_VGA_MIN_WIDTH
+ *         yres - Y resolution, at least QEMU_VGA_MIN_HEIGHT
  *         bpp - bits per pixel, can only be 4, 8, 15, 16, 24, 32,
- *               where this OS only supports 16 and 32.
+ *               where this OS only supports 8, 16 and 32.
  * @output: ret val - SUCCESS / FAIL
- *          QEMU VGA initialized to said state
- * @description: initialized QEMU VGA.
+ *          QEMU VGA initialized to said state, screen cleared
+ * @description: initialized QEMU VGA. Nothing is changed on FAIL.
  */
 uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp) {
     if(0 == qemu_vga_addr) return FAIL;
@@ -84,14 +273,28 @@ uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp) {
         return FAIL;
     }
 
-    // Currently only supports 16 bit and 32 bit BPP.
-    // No plan to add more support as we don't use them.
-    if(bpp != 16 && bpp != 32) return FAIL;
+    const qemu_vga_ops_t* ops;
+    switch(bpp) {
+        case 8: ops = &qemu_vga_ops_8; break;
+        case 16: ops = &qemu_vga_ops_16; break;
+        case 32: ops = &qemu_vga_ops_32; break;
+        default: return FAIL;
+    }
+
+    // Text area and bars below it must fit on screen,
+    // and every page of every terminal in video memory
+    if(xres < QEMU_VGA_MIN_WIDTH || yres < QEMU_VGA_MIN_HEIGHT) return FAIL;
+    uint32_t page_size = xres * yres * ops->bytes_per_pixel;
+    if(page_size > QEMU_VGA_BANK_SIZE / (QEMU_VGA_PAGE_COUNT * TERMINAL_COUNT)) return FAIL;
 
     // Store state information for later address calculation
     qemu_vga_xres = xres;
     qemu_vga_yres = yres;
     qemu_vga_bpp = bpp;
+    qemu_vga_ops = ops;
+    qemu_vga_build_attrs();
+    qemu_vga_pitch = xres * ops->bytes_per_pixel;
+    qemu_vga_page_size = page_size;
 
     // Write the setting into VGA
     qemu_vga_write(QEMU_VGA_IDX_ENABLE, QEMU_VGA_DISABLE);
@@ -103,10 +306,58 @@ uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp) {
     qemu_vga_write(QEMU_VGA_IDX_Y_OFFSET, 0);
     qemu_vga_write(QEMU_VGA_IDX_ENABLE, QEMU_VGA_ENABLE_CLEAR);
     qemu_vga_enabled = 1;
+    memset(qemu_vga_buffers, 0, sizeof(qemu_vga_buffers));
+    // Pages are cleared, along with any pre-rendered picture
+    qemu_vga_splash_height = 0;
+
+    if(8 == bpp) {
+        // Palette mode, load terminal colors into VGA DAC
+        int i;
+        outb(0, VGA_DAC_WRITE_INDEX);
+        for(i = 0; i < QEMU_VGA_TERMINAL_COLORS; i++) {
+            outb(terminal_color_32[i].r32 >> VGA_DAC_SHIFT, VGA_DAC_DATA);
+            outb(terminal_color_32[i].g32 >> VGA_DAC_SHIFT, VGA_DAC_DATA);
+            outb(terminal_color_32[i].b32 >> VGA_DAC_SHIFT, VGA_DAC_DATA);
+        }
+    }
 
     return SUCCESS;
 }
 
+/* int32_t qemu_vga_set_mode(uint16_t xres, uint16_t yres, uint16_t bpp)
+ * @input: xres, yres, bpp - same as qemu_vga_init
+ * @output: ret val - SUCCESS / FAIL
+ *          display mode changed, text of every terminal redrawn
+ * @description: switches display mode at runtime. Double buffering is
+ *     turned off, text and the clock are redrawn (text of terminals not
+ *     on screen once they're shown), anything else
+ *     (pictures, status message, IME) is lost.
+ */
+int32_t qemu_vga_set_mode(uint16_t xres, uint16_t yres, uint16_t bpp) {
+    if(!qemu_vga_enabled) return FAIL;
+    uint32_t flags;
+    cli_and_save(flags);
+    // Mouse cursor is put back with old pitch, then drawn again once done
+    mouse_cursor_enter(MOUSE_CURSOR_ANY_TERMINAL, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    if(FAIL == qemu_vga_init(xres, yres, bpp)) {
+        mouse_cursor_leave();
+        restore_flags(flags);
+        return FAIL;
+    }
+    screen_damage_all();
+
+    // Displayed terminal is redrawn on switch below, others when they're shown
+    int32_t tid;
+    for(tid = 0; tid < TERMINAL_COUNT; tid++) {
+        qemu_vga_text_stale[tid] = QEMU_VGA_ROWS(0, SCREEN_HEIGHT - 1);
+    }
+    qemu_vga_switch_terminal(displayed_terminal_id);
+    restore_flags(flags);
+    status_bar_redraw();
+    mouse_cursor_leave();
+    return SUCCESS;
+}
+
 /* void qemu_vga_pixel_set(uint16_t x, uint16_t y, vga_color_t color)
  * @input: x, y - coordinate
  *         color: to be set for this pixel
@@ -116,16 +367,153 @@ uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp) {
 void qemu_vga_pixel_set(uint16_t x, uint16_t y, vga_color_t color) {
     if(!qemu_vga_enabled) return;
     if(x >= qemu_vga_xres || y >= qemu_vga_yres) return;
-    uint32_t pos = qemu_vga_active_window_addr() + (y * qemu_vga_xres + x) * qemu_vga_bpp / BITS_IN_BYTE;
-
-    // Currently only 32 bit and 16 bit color depth is supported.
-    if(qemu_vga_bpp == 32) {
-        // 32 bit encoding, 0x00RRGGBB
-        *((uint32_t*) pos) = color.val & 0xffffff;
-    } else if(qemu_vga_bpp == 16) {
-        // 16 bit encoding, 5-6-5 as in MP2
-        *((uint16_t*) pos) = color.val & 0xffff;
+    uint32_t offset = y * qemu_vga_pitch + x * qemu_vga_ops->bytes_per_pixel;
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[active_terminal_id];
+    uint32_t pos = qemu_vga_active_window_addr() + offset;
+    uint32_t pos_front = pos;
+
+    if(y < QEMU_VGA_TEXT_AREA_HEIGHT) {
+        qemu_vga_mark_dirty(y, y + 1);
+    } else if(buffer->enabled) {
+        // Status bar and IME are below the text area,
+        // they don't wait for a present, so go onto both pages
+        pos_front = qemu_vga_page_addr(active_terminal_id, buffer->front) + offset;
     }
+
+    qemu_vga_draw_begin(active_terminal_id, x, y, 1, 1);
+    qemu_vga_ops->pixel(pos, color.val);
+    if(pos_front != pos) qemu_vga_ops->pixel(pos_front, color.val);
+    qemu_vga_draw_end();
+}
+
+/* uint32_t qemu_vga_rect_addr(uint16_t x, uint16_t y, uint16_t height, uint32_t* pos_front)
+ * @input: x, y - left top corner of a rectangle on active terminal
+ *         height - height of the rectangle
+ *         pos_front - receives address on the front page, if it needs to be drawn there too
+ * @output: ret val - address of the rectangle on the page being drawn to
+ * @description: the same page rules as qemu_vga_pixel_set, done once per rectangle.
+ *     Text area is marked dirty, rows below it go onto both pages.
+ */
+static uint32_t qemu_vga_rect_addr(uint16_t x, uint16_t y, uint16_t height, uint32_t* pos_front) {
+    uint32_t offset = y * qemu_vga_pitch + x * qemu_vga_ops->bytes_per_pixel;
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[active_terminal_id];
+    uint32_t pos = qemu_vga_active_window_addr() + offset;
+
+    *pos_front = pos;
+    if(y < QEMU_VGA_TEXT_AREA_HEIGHT) {
+        qemu_vga_mark_dirty(y, y + height);
+    } else if(buffer->enabled) {
+        *pos_front = qemu_vga_page_addr(active_terminal_id, buffer->front) + offset;
+    }
+    return pos;
+}
+
+/* void qemu_vga_draw_mask(uint16_t x, uint16_t y, const uint8_t* mask, uint32_t mask_pitch,
+ *                         uint16_t width, uint16_t height, uint16_t pad_left, uint16_t pad_right,
+ *                         vga_color_t fg, vga_color_t bg, uint8_t transparent)
+ * @input: x, y - left top corner of the cell
+ *         mask, mask_pitch - 1 bpp glyph, MSB first, and bytes per line of it
+ *         width, height - size of the glyph
+ *         pad_left, pad_right - background columns around the glyph
+ *         fg, bg - foreground and background color
+ *         transparent - VGA2D_TRANSPARENT to leave background pixels (and padding) alone
+ * @output: glyph drawn on active terminal
+ */
+static void qemu_vga_draw_mask(uint16_t x, uint16_t y, const uint8_t* mask, uint32_t mask_pitch,
+                               uint16_t width, uint16_t height, uint16_t pad_left, uint16_t pad_right,
+                               vga_color_t fg, vga_color_t bg, uint8_t transparent) {
+    if(x + pad_left + width + pad_right > qemu_vga_xres || y + height > qemu_vga_yres) return;
+    uint32_t bytes_per_pixel = qemu_vga_ops->bytes_per_pixel;
+    uint32_t pos_front;
+    uint32_t pos = qemu_vga_rect_addr(x, y, height, &pos_front);
+
+    qemu_vga_draw_begin(active_terminal_id, x, y, pad_left + width + pad_right, height);
+    do {
+        uint32_t glyph = pos + pad_left * bytes_per_pixel;
+        qemu_vga_ops->expand(glyph, qemu_vga_pitch, mask, mask_pitch,
+            width, height, fg.val, bg.val, transparent);
+        if(VGA2D_OPAQUE == transparent) {
+            if(pad_left) qemu_vga_ops->fill(pos, qemu_vga_pitch, pad_left, height, bg.val);
+            if(pad_right) qemu_vga_ops->fill(glyph + width * bytes_per_pixel, qemu_vga_pitch,
+                pad_right, height, bg.val);
+        }
+        if(pos == pos_front) break;
+        pos = pos_front;
+    } while(1);
+    qemu_vga_draw_end();
+}
+
+/* void qemu_vga_wide_plane_set(uint16_t x, uint16_t y, uint16_t code)
+ * @input: x, y - left top corner coordinate of a character
+ *         code - Chinese character there, 0 for none
+ * @output: wide plane of active terminal updated, if x, y is in text area
+ */
+static void qemu_vga_wide_plane_set(uint16_t x, uint16_t y, uint16_t code) {
+    uint16_t grid_x = x / FONT_ACTUAL_WIDTH;
+    uint16_t grid_y = y / FONT_ACTUAL_HEIGHT;
+    if(grid_x >= SCREEN_WIDTH || grid_y >= SCREEN_HEIGHT) return;
+    qemu_vga_wide_plane[active_terminal_id][grid_y][grid_x] = code;
+}
+
+/* uint16_t* qemu_vga_wide_row(int32_t tid, uint8_t grid_y)
+ * @input: tid - terminal id
+ *         grid_y - Y on text mode grid, range 0-24
+ * @output: ret val - Chinese characters on that row, 0 for none
+ */
+uint16_t* qemu_vga_wide_row(int32_t tid, uint8_t grid_y) {
+    return qemu_vga_wide_plane[tid][grid_y];
+}
+
+/* void qemu_vga_wide_mask(uint16_t code, uint8_t* mask)
+ * @input: code - Unicode of Chinese character
+ *         mask - CHINESE_FONT_GLYPH_SIZE bytes to receive the glyph
+ * @output: glyph laid out as a 1 bpp mask, MSB first, for vga2d
+ */
+static void qemu_vga_wide_mask(uint16_t code, uint8_t* mask) {
+    uint16_t font[CHINESE_FONT_HEIGHT];
+    int i;
+    glyph_cache_get(code, font);
+    for(i = 0; i < CHINESE_FONT_HEIGHT; i++) {
+        mask[i * CHINESE_FONT_ROW_SIZE] = font[i] >> 8;
+        mask[i * CHINESE_FONT_ROW_SIZE + 1] = font[i] & 0xff;
+    }
+}
+
+/* void qemu_vga_put_wide(uint16_t x, uint16_t y, uint16_t code, vga_color_t fg, vga_color_t bg)
+ * @input: x, y - left top corner coordinate for the character
+ *         code - Unicode of Chinese character to be displayed
+ *         fg, bg - foreground and background color
+ * @output: character written at specified position, 2 cells wide
+ * @description: draws an already decoded Chinese character.
+ */
+void qemu_vga_put_wide(uint16_t x, uint16_t y, uint16_t code, vga_color_t fg, vga_color_t bg) {
+    if(!qemu_vga_enabled) return;
+    uint8_t mask[CHINESE_FONT_GLYPH_SIZE];
+    qemu_vga_wide_mask(code, mask);
+    qemu_vga_draw_mask(x, y, mask, CHINESE_FONT_ROW_SIZE, CHINESE_FONT_WIDTH, CHINESE_FONT_HEIGHT,
+        CHINESE_FONT_LEFT, CHINESE_FONT_RIGHT, fg, bg, VGA2D_OPAQUE);
+}
+
+/* void qemu_vga_draw_glyph(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color_t bg)
+ * @input: x, y - left top corner coordinate for the character
+ *         ch - code page character to draw
+ *         fg, bg - foreground and background color
+ * @output: character cell drawn, on both pages if below text area
+ *     and double buffered, like qemu_vga_pixel_set
+ */
+static void qemu_vga_draw_glyph(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color_t bg) {
+    qemu_vga_draw_mask(x, y, font_data[ch], 1, FONT_DATA_WIDTH, FONT_DATA_HEIGHT,
+        0, FONT_ACTUAL_WIDTH - FONT_DATA_WIDTH, fg, bg, VGA2D_OPAQUE);
+}
+
+/* uint8_t qemu_vga_text_row_deferred(uint16_t y)
+ * @input: y - top of a character on screen, in pixels
+ * @output: ret val - 1 if rendering is skipped, see qemu_vga_text_deferred.
+ *     Rows below text area are always rendered.
+ */
+static uint8_t qemu_vga_text_row_deferred(uint16_t y) {
+    if(y >= QEMU_VGA_TEXT_AREA_HEIGHT) return 0;
+    return qemu_vga_text_deferred(y / FONT_ACTUAL_HEIGHT, y / FONT_ACTUAL_HEIGHT);
 }
 
 /* void qemu_vga_putc(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color_t bg)
@@ -139,7 +527,6 @@ void qemu_vga_pixel_set(uint16_t x, uint16_t y, vga_color_t color) {
  */
 void qemu_vga_putc(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color_t bg) {
     if(!qemu_vga_enabled) return;
-    int i, j;
     volatile utf8_state_t* utf8_state = &terminals[active_terminal_id].utf8_state;
 
     if(!(UTF8_MASK & ch)) {
@@ -182,48 +569,28 @@ void qemu_vga_putc(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color
             utf8_state->have = 0;
 
             if(code >= CHINESE_ENCODE_START && code < CHINESE_ENCODE_END) {
-                // This is a Chinese character, load font and print it
-                uint16_t* font = (uint16_t*) (CHINESE_FONT_DATA + (code - CHINESE_ENCODE_START)
-                    * (CHINESE_FONT_HEIGHT * CHINESE_FONT_WIDTH / 8));
-
-                // Draw the character
-                for(i = 0; i < CHINESE_FONT_HEIGHT; i++) {
-                    uint16_t font_line = (font[i] >> 8) | (font[i] << 8);
-                    for(j = 0; j < CHINESE_FONT_WIDTH; j++) {
-                        uint16_t mask = 1 << (15 - j);
-                        if(font_line & mask) {
-                            qemu_vga_pixel_set(x + CHINESE_FONT_LEFT + j, y + i, fg);
-                        } else {
-                            qemu_vga_pixel_set(x + CHINESE_FONT_LEFT + j, y + i, bg);
-                        }
-                    }
-                    for(j = 0; j < CHINESE_FONT_LEFT; j++) {
-                        qemu_vga_pixel_set(x + j, y + i, bg);
-                    }
-                    for(j = 0; j < CHINESE_FONT_RIGHT; j++) {
-                        qemu_vga_pixel_set(x + CHINESE_FONT_LEFT + CHINESE_FONT_WIDTH + j, y + i, bg);
-                    }
-                }
+                // This is a Chinese character, remember it and print it
+                qemu_vga_wide_plane_set(x, y, code);
+                if(!qemu_vga_text_row_deferred(y)) qemu_vga_put_wide(x, y, code, fg, bg);
             }
         }
     } else {
         // ASCII character, simply print it out
-        for(i = 0; i < FONT_DATA_HEIGHT; i++) {
-            for(j = 0; j < FONT_DATA_WIDTH; j++) {
-                uint8_t mask = 1 << (7 - j);
-                if(font_data[ch][i] & mask) {
-                    qemu_vga_pixel_set(x + j, y + i, fg);
-                } else {
-                    qemu_vga_pixel_set(x + j, y + i, bg);
-                }
-            }
-            for(j = FONT_DATA_WIDTH; j < FONT_ACTUAL_WIDTH; j++) {
-                qemu_vga_pixel_set(x + j, y + i, bg);
-            }
-        }
+        qemu_vga_wide_plane_set(x, y, 0);
+        if(!qemu_vga_text_row_deferred(y)) qemu_vga_draw_glyph(x, y, ch, fg, bg);
     }
 }
 
+/* void qemu_vga_putc_attr(uint16_t x, uint16_t y, uint8_t ch, uint8_t attrib)
+ * @input: x, y - left top corner coordinate for the character
+ *         ch - character to be displayed
+ *         attrib - text mode attribute byte, foreground in low 4 bits
+ * @output: character written at specified position
+ */
+void qemu_vga_putc_attr(uint16_t x, uint16_t y, uint8_t ch, uint8_t attrib) {
+    qemu_vga_putc(x, y, ch, qemu_vga_attrs[attrib].fg, qemu_vga_attrs[attrib].bg);
+}
+
 /* void qemu_vga_putc_transparent(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg)
  * @input: x, y - left top corner coordinate for the character
  *         ch - character to be displayed
@@ -235,7 +602,6 @@ void qemu_vga_putc(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color
  */
 void qemu_vga_putc_transparent(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg) {
     if(!qemu_vga_enabled) return;
-    int i, j;
     volatile utf8_state_t* utf8_state = &terminals[active_terminal_id].utf8_state;
 
     if(!(UTF8_MASK & ch)) {
@@ -279,32 +645,129 @@ void qemu_vga_putc_transparent(uint16_t x, uint16_t y, uint8_t ch, vga_color_t f
 
             if(code >= CHINESE_ENCODE_START && code < CHINESE_ENCODE_END) {
                 // This is a Chinese character, load font and print it
-                uint16_t* font = (uint16_t*) (CHINESE_FONT_DATA + (code - CHINESE_ENCODE_START)
-                    * (CHINESE_FONT_HEIGHT * CHINESE_FONT_WIDTH / 8));
-
-                // Draw the character
-                for(i = 0; i < CHINESE_FONT_HEIGHT; i++) {
-                    uint16_t font_line = (font[i] >> 8) | (font[i] << 8);
-                    for(j = 0; j < CHINESE_FONT_WIDTH; j++) {
-                        uint16_t mask = 1 << (15 - j);
-                        if(font_line & mask) {
-                            qemu_vga_pixel_set(x + CHINESE_FONT_LEFT + j, y + i, fg);
-                        }
-                    }
-                }
+                uint8_t mask[CHINESE_FONT_GLYPH_SIZE];
+                qemu_vga_wide_mask(code, mask);
+                qemu_vga_draw_mask(x, y, mask, CHINESE_FONT_ROW_SIZE,
+                    CHINESE_FONT_WIDTH, CHINESE_FONT_HEIGHT, CHINESE_FONT_LEFT, CHINESE_FONT_RIGHT,
+                    fg, fg, VGA2D_TRANSPARENT);
             }
         }
     } else {
         // ASCII character, simply print it out
-        for(i = 0; i < FONT_DATA_HEIGHT; i++) {
-            for(j = 0; j < FONT_DATA_WIDTH; j++) {
-                uint8_t mask = 1 << (7 - j);
-                if(font_data[ch][i] & mask) {
-                    qemu_vga_pixel_set(x + j, y + i, fg);
-                }
-            }
+        qemu_vga_draw_mask(x, y, font_data[ch], 1, FONT_DATA_WIDTH, FONT_DATA_HEIGHT,
+            0, 0, fg, fg, VGA2D_TRANSPARENT);
+    }
+}
+
+/* void qemu_vga_draw_cells(uint8_t grid_x, uint8_t grid_y, uint8_t count)
+ * @input: grid_x, grid_y - text mode grid coordinate of the first cell
+ *         count - number of consecutive cells on that row to draw
+ * @output: cells redrawn on QEMU VGA from the text mode buffer
+ * @description: renders a span of cells straight from video_mem.
+ */
+void qemu_vga_draw_cells(uint8_t grid_x, uint8_t grid_y, uint8_t count) {
+    if(grid_y < SCREEN_HEIGHT && qemu_vga_text_deferred(grid_y, grid_y)) return;
+    qemu_vga_draw_cell_data(grid_x, grid_y,
+        (uint8_t*) (video_mem + ((NUM_COLS * grid_y + grid_x) << 1)), count);
+}
+
+/* void qemu_vga_draw_cell_data(uint8_t grid_x, uint8_t grid_y, const uint8_t* cell, uint8_t count)
+ * @input: grid_x, grid_y - text mode grid coordinate of the first cell
+ *         cell - character / attribute pairs, laid out like text mode buffer
+ *         count - number of consecutive cells on that row to draw
+ * @output: cells drawn on QEMU VGA
+ * @description: renders a span of cells from memory. Each cell is a
+ *     color expansion of its glyph plus a fill of the gap column.
+ *     Characters are drawn as raw code page glyphs, the same way VGA text
+ *     mode would show them; no UTF-8 decoding is done here.
+ */
+void qemu_vga_draw_cell_data(uint8_t grid_x, uint8_t grid_y, const uint8_t* cell, uint8_t count) {
+    if(!qemu_vga_enabled) return;
+    if(grid_x >= SCREEN_WIDTH || grid_y >= SCREEN_HEIGHT) return;
+    if(grid_x + count > SCREEN_WIDTH) count = SCREEN_WIDTH - grid_x;
+
+    uint32_t glyph_size = FONT_DATA_WIDTH * qemu_vga_ops->bytes_per_pixel;
+    uint32_t cell_size = FONT_ACTUAL_WIDTH * qemu_vga_ops->bytes_per_pixel;
+    uint32_t pixel = qemu_vga_active_window_addr()
+        + grid_y * FONT_ACTUAL_HEIGHT * qemu_vga_pitch + grid_x * cell_size;
+    int k;
+
+    qemu_vga_mark_dirty(grid_y * FONT_ACTUAL_HEIGHT, (grid_y + 1) * FONT_ACTUAL_HEIGHT);
+    qemu_vga_draw_begin(active_terminal_id, grid_x * FONT_ACTUAL_WIDTH, grid_y * FONT_ACTUAL_HEIGHT,
+        count * FONT_ACTUAL_WIDTH, FONT_ACTUAL_HEIGHT);
+
+    // Color depth is taken care of by the mode's routines
+    for(k = 0; k < count; k++) {
+        uint32_t fg = qemu_vga_attrs[cell[(k << 1) + 1]].fg.val;
+        uint32_t bg = qemu_vga_attrs[cell[(k << 1) + 1]].bg.val;
+        qemu_vga_ops->expand(pixel, qemu_vga_pitch, font_data[cell[k << 1]], 1,
+            FONT_DATA_WIDTH, FONT_DATA_HEIGHT, fg, bg, VGA2D_OPAQUE);
+        qemu_vga_ops->fill(pixel + glyph_size, qemu_vga_pitch,
+            FONT_ACTUAL_WIDTH - FONT_DATA_WIDTH, FONT_DATA_HEIGHT, bg);
+        pixel += cell_size;
+    }
+    qemu_vga_draw_end();
+}
+
+/* void qemu_vga_draw_text_row(uint8_t grid_y, const uint8_t* cells, const uint16_t* wide)
+ * @input: grid_y - row on text mode grid to draw on
+ *         cells - character / attribute pairs of the whole row
+ *         wide - Chinese characters of the row at their left cell, 0 for none
+ * @output: the row drawn on QEMU VGA
+ * @description: redraws a row of text kept in memory, used for
+ *     scrollback and redrawing after a mode switch.
+ */
+void qemu_vga_draw_text_row(uint8_t grid_y, const uint8_t* cells, const uint16_t* wide) {
+    int x;
+    qemu_vga_draw_cell_data(0, grid_y, cells, SCREEN_WIDTH);
+    for(x = 0; x < SCREEN_WIDTH; x++) {
+        if(!wide[x]) continue;
+        qemu_vga_put_wide(x * FONT_ACTUAL_WIDTH, grid_y * FONT_ACTUAL_HEIGHT, wide[x],
+            qemu_vga_attrs[cells[(x << 1) + 1]].fg, qemu_vga_attrs[cells[(x << 1) + 1]].bg);
+    }
+}
+
+/* void qemu_vga_render_char(uint8_t* buf, uint32_t pitch, uint8_t ch, vga_color_t fg, vga_color_t bg)
+ * @input: buf - memory to draw into, laid out with current color depth
+ *         pitch - bytes per line of buf
+ *         ch - code page character to draw
+ *         fg, bg - foreground and background color
+ * @output: character drawn at the start of buf
+ * @description: renders a character cell into an off-screen buffer,
+ *     to be copied onto the screen later with qemu_vga_blit_all_terminals.
+ */
+void qemu_vga_render_char(uint8_t* buf, uint32_t pitch, uint8_t ch, vga_color_t fg, vga_color_t bg) {
+    qemu_vga_ops->expand((uint32_t) buf, pitch, font_data[ch], 1,
+        FONT_DATA_WIDTH, FONT_DATA_HEIGHT, fg.val, bg.val, VGA2D_OPAQUE);
+    qemu_vga_ops->fill((uint32_t) buf + FONT_DATA_WIDTH * qemu_vga_ops->bytes_per_pixel, pitch,
+        FONT_ACTUAL_WIDTH - FONT_DATA_WIDTH, FONT_DATA_HEIGHT, bg.val);
+}
+
+/* void qemu_vga_blit_all_terminals(const uint8_t* src, uint32_t pitch,
+ *                                  uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+ * @input: src, pitch - off-screen pixels, and bytes per line of them
+ *         x, y, width, height - rectangle on screen to copy to
+ * @output: rectangle updated on every terminal, on both pages if double buffered
+ * @description: copies a pre-rendered strip onto all terminals, for things
+ *     shown everywhere like the status bar. Doesn't touch active_terminal_id,
+ *     so it's safe to run with interrupts on.
+ */
+void qemu_vga_blit_all_terminals(const uint8_t* src, uint32_t pitch,
+                                 uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    if(!qemu_vga_enabled) return;
+    if(x + width > qemu_vga_xres || y + height > qemu_vga_yres) return;
+    uint32_t offset = y * qemu_vga_pitch + x * qemu_vga_ops->bytes_per_pixel;
+    uint32_t row_bytes = width * qemu_vga_ops->bytes_per_pixel;
+    int tid, page;
+    qemu_vga_draw_begin(MOUSE_CURSOR_ANY_TERMINAL, x, y, width, height);
+    for(tid = 0; tid < TERMINAL_COUNT; tid++) {
+        for(page = 0; page < QEMU_VGA_PAGE_COUNT; page++) {
+            if(page != qemu_vga_buffers[tid].front && !qemu_vga_buffers[tid].enabled) continue;
+            vga2d_copy(qemu_vga_page_addr(tid, page) + offset, qemu_vga_pitch,
+                (uint32_t) src, pitch, row_bytes, height);
         }
     }
+    qemu_vga_draw_end();
 }
 
 /* void qemu_vga_clear()
@@ -313,8 +776,13 @@ void qemu_vga_putc_transparent(uint16_t x, uint16_t y, uint8_t ch, vga_color_t f
  */
 void qemu_vga_clear() {
     if(!qemu_vga_enabled) return;
-    memset((char*) qemu_vga_active_window_addr(), 0,
-        FONT_ACTUAL_HEIGHT * SCREEN_HEIGHT * qemu_vga_xres * qemu_vga_bpp / BITS_IN_BYTE);
+    memset(qemu_vga_wide_plane[active_terminal_id], 0, sizeof(qemu_vga_wide_plane[0]));
+    if(qemu_vga_text_deferred(0, SCREEN_HEIGHT - 1)) return;
+    qemu_vga_mark_dirty(0, QEMU_VGA_TEXT_AREA_HEIGHT);
+    qemu_vga_draw_begin(active_terminal_id, 0, 0, qemu_vga_xres, QEMU_VGA_TEXT_AREA_HEIGHT);
+    qemu_vga_ops->fill(qemu_vga_active_window_addr(), qemu_vga_pitch,
+        qemu_vga_xres, QEMU_VGA_TEXT_AREA_HEIGHT, 0);
+    qemu_vga_draw_end();
 }
 
 /* void qemu_vga_clear_row(uint8_t grid_y)
@@ -324,23 +792,46 @@ void qemu_vga_clear() {
  */
 void qemu_vga_clear_row(uint8_t grid_y) {
     if(!qemu_vga_enabled) return;
-    int pos_start = grid_y * FONT_ACTUAL_HEIGHT * qemu_vga_xres * qemu_vga_bpp / BITS_IN_BYTE;
-    memset((char*) (pos_start + qemu_vga_active_window_addr()), 0,
-        FONT_ACTUAL_HEIGHT * qemu_vga_xres * qemu_vga_bpp / BITS_IN_BYTE);
+    int pos_start = grid_y * FONT_ACTUAL_HEIGHT * qemu_vga_pitch;
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[active_terminal_id];
+    if(grid_y < SCREEN_HEIGHT) {
+        memset(qemu_vga_wide_plane[active_terminal_id][grid_y], 0, sizeof(qemu_vga_wide_plane[0][0]));
+        if(qemu_vga_text_deferred(grid_y, grid_y)) return;
+    }
+    qemu_vga_draw_begin(active_terminal_id, 0, grid_y * FONT_ACTUAL_HEIGHT, qemu_vga_xres, FONT_ACTUAL_HEIGHT);
+    qemu_vga_ops->fill(pos_start + qemu_vga_active_window_addr(), qemu_vga_pitch,
+        qemu_vga_xres, FONT_ACTUAL_HEIGHT, 0);
+    if(grid_y < SCREEN_HEIGHT) {
+        qemu_vga_mark_dirty(grid_y * FONT_ACTUAL_HEIGHT, (grid_y + 1) * FONT_ACTUAL_HEIGHT);
+    } else if(buffer->enabled) {
+        // Bars below text area are kept the same on both pages
+        qemu_vga_ops->fill(pos_start + qemu_vga_page_addr(active_terminal_id, buffer->front),
+            qemu_vga_pitch, qemu_vga_xres, FONT_ACTUAL_HEIGHT, 0);
+    }
+    qemu_vga_draw_end();
 }
 
-/* void qemu_vga_roll_up()
- * @output: screen rolls up one row.
+/* void qemu_vga_roll_up(uint8_t top, uint8_t bottom)
+ * @input: top, bottom - rows [top, bottom] on text mode grid to roll
+ * @output: these rows roll up one row, the bottom one is left unchanged.
  * @description: as above. Note that if there's extra space below the text area,
  *     they will not be touched. Useful for status bars.
  */
-void qemu_vga_roll_up() {
+void qemu_vga_roll_up(uint8_t top, uint8_t bottom) {
     if(!qemu_vga_enabled) return;
-    int pos_offset = FONT_ACTUAL_HEIGHT * qemu_vga_xres * qemu_vga_bpp / BITS_IN_BYTE;
-    int len_roll = (SCREEN_HEIGHT - 1) * pos_offset;
-    memcpy((char*) qemu_vga_active_window_addr(),
-        (char*) (qemu_vga_active_window_addr() + pos_offset),
-        len_roll);
+    if(top >= bottom || bottom >= SCREEN_HEIGHT) return;
+    memcpy(qemu_vga_wide_plane[active_terminal_id][top], qemu_vga_wide_plane[active_terminal_id][top + 1],
+        (bottom - top) * sizeof(qemu_vga_wide_plane[0][0]));
+    // Hidden window isn't scrolled, these rows are drawn again when shown
+    if(qemu_vga_text_deferred(top, bottom)) return;
+    int pos_offset = FONT_ACTUAL_HEIGHT * qemu_vga_pitch;
+    qemu_vga_mark_dirty(top * FONT_ACTUAL_HEIGHT, (bottom + 1) * FONT_ACTUAL_HEIGHT);
+    qemu_vga_draw_begin(active_terminal_id, 0, top * FONT_ACTUAL_HEIGHT,
+        qemu_vga_xres, (bottom - top + 1) * FONT_ACTUAL_HEIGHT);
+    vga2d_copy(qemu_vga_active_window_addr() + top * pos_offset, qemu_vga_pitch,
+        qemu_vga_active_window_addr() + (top + 1) * pos_offset, qemu_vga_pitch,
+        qemu_vga_pitch, (bottom - top) * FONT_ACTUAL_HEIGHT);
+    qemu_vga_draw_end();
     if(qemu_vga_cursor_y > 0) qemu_vga_cursor_y -= 1;
 }
 
@@ -376,11 +867,11 @@ void qemu_vga_set_cursor_pos(uint8_t x, uint8_t y) {
 
 /* vga_color_t qemu_vga_get_terminal_color(uint8_t color)
  * @input: color - color code for console, only last 8 bit used
- * @output: ret val - color in 16 bit or 32 bit, depending on init setting
+ * @output: ret val - color in current color depth
  * @description: translates terminal color to console color
  */
 vga_color_t qemu_vga_get_terminal_color(uint8_t color) {
-    return (qemu_vga_bpp == 16 ? terminal_color_16 : terminal_color_32)[(color & 0xff)];
+    return qemu_vga_ops->palette[color & (QEMU_VGA_TERMINAL_COLORS - 1)];
 }
 
 /* void qemu_vga_show_picture(uint16_t width, uint16_t height, uint8_t bpp, uint8_t* data)
@@ -396,17 +887,240 @@ void qemu_vga_show_picture(uint16_t width, uint16_t height, uint8_t bpp, uint8_t
     if(width > qemu_vga_xres || height > qemu_vga_yres || bpp != qemu_vga_bpp) return;
 
     // Copy over the image, row by row
-    int row = 0;
+    uint32_t row_bytes = width * bpp / BITS_IN_BYTE;
+    qemu_vga_mark_dirty(0, height);
+    qemu_vga_draw_begin(active_terminal_id, 0, 0, width, height);
+    vga2d_copy(qemu_vga_active_window_addr(), qemu_vga_pitch,
+        (uint32_t) data, row_bytes, row_bytes, height);
+    qemu_vga_draw_end();
+
+    qemu_vga_skip_picture(height);
+}
+
+/* void qemu_vga_show_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+ *                                 const uint8_t* data, uint32_t len)
+ * @input: width, height, bpp - same as qemu_vga_show_picture
+ *         data, len - LZSS compressed image data
+ * @output: picture drawn on left top corner of screen,
+ *          cursor moved downwards if overlapping with picture
+ * @description: same as qemu_vga_show_picture, but decompresses the image
+ *     row by row directly into the linear buffer.
+ */
+void qemu_vga_show_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+                                const uint8_t* data, uint32_t len) {
+    // Static as the 4KB LZSS window is too large for kernel stack
+    static lzss_stream_t stream;
+    if(!qemu_vga_enabled) return;
+    if(width > qemu_vga_xres || height > qemu_vga_yres || bpp != qemu_vga_bpp) return;
+
+    lzss_init(&stream, data, len);
+    qemu_vga_mark_dirty(0, height);
+    int i;
+    uint32_t row = qemu_vga_active_window_addr();
+    qemu_vga_draw_begin(active_terminal_id, 0, 0, width, height);
+    for(i = 0; i < height; i++) {
+        if(lzss_read(&stream, (uint8_t*) row, width * bpp / BITS_IN_BYTE)
+            < width * bpp / BITS_IN_BYTE) break;
+        row += qemu_vga_pitch;
+    }
+    qemu_vga_draw_end();
+
+    qemu_vga_skip_picture(height);
+}
+
+/* void qemu_vga_preload_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+ *                                    const uint8_t* data, uint32_t len)
+ * @input: width, height, bpp - same as qemu_vga_show_picture
+ *         data, len - LZSS compressed image data
+ * @output: picture drawn on left top corner of every terminal,
+ *          qemu_vga_splash_height set to its height
+ * @description: decompresses a picture once at boot onto the first terminal,
+ *     then copies it to the others. Terminals only move their cursor below
+ *     it as they start, see qemu_vga_skip_picture.
+ */
+void qemu_vga_preload_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+                                   const uint8_t* data, uint32_t len) {
+    static lzss_stream_t stream;
+    if(!qemu_vga_enabled) return;
+    if(width > qemu_vga_xres || height > QEMU_VGA_TEXT_AREA_HEIGHT || bpp != qemu_vga_bpp) return;
+
+    uint32_t row_bytes = width * bpp / BITS_IN_BYTE;
+    uint32_t first = qemu_vga_page_addr(0, qemu_vga_buffers[0].front);
+    uint32_t row = first;
     int i;
+    lzss_init(&stream, data, len);
+    qemu_vga_draw_begin(MOUSE_CURSOR_ANY_TERMINAL, 0, 0, width, height);
     for(i = 0; i < height; i++) {
-        memcpy((char*) (qemu_vga_active_window_addr() + row),
-            (char*) (data + i * width * bpp / BITS_IN_BYTE), width * bpp / BITS_IN_BYTE);
-        row += qemu_vga_xres * qemu_vga_bpp / BITS_IN_BYTE;
+        if(lzss_read(&stream, (uint8_t*) row, row_bytes) < row_bytes) break;
+        row += qemu_vga_pitch;
+    }
+    for(i = 1; i < TERMINAL_COUNT; i++) {
+        vga2d_copy(qemu_vga_page_addr(i, qemu_vga_buffers[i].front), qemu_vga_pitch,
+            first, qemu_vga_pitch, row_bytes, height);
     }
+    qemu_vga_draw_end();
+    qemu_vga_splash_height = height;
+}
 
-    // Move cursor downwards to avoid overlapping with picture
+/* void qemu_vga_skip_picture(uint16_t height)
+ * @input: height - height of picture on left top corner of screen
+ * @output: cursor moved downwards if overlapping with picture
+ * @description: keeps text from being printed over a picture.
+ */
+void qemu_vga_skip_picture(uint16_t height) {
     if(terminals[active_terminal_id].screen_y < height / FONT_ACTUAL_HEIGHT) {
         terminals[active_terminal_id].screen_y = height / FONT_ACTUAL_HEIGHT + 1;
         terminals[active_terminal_id].screen_x = 0;
     }
 }
+
+/* void qemu_vga_wait_vsync()
+ * @output: returns at the start of a vertical retrace
+ * @description: polls the retrace bit of VGA input status register 1. Gives up
+ *     after a while, in case the adapter doesn't emulate the bit.
+ */
+void qemu_vga_wait_vsync() {
+    int i;
+    // Let the current retrace finish, so we catch the start of the next one
+    for(i = 0; i < QEMU_VGA_VSYNC_TIMEOUT && (inb(VGA_REG_INPUT_STATUS) & VGA_VRETRACE); i++);
+    for(i = 0; i < QEMU_VGA_VSYNC_TIMEOUT && !(inb(VGA_REG_INPUT_STATUS) & VGA_VRETRACE); i++);
+}
+
+/* int32_t qemu_vga_double_buffer_enable(int32_t tid)
+ * @input: tid - terminal id
+ * @output: ret val - SUCCESS / FAIL
+ *          further drawing on that terminal goes to its back page
+ * @description: starts double buffering with a back page
+ *     that is identical to what's currently shown.
+ */
+int32_t qemu_vga_double_buffer_enable(int32_t tid) {
+    if(!qemu_vga_enabled) return FAIL;
+    if(tid < 0 || tid >= TERMINAL_COUNT) return FAIL;
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[tid];
+    if(buffer->enabled) return SUCCESS;
+
+    // Back page starts from complete text, without the mouse cursor
+    qemu_vga_text_flush(tid);
+    mouse_cursor_enter(tid, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    vga2d_copy(qemu_vga_page_addr(tid, !buffer->front), qemu_vga_pitch,
+        qemu_vga_page_addr(tid, buffer->front), qemu_vga_pitch,
+        qemu_vga_pitch, qemu_vga_yres);
+    mouse_cursor_leave();
+    buffer->dirty_top = qemu_vga_yres;
+    buffer->dirty_bottom = 0;
+    buffer->frames = 0;
+    buffer->fps = 0;
+    buffer->fps_start = pit_timer;
+    buffer->enabled = 1;
+    return SUCCESS;
+}
+
+/* int32_t qemu_vga_double_buffer_disable(int32_t tid)
+ * @input: tid - terminal id
+ * @output: ret val - SUCCESS / FAIL
+ *          further drawing on that terminal goes directly onto screen
+ * @description: presents the last frame, then stops double buffering.
+ */
+int32_t qemu_vga_double_buffer_disable(int32_t tid) {
+    if(tid < 0 || tid >= TERMINAL_COUNT) return FAIL;
+    if(!qemu_vga_buffers[tid].enabled) return SUCCESS;
+    qemu_vga_present(tid);
+    qemu_vga_buffers[tid].enabled = 0;
+    return SUCCESS;
+}
+
+/* int32_t qemu_vga_present(int32_t tid)
+ * @input: tid - terminal id
+ * @output: ret val - SUCCESS / FAIL
+ *          back page of that terminal becomes the front page
+ * @description: flips pages by changing the Y display offset, on vertical
+ *     retrace if the terminal is on screen, so the frame doesn't tear.
+ *     Lines drawn since last present are then copied onto the new back page,
+ *     so programs can keep drawing incrementally. Also counts frames per second.
+ */
+int32_t qemu_vga_present(int32_t tid) {
+    if(!qemu_vga_enabled) return FAIL;
+    if(tid < 0 || tid >= TERMINAL_COUNT) return FAIL;
+    qemu_vga_buffer_t* buffer = &qemu_vga_buffers[tid];
+    if(!buffer->enabled) return FAIL;
+
+    if(tid == displayed_terminal_id) qemu_vga_wait_vsync();
+    // Mouse cursor is taken off the old front page, so it isn't left
+    // on the new back page, and drawn on the new front page after copying
+    mouse_cursor_enter(tid, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    buffer->front = !buffer->front;
+    if(tid == displayed_terminal_id) qemu_vga_switch_terminal(tid);
+
+    if(buffer->dirty_top < buffer->dirty_bottom) {
+        uint32_t line_size = qemu_vga_pitch;
+        vga2d_copy(qemu_vga_page_addr(tid, !buffer->front) + buffer->dirty_top * line_size, line_size,
+            qemu_vga_page_addr(tid, buffer->front) + buffer->dirty_top * line_size, line_size,
+            line_size, buffer->dirty_bottom - buffer->dirty_top);
+        screen_damage(tid, 0, buffer->dirty_top, qemu_vga_xres, buffer->dirty_bottom - buffer->dirty_top);
+    }
+    mouse_cursor_leave();
+    buffer->dirty_top = qemu_vga_yres;
+    buffer->dirty_bottom = 0;
+
+    // Update frame rate about once per second
+    buffer->frames++;
+    uint32_t elapsed = pit_timer - buffer->fps_start;
+    if(elapsed >= PIT_FREQ) {
+        buffer->fps = buffer->frames * PIT_FREQ / elapsed;
+        buffer->frames = 0;
+        buffer->fps_start = pit_timer;
+    }
+    return SUCCESS;
+}
+
+/* int32_t qemu_vga_open(int32_t* inode, char* filename)
+ * @input: all ignored
+ * @output: ret val - SUCCESS / FAIL
+ * @description: opens a handle for controlling double buffering
+ *     of the current terminal.
+ */
+int32_t qemu_vga_open(int32_t* inode, char* filename) {
+    if(!qemu_vga_enabled) return FAIL;
+    *inode = active_terminal_id;
+    return SUCCESS;
+}
+
+/* int32_t qemu_vga_ioctl(int32_t* inode, uint32_t* offset, int32_t op)
+ * @input: inode - terminal this handle was opened on
+ *         op - one of QEMU_VGA_IOCTL_*
+ * @output: ret val - frame rate for QEMU_VGA_IOCTL_GET_FPS,
+ *                    SUCCESS / FAIL for the others
+ * @description: enables / disables double buffering, presents a frame,
+ *     reads back the frame rate, or changes color depth.
+ */
+int32_t qemu_vga_ioctl(int32_t* inode, uint32_t* offset, int32_t op) {
+    switch(op) {
+        case QEMU_VGA_IOCTL_DOUBLE_BUFFER_ON:
+            return qemu_vga_double_buffer_enable(*inode);
+        case QEMU_VGA_IOCTL_DOUBLE_BUFFER_OFF:
+            return qemu_vga_double_buffer_disable(*inode);
+        case QEMU_VGA_IOCTL_PRESENT:
+            return qemu_vga_present(*inode);
+        case QEMU_VGA_IOCTL_GET_FPS:
+            if(!qemu_vga_buffers[*inode].enabled) return FAIL;
+            return qemu_vga_buffers[*inode].fps;
+        case QEMU_VGA_IOCTL_DEPTH_8:
+            return qemu_vga_set_mode(qemu_vga_xres, qemu_vga_yres, 8);
+        case QEMU_VGA_IOCTL_DEPTH_16:
+            return qemu_vga_set_mode(qemu_vga_xres, qemu_vga_yres, 16);
+        case QEMU_VGA_IOCTL_DEPTH_32:
+            return qemu_vga_set_mode(qemu_vga_xres, qemu_vga_yres, 32);
+        default:
+            return FAIL;
+    }
+}
+
+/* int32_t qemu_vga_close(int32_t* inode)
+ * @input: inode - terminal this handle was opened on
+ * @output: ret val - SUCCESS / FAIL
+ * @description: turns double buffering off, so the terminal doesn't
+ *     stay frozen on the last presented frame after the program exits.
+ */
+int32_t qemu_vga_close(int32_t* inode) {
+    return qemu_vga_double_buffer_disable(*inode);
+}
@@ -3,6 +3,7 @@
 
 #include "../lib/lib.h"
 #include "vga_text.h"
+#include "../fs/unified_fs.h"
 
 #define QEMU_VGA_PORT_INDEX 0x01ce
 #define QEMU_VGA_PORT_DATA 0x01cf
@@ -20,6 +21,31 @@
 
 #define QEMU_VGA_BANK_SIZE 0x1000000
 
+// Each terminal has a front and a back page for double buffering
+#define QEMU_VGA_PAGE_COUNT 2
+#define QEMU_VGA_TEXT_AREA_HEIGHT (SCREEN_HEIGHT * FONT_ACTUAL_HEIGHT)
+// Bits of text rows [top, bottom]
+#define QEMU_VGA_ROWS(top, bottom) ((2u << (bottom)) - (1u << (top)))
+
+#define VGA_REG_INPUT_STATUS 0x3da
+#define VGA_VRETRACE 0x08
+#define QEMU_VGA_VSYNC_TIMEOUT 100000
+
+#define QEMU_VGA_IOCTL_DOUBLE_BUFFER_ON 1
+#define QEMU_VGA_IOCTL_DOUBLE_BUFFER_OFF 2
+#define QEMU_VGA_IOCTL_PRESENT 3
+#define QEMU_VGA_IOCTL_GET_FPS 4
+// Change color depth, keeping resolution
+#define QEMU_VGA_IOCTL_DEPTH_8 5
+#define QEMU_VGA_IOCTL_DEPTH_16 6
+#define QEMU_VGA_IOCTL_DEPTH_32 7
+
+#define VGA_DAC_WRITE_INDEX 0x3c8
+#define VGA_DAC_DATA 0x3c9
+// DAC takes 6 bit colors
+#define VGA_DAC_SHIFT 2
+#define QEMU_VGA_TERMINAL_COLORS 16
+
 #define QEMU_VGA_MIN_VER 0xb0c0
 #define QEMU_VGA_MAX_VER 0xb0c5
 
@@ -35,6 +61,9 @@
 #define QEMU_VGA_DEFAULT_WIDTH 720
 #define QEMU_VGA_DEFAULT_HEIGHT 480
 #define QEMU_VGA_DEFAULT_BPP 16
+// Text area, with status bar and IME rows below
+#define QEMU_VGA_MIN_WIDTH (SCREEN_WIDTH * FONT_ACTUAL_WIDTH)
+#define QEMU_VGA_MIN_HEIGHT 480
 
 #define UTF8_3BYTE_MASK 0xe0
 #define UTF8_2BYTE_MASK 0xc0
@@ -47,6 +76,9 @@ extern uint32_t qemu_vga_addr;
 extern uint32_t qemu_vga_enabled;
 extern uint32_t qemu_vga_cursor_x;
 extern uint32_t qemu_vga_cursor_y;
+extern uint32_t qemu_vga_pitch;
+extern uint32_t qemu_vga_page_size;
+extern uint16_t qemu_vga_splash_height;
 
 typedef union {
     uint32_t val;
@@ -64,6 +96,44 @@ typedef union {
     };
 } vga_color_t;
 
+typedef struct {
+    uint8_t enabled;        // Whether drawing goes to the back page
+    uint8_t front;          // Which page is being displayed, 0 or 1
+    uint16_t dirty_top;     // Lines [dirty_top, dirty_bottom) were drawn
+    uint16_t dirty_bottom;  //   on back page since last present
+    uint32_t frames;        // Presents since fps_start
+    uint32_t fps_start;     // PIT time when counting started
+    uint32_t fps;           // Frame rate of the last second
+} qemu_vga_buffer_t;
+
+extern qemu_vga_buffer_t qemu_vga_buffers[];
+
+// Drawing routines of a color depth, picked on mode set
+// so drawing code doesn't branch on bpp for every pixel
+typedef struct {
+    uint8_t bpp;
+    uint8_t bytes_per_pixel;
+    const vga_color_t* palette;     // Terminal colors in this depth
+    void (*pixel)(uint32_t addr, uint32_t color);
+    // Rectangle fill and 1 bpp mask color expansion, from vga2d.
+    // Copying is depth independent, so vga2d_copy is used directly
+    void (*fill)(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color);
+    void (*expand)(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                   uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent);
+} qemu_vga_ops_t;
+
+extern const qemu_vga_ops_t* qemu_vga_ops;
+
+// Foreground and background colors of every text attribute byte,
+// packed in current color depth on mode set
+#define QEMU_VGA_ATTRS 256
+typedef struct {
+    vga_color_t fg;
+    vga_color_t bg;
+} qemu_vga_attr_t;
+
+extern qemu_vga_attr_t qemu_vga_attrs[QEMU_VGA_ATTRS];
+
 typedef struct {
     // For QEMU VGA
     uint8_t len;    // Length of this UTF-8 code
@@ -71,23 +141,51 @@ typedef struct {
     uint8_t buf[3]; // What we got
     // For putc in lib.c
     uint8_t got;    // How many letters left for UTF-8 code
+    uint16_t code;  // Unicode decoded so far, for VGA text mode font
 } utf8_state_t;
 
 uint16_t qemu_vga_read(uint16_t index);
 void qemu_vga_write(uint16_t index, uint16_t data);
 
+uint32_t qemu_vga_page_addr(int32_t tid, uint8_t page);
 uint32_t qemu_vga_active_window_addr();
 void qemu_vga_switch_terminal(int32_t tid);
+void qemu_vga_text_flush(int32_t tid);
 
 uint16_t qemu_vga_init(uint16_t xres, uint16_t yres, uint16_t bpp);
+int32_t qemu_vga_set_mode(uint16_t xres, uint16_t yres, uint16_t bpp);
 void qemu_vga_pixel_set(uint16_t x, uint16_t y, vga_color_t color);
+uint16_t* qemu_vga_wide_row(int32_t tid, uint8_t grid_y);
+void qemu_vga_put_wide(uint16_t x, uint16_t y, uint16_t code, vga_color_t fg, vga_color_t bg);
 void qemu_vga_putc(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg, vga_color_t bg);
+void qemu_vga_putc_attr(uint16_t x, uint16_t y, uint8_t ch, uint8_t attrib);
 void qemu_vga_putc_transparent(uint16_t x, uint16_t y, uint8_t ch, vga_color_t fg);
+void qemu_vga_draw_cells(uint8_t grid_x, uint8_t grid_y, uint8_t count);
+void qemu_vga_draw_cell_data(uint8_t grid_x, uint8_t grid_y, const uint8_t* cell, uint8_t count);
+void qemu_vga_draw_text_row(uint8_t grid_y, const uint8_t* cells, const uint16_t* wide);
+void qemu_vga_render_char(uint8_t* buf, uint32_t pitch, uint8_t ch, vga_color_t fg, vga_color_t bg);
+void qemu_vga_blit_all_terminals(const uint8_t* src, uint32_t pitch,
+                                 uint16_t x, uint16_t y, uint16_t width, uint16_t height);
 void qemu_vga_clear();
 void qemu_vga_clear_row(uint8_t grid_y);
-void qemu_vga_roll_up();
+void qemu_vga_roll_up(uint8_t top, uint8_t bottom);
 void qemu_vga_set_cursor_pos(uint8_t x, uint8_t y);
 vga_color_t qemu_vga_get_terminal_color(uint8_t color);
 void qemu_vga_show_picture(uint16_t width, uint16_t height, uint8_t bpp, uint8_t* data);
+void qemu_vga_show_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+                                const uint8_t* data, uint32_t len);
+void qemu_vga_preload_picture_lzss(uint16_t width, uint16_t height, uint8_t bpp,
+                                   const uint8_t* data, uint32_t len);
+void qemu_vga_skip_picture(uint16_t height);
+
+void qemu_vga_wait_vsync();
+int32_t qemu_vga_double_buffer_enable(int32_t tid);
+int32_t qemu_vga_double_buffer_disable(int32_t tid);
+int32_t qemu_vga_present(int32_t tid);
+
+extern unified_fs_interface_t qemu_vga_if;
+int32_t qemu_vga_open(int32_t* inode, char* filename);
+int32_t qemu_vga_ioctl(int32_t* inode, uint32_t* offset, int32_t op);
+int32_t qemu_vga_close(int32_t* inode);
 
 #endif
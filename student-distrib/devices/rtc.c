@@ -1,15 +1,23 @@
 #include "rtc.h"
 #include "../interrupts/multiprocessing.h"
 #include "../lib/status_bar.h"
+#include "../lib/deferred.h"
+#include "cpuid.h"
 
 uint8_t rtc_global_counter = 0;
 
+// Ticks not yet counted down on RTC handles
+volatile uint32_t rtc_pending_ticks = 0;
+
+// Longest time spent in RTC interrupt handler, in TSC cycles
+uint32_t rtc_max_handler_cycles = 0;
+
 // Unified FS interface for RTC.
 unified_fs_interface_t rtc_if = {
     .open = rtc_open,
     .read = rtc_read,
     .write = rtc_write,
-    .ioctl = NULL,
+    .ioctl = rtc_ioctl,
     .close = rtc_close
 };
 
@@ -32,14 +40,18 @@ uint8_t rtc_init() {
     return 0;
 }
 
-/* void rtc_interrupt()
- * @description: function to be called when RTC generates an interrupt.
- *     Decreases offset for all RTC handles, as offsets are counters for timing.
+/* void rtc_count_down(uint32_t arg)
+ * @input: arg - ignored
+ * @output: offset of all RTC handles decreased by ticks passed
+ * @description: deferred work of rtc_interrupt. Ticks arriving while
+ *     it waits in queue are added up, so none of them are lost.
  */
-void rtc_interrupt() {
-    // Triggers global event every 256 ticks (0.25s)
-    rtc_global_counter++;
-    if(0 == rtc_global_counter) rtc_periodic_event();
+static void rtc_count_down(uint32_t arg) {
+    uint32_t flags;
+    cli_and_save(flags);
+    uint32_t ticks = rtc_pending_ticks;
+    rtc_pending_ticks = 0;
+    restore_flags(flags);
 
     // For all processes, find RTC handles and update their offset
     int pid;
@@ -51,24 +63,55 @@ void rtc_interrupt() {
             if(process->fd_array[fd].interface != &rtc_if) continue;
 
             // This is an RTC handle
-            if(process->fd_array[fd].pos > 0) {
-                process->fd_array[fd].pos--;
+            if(process->fd_array[fd].pos > ticks) {
+                process->fd_array[fd].pos -= ticks;
+            } else if(process->fd_array[fd].pos > 0) {
+                process->fd_array[fd].pos = 0;
+                // Interrupt the process is waiting for has arrived
+                signal_send(pid, SIGNAL_IO);
             }
         }
     }
+}
+
+/* void rtc_interrupt()
+ * @description: function to be called when RTC generates an interrupt.
+ *     Counts the tick and leaves updating RTC handles to deferred work,
+ *     as offsets are counters for timing.
+ */
+void rtc_interrupt() {
+    uint32_t start = cpu_info.features.tsc ? rdtsc_low() : 0;
+
+    // Triggers global event every 256 ticks (0.25s)
+    rtc_global_counter++;
+    if(0 == rtc_global_counter) rtc_periodic_event();
+
+    // Only the first tick since last count down needs to queue it
+    if(0 == rtc_pending_ticks++) {
+        if(FAIL == deferred_queue(rtc_count_down, 0)) rtc_pending_ticks = 0;
+    }
 
     // Read from RTC register C, so it can keep sending interrupts
     outb(RTC_REG_C, RTC_PORT_CMD); // select register C
     inb(RTC_PORT_DATA);		       // just throw away contents
 
     send_eoi(RTC_IRQ);  // And we're done
+
+    // Keep track of worst case handler time
+    if(cpu_info.features.tsc) {
+        uint32_t cycles = rdtsc_low() - start;
+        if(cycles > rtc_max_handler_cycles) rtc_max_handler_cycles = cycles;
+    }
+
+    deferred_run();
 }
 
 /* void rtc_periodic_event()
  * @description: runs some global events triggered every 0.25s.
+ *     Only requests the work, so the RTC handler stays short.
  */
 void rtc_periodic_event() {
-    ONTO_DISPLAY_WRAP(status_bar_update_clock());
+    status_bar_request_clock();
 }
 
 /* int32_t rtc_open(int32_t* inode, char* filename)
@@ -113,6 +156,26 @@ int32_t rtc_write(int32_t* inode, uint32_t* offset, const char* buf, uint32_t le
   return 0;
 }
 
+/* int32_t rtc_ioctl(int32_t* inode, uint32_t* offset, int32_t op)
+ * @input: op - RTC_IOCTL_MAX_HANDLER_CYCLES or RTC_IOCTL_RESET_STATS
+ * @output: ret val - longest time spent in RTC interrupt handler
+ *                    in TSC cycles, SUCCESS after reset, or FAIL
+ * @description: reads RTC interrupt latency statistics.
+ */
+int32_t rtc_ioctl(int32_t* inode, uint32_t* offset, int32_t op) {
+    switch(op) {
+        case RTC_IOCTL_MAX_HANDLER_CYCLES:
+            if(!cpu_info.features.tsc) return FAIL;
+            // Keep it positive so it can't be taken as FAIL
+            return rtc_max_handler_cycles & 0x7fffffff;
+        case RTC_IOCTL_RESET_STATS:
+            rtc_max_handler_cycles = 0;
+            return SUCCESS;
+        default:
+            return FAIL;
+    }
+}
+
 /* int32_t rtc_close(int32_t* inode)
  * @input: inode - ignored
  * @output: 0 (SUCCESS)
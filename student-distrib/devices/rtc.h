@@ -22,6 +22,11 @@
 #define RTC_REG_B 0x8B
 #define RTC_REG_C 0x8C
 
+#define RTC_IOCTL_MAX_HANDLER_CYCLES 1
+#define RTC_IOCTL_RESET_STATS 2
+
+extern uint32_t rtc_max_handler_cycles;
+
 uint8_t rtc_init();
 void rtc_interrupt();
 void rtc_periodic_event();
@@ -30,6 +35,7 @@ void rtc_periodic_event();
 int32_t rtc_open(int32_t* inode, char* filename);
 int32_t rtc_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len);
 int32_t rtc_write(int32_t* inode, uint32_t* offset, const char* buf, uint32_t len);
+int32_t rtc_ioctl(int32_t* inode, uint32_t* offset, int32_t op);
 int32_t rtc_close(int32_t* inode);
 
 extern unified_fs_interface_t rtc_if;
@@ -0,0 +1,274 @@
+#include "screen.h"
+#include "qemu_vga.h"
+#include "mouse_cursor.h"
+#include "../interrupts/multiprocessing.h"
+
+static screen_damage_t screen_damages[TERMINAL_COUNT];
+
+unified_fs_interface_t screen_if = {
+    .open = screen_open,
+    .read = screen_read,
+    .write = NULL,
+    .ioctl = screen_ioctl,
+    .close = screen_close
+};
+
+/* uint32_t screen_rect_area(const screen_rect_t* rect)
+ * @input: rect - a rectangle
+ * @output: ret val - number of pixels in it
+ */
+static uint32_t screen_rect_area(const screen_rect_t* rect) {
+    return rect->width * rect->height;
+}
+
+/* void screen_rect_union(screen_rect_t* dest, const screen_rect_t* src)
+ * @input: dest, src - two rectangles
+ * @output: dest extended to the bounding box of both
+ */
+static void screen_rect_union(screen_rect_t* dest, const screen_rect_t* src) {
+    uint16_t right = dest->x + dest->width;
+    uint16_t bottom = dest->y + dest->height;
+    if(src->x + src->width > right) right = src->x + src->width;
+    if(src->y + src->height > bottom) bottom = src->y + src->height;
+    if(src->x < dest->x) dest->x = src->x;
+    if(src->y < dest->y) dest->y = src->y;
+    dest->width = right - dest->x;
+    dest->height = bottom - dest->y;
+}
+
+/* void screen_damage(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+ * @input: tid - terminal that changed
+ *         x, y, width, height - changed rectangle, visible on screen
+ * @output: rectangle added to what's returned on next read
+ * @description: a rectangle is merged into an existing one if the bounding
+ *     box isn't larger than both of them together, like glyphs along a line.
+ *     When the list is full, it's merged where it grows the box the least.
+ */
+void screen_damage(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    if(tid < 0 || tid >= TERMINAL_COUNT) return;
+    if(x >= qemu_vga_xres || y >= qemu_vga_yres) return;
+    if(x + width > qemu_vga_xres) width = qemu_vga_xres - x;
+    if(y + height > qemu_vga_yres) height = qemu_vga_yres - y;
+    if(0 == width || 0 == height) return;
+
+    screen_rect_t rect = {.x = x, .y = y, .width = width, .height = height};
+    screen_damage_t* damage = &screen_damages[tid];
+    uint32_t best_growth = 0xffffffff;
+    int best = 0;
+    int i;
+    uint32_t flags;
+    cli_and_save(flags);
+    for(i = 0; i < damage->count; i++) {
+        screen_rect_t merged = damage->rects[i];
+        screen_rect_union(&merged, &rect);
+        uint32_t growth = screen_rect_area(&merged) - screen_rect_area(&damage->rects[i]);
+        if(screen_rect_area(&merged) <= screen_rect_area(&damage->rects[i]) + screen_rect_area(&rect)) {
+            damage->rects[i] = merged;
+            restore_flags(flags);
+            return;
+        }
+        if(growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    if(damage->count < SCREEN_DAMAGE_RECTS) {
+        damage->rects[damage->count++] = rect;
+    } else {
+        screen_rect_union(&damage->rects[best], &rect);
+    }
+    restore_flags(flags);
+}
+
+/* void screen_damage_all()
+ * @output: all terminals to be returned as a full frame on next read
+ * @description: used when display mode changes.
+ */
+void screen_damage_all() {
+    int32_t tid;
+    uint32_t flags;
+    cli_and_save(flags);
+    for(tid = 0; tid < TERMINAL_COUNT; tid++) {
+        screen_damages[tid].count = 0;
+        screen_damage(tid, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    }
+    restore_flags(flags);
+}
+
+/* uint32_t screen_pixel(const uint8_t* row, uint32_t bytes_per_pixel, uint16_t i)
+ * @input: row - start of a row on framebuffer
+ *         bytes_per_pixel - of current color depth
+ *         i - index of pixel in row
+ * @output: ret val - the pixel
+ */
+static uint32_t screen_pixel(const uint8_t* row, uint32_t bytes_per_pixel, uint16_t i) {
+    switch(bytes_per_pixel) {
+        case 1: return row[i];
+        case 2: return ((const uint16_t*) row)[i];
+        default: return ((const uint32_t*) row)[i];
+    }
+}
+
+/* int32_t screen_encode_row(uint8_t* buf, uint32_t len, const uint8_t* row,
+ *                           uint32_t bytes_per_pixel, uint16_t width)
+ * @input: buf, len - where to write encoded row, and space there
+ *         row, width - pixels to encode
+ *         bytes_per_pixel - of current color depth
+ * @output: ret val - bytes written, FAIL if it doesn't fit
+ * @description: encodes a row as runs of repeated and literal pixels.
+ */
+static int32_t screen_encode_row(uint8_t* buf, uint32_t len, const uint8_t* row,
+                                 uint32_t bytes_per_pixel, uint16_t width) {
+    uint32_t out = 0;
+    uint16_t i = 0;
+    while(i < width) {
+        uint32_t pixel = screen_pixel(row, bytes_per_pixel, i);
+        uint16_t run = 1;
+        while(i + run < width && run < SCREEN_RLE_MAX_REPEAT
+            && screen_pixel(row, bytes_per_pixel, i + run) == pixel) run++;
+
+        if(run >= SCREEN_RLE_MIN_REPEAT) {
+            if(out + 1 + bytes_per_pixel > len) return FAIL;
+            buf[out++] = SCREEN_RLE_REPEAT + run - SCREEN_RLE_MIN_REPEAT;
+            memcpy(buf + out, row + i * bytes_per_pixel, bytes_per_pixel);
+            out += bytes_per_pixel;
+            i += run;
+            continue;
+        }
+
+        // Literal pixels, until a repeat starts
+        uint16_t count = 1;
+        while(i + count < width && count < SCREEN_RLE_MAX_LITERAL
+            && !(i + count + 1 < width && screen_pixel(row, bytes_per_pixel, i + count)
+                == screen_pixel(row, bytes_per_pixel, i + count + 1))) count++;
+        if(out + 1 + count * bytes_per_pixel > len) return FAIL;
+        buf[out++] = count - 1;
+        memcpy(buf + out, row + i * bytes_per_pixel, count * bytes_per_pixel);
+        out += count * bytes_per_pixel;
+        i += count;
+    }
+    return out;
+}
+
+/* int32_t screen_open(int32_t* inode, char* filename)
+ * @input: inode - set to terminal being captured, the caller's
+ *         filename - ignored
+ * @output: ret val - SUCCESS / FAIL
+ * @description: first read returns the full frame, later ones what changed.
+ */
+int32_t screen_open(int32_t* inode, char* filename) {
+    if(!qemu_vga_enabled) return FAIL;
+    *inode = active_terminal_id;
+    return screen_ioctl(inode, NULL, SCREEN_IOCTL_FULL_FRAME);
+}
+
+/* int32_t screen_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len)
+ * @input: inode - terminal being captured
+ *         offset - ignored
+ *         buf, len - buffer to receive data, see screen.h for format
+ * @output: ret val - bytes written, FAIL on invalid input
+ * @description: returns rectangles of the terminal changed since last read,
+ *     as shown on screen, without the mouse cursor. What doesn't fit in buf
+ *     is kept for next read, rectangles may be split by rows to fit.
+ *     Data is returned only after double buffered frames are presented.
+ */
+int32_t screen_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len) {
+    if(!qemu_vga_enabled || NULL == buf) return FAIL;
+    if(len < sizeof(screen_header_t)) return FAIL;
+    int32_t tid = *inode;
+    screen_damage_t damage;
+    uint32_t flags;
+
+    // Text of terminals not on screen is rendered lazily
+    qemu_vga_text_flush(tid);
+
+    // Take over the list, anything drawn during the read goes into the next one
+    cli_and_save(flags);
+    damage = screen_damages[tid];
+    screen_damages[tid].count = 0;
+    restore_flags(flags);
+
+    screen_header_t* header = (screen_header_t*) buf;
+    uint32_t bytes_per_pixel = qemu_vga_ops->bytes_per_pixel;
+    uint32_t out = sizeof(screen_header_t);
+    int i;
+    header->width = qemu_vga_xres;
+    header->height = qemu_vga_yres;
+    header->bytes_per_pixel = bytes_per_pixel;
+    header->reserved = 0;
+    header->rect_count = 0;
+
+    for(i = 0; i < damage.count; i++) {
+        screen_rect_t* rect = &damage.rects[i];
+        if(out + sizeof(screen_rect_t) >= len) break;
+        screen_rect_t* rect_out = (screen_rect_t*) (buf + out);
+        uint32_t rect_start = out;
+        uint16_t rows;
+        out += sizeof(screen_rect_t);
+
+        uint32_t row = qemu_vga_page_addr(tid, qemu_vga_buffers[tid].front)
+            + rect->y * qemu_vga_pitch + rect->x * bytes_per_pixel;
+        mouse_cursor_enter(tid, rect->x, rect->y, rect->width, rect->height);
+        for(rows = 0; rows < rect->height; rows++) {
+            int32_t size = screen_encode_row((uint8_t*) buf + out, len - out,
+                (const uint8_t*) row, bytes_per_pixel, rect->width);
+            if(FAIL == size) break;
+            out += size;
+            row += qemu_vga_pitch;
+        }
+        mouse_cursor_leave();
+
+        if(0 == rows) {
+            out = rect_start;
+            break;
+        }
+        rect_out->x = rect->x;
+        rect_out->y = rect->y;
+        rect_out->width = rect->width;
+        rect_out->height = rows;
+        header->rect_count++;
+        if(rows < rect->height) {
+            // Rest of the rectangle goes first on next read
+            rect->y += rows;
+            rect->height -= rows;
+            break;
+        }
+    }
+
+    // Put back what didn't fit
+    for(; i < damage.count; i++) {
+        screen_damage(tid, damage.rects[i].x, damage.rects[i].y,
+            damage.rects[i].width, damage.rects[i].height);
+    }
+    return out;
+}
+
+/* int32_t screen_ioctl(int32_t* inode, uint32_t* offset, int32_t op)
+ * @input: inode - terminal being captured
+ *         offset - ignored
+ *         op - SCREEN_IOCTL_FULL_FRAME to return the whole screen on next read,
+ *              SCREEN_IOCTL_TERMINAL + tid to capture another terminal instead
+ * @output: ret val - SUCCESS / FAIL
+ */
+int32_t screen_ioctl(int32_t* inode, uint32_t* offset, int32_t op) {
+    if(op >= SCREEN_IOCTL_TERMINAL && op < SCREEN_IOCTL_TERMINAL + TERMINAL_COUNT) {
+        *inode = op - SCREEN_IOCTL_TERMINAL;
+        op = SCREEN_IOCTL_FULL_FRAME;
+    }
+    if(SCREEN_IOCTL_FULL_FRAME != op) return FAIL;
+
+    uint32_t flags;
+    cli_and_save(flags);
+    screen_damages[*inode].count = 0;
+    screen_damage(*inode, 0, 0, qemu_vga_xres, qemu_vga_yres);
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* int32_t screen_close(int32_t* inode)
+ * @input: inode - ignored
+ * @output: ret val - SUCCESS
+ */
+int32_t screen_close(int32_t* inode) {
+    return SUCCESS;
+}
@@ -0,0 +1,57 @@
+#ifndef _SCREEN_H_
+#define _SCREEN_H_
+
+#include "../lib/lib.h"
+#include "../fs/unified_fs.h"
+
+// Changed rectangles kept per terminal before they're merged together
+#define SCREEN_DAMAGE_RECTS 16
+
+#define SCREEN_IOCTL_FULL_FRAME 1
+// Capture another terminal, SCREEN_IOCTL_TERMINAL + tid
+#define SCREEN_IOCTL_TERMINAL 0x10
+
+// Pixel runs: control byte below SCREEN_RLE_REPEAT is followed by
+// (control + 1) literal pixels, otherwise by one pixel repeated
+// (control - SCREEN_RLE_REPEAT + SCREEN_RLE_MIN_REPEAT) times
+#define SCREEN_RLE_REPEAT 0x80
+#define SCREEN_RLE_MIN_REPEAT 2
+#define SCREEN_RLE_MAX_LITERAL 128
+#define SCREEN_RLE_MAX_REPEAT 129
+
+/* Data read from screen device:
+ *   screen_header_t
+ *   rect_count times:
+ *     screen_rect_t
+ *     height times: one row of width pixels, as pixel runs described above
+ * Pixels are in the format of current color depth, in little endian.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t width;             // Screen resolution
+    uint16_t height;
+    uint8_t bytes_per_pixel;
+    uint8_t reserved;
+    uint16_t rect_count;        // Rectangles following this header
+} screen_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t x, y;
+    uint16_t width, height;
+} screen_rect_t;
+
+typedef struct {
+    uint8_t count;
+    screen_rect_t rects[SCREEN_DAMAGE_RECTS];
+} screen_damage_t;
+
+void screen_damage(int32_t tid, uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void screen_damage_all();
+
+int32_t screen_open(int32_t* inode, char* filename);
+int32_t screen_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len);
+int32_t screen_ioctl(int32_t* inode, uint32_t* offset, int32_t op);
+int32_t screen_close(int32_t* inode);
+
+extern unified_fs_interface_t screen_if;
+
+#endif
@@ -0,0 +1,199 @@
+#include "vga2d.h"
+
+/* void vga2d_fill_row(uint32_t dest, uint32_t bytes, uint32_t pattern)
+ * @input: dest, bytes - memory to fill
+ *         pattern - 4 byte pattern, same on both halves for 8 and 16 bit color
+ * @output: memory filled with pattern, a dword at a time.
+ *     Tail is a word then a byte, so a 16 bit pixel stays whole
+ */
+static inline void vga2d_fill_row(uint32_t dest, uint32_t bytes, uint32_t pattern) {
+    asm volatile ("                 \n\
+            movw    %%ds, %%dx      \n\
+            movw    %%dx, %%es      \n\
+            movl    %%ecx, %%edx    \n\
+            shrl    $2, %%ecx       \n\
+            andl    $0x3, %%edx     \n\
+            cld                     \n\
+            rep     stosl           \n\
+            movl    %%edx, %%ecx    \n\
+            shrl    $1, %%ecx       \n\
+            rep     stosw           \n\
+            andl    $0x1, %%edx     \n\
+            movl    %%edx, %%ecx    \n\
+            rep     stosb           \n\
+            "
+            : "+D"(dest), "+c"(bytes)
+            : "a"(pattern)
+            : "edx", "memory", "cc"
+    );
+}
+
+/* void vga2d_copy_row(uint32_t dest, uint32_t src, uint32_t bytes)
+ * @input: dest, src, bytes - memory to copy
+ * @output: memory copied from lower addresses up, a dword at a time
+ */
+static inline void vga2d_copy_row(uint32_t dest, uint32_t src, uint32_t bytes) {
+    asm volatile ("                 \n\
+            movw    %%ds, %%dx      \n\
+            movw    %%dx, %%es      \n\
+            movl    %%ecx, %%edx    \n\
+            shrl    $2, %%ecx       \n\
+            andl    $0x3, %%edx     \n\
+            cld                     \n\
+            rep     movsl           \n\
+            movl    %%edx, %%ecx    \n\
+            rep     movsb           \n\
+            "
+            : "+D"(dest), "+S"(src), "+c"(bytes)
+            :
+            : "edx", "memory", "cc"
+    );
+}
+
+/* void vga2d_copy_row_backward(uint32_t dest, uint32_t src, uint32_t bytes)
+ * @input: dest, src, bytes - memory to copy
+ * @output: memory copied from higher addresses down, for dest overlapping
+ *     the end of src. Odd bytes at the end go first, then dwords.
+ */
+static inline void vga2d_copy_row_backward(uint32_t dest, uint32_t src, uint32_t bytes) {
+    asm volatile ("                             \n\
+            movw    %%ds, %%dx                  \n\
+            movw    %%dx, %%es                  \n\
+            leal    -1(%%esi, %%ecx), %%esi     \n\
+            leal    -1(%%edi, %%ecx), %%edi     \n\
+            movl    %%ecx, %%edx                \n\
+            andl    $0x3, %%ecx                 \n\
+            std                                 \n\
+            rep     movsb                       \n\
+            movl    %%edx, %%ecx                \n\
+            shrl    $2, %%ecx                   \n\
+            subl    $3, %%esi                   \n\
+            subl    $3, %%edi                   \n\
+            rep     movsl                       \n\
+            cld                                 \n\
+            "
+            : "+D"(dest), "+S"(src), "+c"(bytes)
+            :
+            : "edx", "memory", "cc"
+    );
+}
+
+/* void vga2d_fill_N(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color)
+ * @input: dest, pitch - top left pixel, and bytes per line
+ *         width, height - size of rectangle in pixels
+ *         color - in the format of N bit color depth
+ * @output: rectangle filled with color
+ */
+void vga2d_fill_8(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color) {
+    uint32_t pattern = (color & 0xff) * 0x01010101;
+    uint16_t i;
+    for(i = 0; i < height; i++) {
+        vga2d_fill_row(dest, width, pattern);
+        dest += pitch;
+    }
+}
+void vga2d_fill_16(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color) {
+    uint32_t pattern = (color & 0xffff) | (color << 16);
+    uint16_t i;
+    for(i = 0; i < height; i++) {
+        vga2d_fill_row(dest, width << 1, pattern);
+        dest += pitch;
+    }
+}
+void vga2d_fill_32(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color) {
+    uint16_t i;
+    for(i = 0; i < height; i++) {
+        vga2d_fill_row(dest, width << 2, color & 0xffffff);
+        dest += pitch;
+    }
+}
+
+/* void vga2d_copy(uint32_t dest, uint32_t dest_pitch, uint32_t src, uint32_t src_pitch,
+ *                 uint32_t row_bytes, uint16_t height)
+ * @input: dest, dest_pitch - top left pixel of destination, and bytes per line
+ *         src, src_pitch - same for source
+ *         row_bytes, height - size of rectangle, width in bytes
+ * @output: rectangle copied. Works for overlapping rectangles on the same
+ *     surface: if dest is after src, rows are copied bottom up and backwards.
+ */
+void vga2d_copy(uint32_t dest, uint32_t dest_pitch, uint32_t src, uint32_t src_pitch,
+                uint32_t row_bytes, uint16_t height) {
+    uint16_t i;
+    if(0 == height) return;
+    if(dest <= src) {
+        for(i = 0; i < height; i++) {
+            vga2d_copy_row(dest, src, row_bytes);
+            dest += dest_pitch;
+            src += src_pitch;
+        }
+    } else {
+        dest += (height - 1) * dest_pitch;
+        src += (height - 1) * src_pitch;
+        for(i = 0; i < height; i++) {
+            vga2d_copy_row_backward(dest, src, row_bytes);
+            dest -= dest_pitch;
+            src -= src_pitch;
+        }
+    }
+}
+
+/* void vga2d_expand_N(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+ *                     uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent)
+ * @input: dest, pitch - top left pixel, and bytes per line
+ *         mask, mask_pitch - 1 bit per pixel, MSB of each byte is leftmost,
+ *             and bytes per line of mask
+ *         width, height - size of rectangle in pixels
+ *         fg, bg - colors for 1 and 0 bits, in the format of N bit color depth
+ *         transparent - VGA2D_TRANSPARENT to leave pixels of 0 bits alone
+ * @output: mask drawn in colors, like fonts
+ */
+void vga2d_expand_8(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                    uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent) {
+    uint16_t i, j;
+    for(i = 0; i < height; i++) {
+        uint8_t* pixel = (uint8_t*) dest;
+        for(j = 0; j < width; j++) {
+            if(mask[j >> 3] & (0x80 >> (j & 0x7))) {
+                pixel[j] = fg;
+            } else if(!transparent) {
+                pixel[j] = bg;
+            }
+        }
+        dest += pitch;
+        mask += mask_pitch;
+    }
+}
+void vga2d_expand_16(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                     uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent) {
+    uint16_t i, j;
+    for(i = 0; i < height; i++) {
+        uint16_t* pixel = (uint16_t*) dest;
+        for(j = 0; j < width; j++) {
+            if(mask[j >> 3] & (0x80 >> (j & 0x7))) {
+                pixel[j] = fg;
+            } else if(!transparent) {
+                pixel[j] = bg;
+            }
+        }
+        dest += pitch;
+        mask += mask_pitch;
+    }
+}
+void vga2d_expand_32(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                     uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent) {
+    uint16_t i, j;
+    fg &= 0xffffff;
+    bg &= 0xffffff;
+    for(i = 0; i < height; i++) {
+        uint32_t* pixel = (uint32_t*) dest;
+        for(j = 0; j < width; j++) {
+            if(mask[j >> 3] & (0x80 >> (j & 0x7))) {
+                pixel[j] = fg;
+            } else if(!transparent) {
+                pixel[j] = bg;
+            }
+        }
+        dest += pitch;
+        mask += mask_pitch;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef _VGA2D_H_
+#define _VGA2D_H_
+
+#include "../lib/types.h"
+
+// Color expansion draws background where mask bit is 0,
+// unless transparent, where those pixels are left as is
+#define VGA2D_OPAQUE 0
+#define VGA2D_TRANSPARENT 1
+
+/* Rectangle routines on linear framebuffer, or memory laid out the same way.
+ * dest / src are addresses of the top left pixel, pitch is bytes per line.
+ */
+
+void vga2d_fill_8(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color);
+void vga2d_fill_16(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color);
+void vga2d_fill_32(uint32_t dest, uint32_t pitch, uint16_t width, uint16_t height, uint32_t color);
+
+void vga2d_copy(uint32_t dest, uint32_t dest_pitch, uint32_t src, uint32_t src_pitch,
+                uint32_t row_bytes, uint16_t height);
+
+void vga2d_expand_8(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                    uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent);
+void vga2d_expand_16(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                     uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent);
+void vga2d_expand_32(uint32_t dest, uint32_t pitch, const uint8_t* mask, uint32_t mask_pitch,
+                     uint16_t width, uint16_t height, uint32_t fg, uint32_t bg, uint8_t transparent);
+
+#endif
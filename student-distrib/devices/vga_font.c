@@ -0,0 +1,178 @@
+#include "vga_font.h"
+#include "qemu_vga.h"
+#include "../data/vga_fonts.h"
+#include "../interrupts/multiprocessing.h"
+#include "../lib/glyph_cache.h"
+#include "../lib/scrollback.h"
+
+static vga_font_slot_t vga_font_slots[VGA_FONT_WIDE_SLOTS];
+static uint32_t vga_font_clock = 0;
+static uint8_t vga_font_loaded = 0;
+
+// Register values replaced while plane 2 is written
+static uint8_t vga_font_saved_seq_map_mask;
+static uint8_t vga_font_saved_seq_memory_mode;
+static uint8_t vga_font_saved_gc_read_map;
+static uint8_t vga_font_saved_gc_mode;
+static uint8_t vga_font_saved_gc_misc;
+
+/* uint8_t vga_font_swap_reg(uint16_t index_port, uint8_t index, uint8_t data)
+ * @input: index_port - index port of sequencer / graphics controller,
+ *             data port is the next one
+ *         index, data - register and value to be written into it
+ * @output: ret val - previous value of the register
+ */
+static uint8_t vga_font_swap_reg(uint16_t index_port, uint8_t index, uint8_t data) {
+    outb(index, index_port);
+    uint8_t old = inb(index_port + 1);
+    outb(data, index_port + 1);
+    return old;
+}
+
+/* void vga_font_plane_begin()
+ * @output: character generator RAM mapped at VGA_FONT_MEM
+ * @description: text in plane 0 / 1 is unreachable until vga_font_plane_end.
+ *     Must be called with interrupts off.
+ */
+static void vga_font_plane_begin() {
+    vga_font_saved_seq_map_mask = vga_font_swap_reg(VGA_SEQ_INDEX, VGA_SEQ_MAP_MASK, VGA_FONT_MAP_MASK);
+    vga_font_saved_seq_memory_mode = vga_font_swap_reg(VGA_SEQ_INDEX, VGA_SEQ_MEMORY_MODE, VGA_FONT_MEMORY_MODE);
+    vga_font_saved_gc_read_map = vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_READ_MAP, VGA_FONT_READ_MAP);
+    vga_font_saved_gc_mode = vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_MODE, VGA_FONT_MODE);
+    vga_font_saved_gc_misc = vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_MISC, VGA_FONT_MISC);
+}
+
+/* void vga_font_plane_end()
+ * @output: text mode memory layout restored
+ */
+static void vga_font_plane_end() {
+    vga_font_swap_reg(VGA_SEQ_INDEX, VGA_SEQ_MAP_MASK, vga_font_saved_seq_map_mask);
+    vga_font_swap_reg(VGA_SEQ_INDEX, VGA_SEQ_MEMORY_MODE, vga_font_saved_seq_memory_mode);
+    vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_READ_MAP, vga_font_saved_gc_read_map);
+    vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_MODE, vga_font_saved_gc_mode);
+    vga_font_swap_reg(VGA_GC_INDEX, VGA_GC_MISC, vga_font_saved_gc_misc);
+}
+
+/* void vga_font_write_glyph(uint8_t ch, const uint8_t* rows)
+ * @input: ch - character to be replaced
+ *         rows - FONT_DATA_HEIGHT rows of 8 pixels, MSB is leftmost
+ * @output: glyph of ch in character generator RAM replaced
+ * @description: must be called between vga_font_plane_begin / end.
+ */
+static void vga_font_write_glyph(uint8_t ch, const uint8_t* rows) {
+    uint8_t* glyph = (uint8_t*) (VGA_FONT_MEM + ch * VGA_FONT_GLYPH_SIZE);
+    memcpy(glyph, rows, FONT_DATA_HEIGHT);
+    memset(glyph + FONT_DATA_HEIGHT, 0, VGA_FONT_GLYPH_SIZE - FONT_DATA_HEIGHT);
+}
+
+/* void vga_font_init()
+ * @output: font of VGA text mode replaced with font_data, the same one
+ *     QEMU VGA draws with, Chinese character slots emptied
+ * @description: does nothing if QEMU VGA is used instead of text mode.
+ */
+void vga_font_init() {
+    if(qemu_vga_enabled) return;
+    uint32_t flags;
+    int i;
+    cli_and_save(flags);
+    vga_font_plane_begin();
+    for(i = 0; i < VGA_FONT_GLYPHS; i++) {
+        vga_font_write_glyph(i, font_data[i]);
+    }
+    vga_font_plane_end();
+    memset(vga_font_slots, 0, sizeof(vga_font_slots));
+    vga_font_loaded = 1;
+    restore_flags(flags);
+}
+
+/* void vga_font_slots_on_screen(uint8_t* in_use)
+ * @input: in_use - VGA_FONT_WIDE_SLOTS flags
+ * @output: in_use - set for slots shown on text of any terminal, or kept
+ *     in its scrollback history, by either half of the character
+ * @description: must be called with interrupts off.
+ */
+static void vga_font_slots_on_screen(uint8_t* in_use) {
+    // Left halves, followed by right halves
+    uint8_t found[VGA_FONT_WIDE_SLOTS << 1];
+    int32_t tid;
+    int i;
+    memset(found, 0, sizeof(found));
+    for(tid = 0; tid < TERMINAL_COUNT; tid++) {
+        const uint8_t* text = (const uint8_t*) (tid == displayed_terminal_id ? TERMINAL_DIRECT_ADDR
+            : TERMINAL_ALT_START + tid * TERMINAL_ALT_SIZE);
+        for(i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+            uint8_t ch = text[i << 1] - VGA_FONT_WIDE_LEFT;
+            if(ch < sizeof(found)) found[ch] = 1;
+        }
+    }
+    scrollback_find_chars(VGA_FONT_WIDE_LEFT, sizeof(found), found);
+    for(i = 0; i < VGA_FONT_WIDE_SLOTS; i++) {
+        in_use[i] = found[i] | found[VGA_FONT_WIDE_RIGHT - VGA_FONT_WIDE_LEFT + i];
+    }
+}
+
+/* int32_t vga_font_get_slot(uint16_t code)
+ * @input: code - unicode of a Chinese character
+ * @output: ret val - slot with the character's glyph loaded,
+ *     FAIL if the font doesn't have it or all slots are on screen
+ * @description: on a miss, the least recently used slot that's not on
+ *     screen is loaded with the glyph. Must be called with interrupts off.
+ */
+static int32_t vga_font_get_slot(uint16_t code) {
+    uint8_t in_use[VGA_FONT_WIDE_SLOTS];
+    uint16_t rows[CHINESE_FONT_HEIGHT];
+    uint8_t left[FONT_DATA_HEIGHT];
+    uint8_t right[FONT_DATA_HEIGHT];
+    int32_t victim = FAIL;
+    int i;
+
+    vga_font_clock++;
+    for(i = 0; i < VGA_FONT_WIDE_SLOTS; i++) {
+        if(vga_font_slots[i].code == code) {
+            vga_font_slots[i].last_used = vga_font_clock;
+            return i;
+        }
+    }
+
+    vga_font_slots_on_screen(in_use);
+    for(i = 0; i < VGA_FONT_WIDE_SLOTS; i++) {
+        if(in_use[i]) continue;
+        if(FAIL == victim || vga_font_slots[i].last_used < vga_font_slots[victim].last_used) victim = i;
+    }
+    if(FAIL == victim) return FAIL;
+    if(FAIL == glyph_cache_get(code, rows)) return FAIL;
+
+    // Character cells are as tall as the glyph, split it by columns
+    for(i = 0; i < FONT_DATA_HEIGHT; i++) {
+        left[i] = rows[i] >> FONT_DATA_WIDTH;
+        right[i] = rows[i] & 0xff;
+    }
+    vga_font_plane_begin();
+    vga_font_write_glyph(VGA_FONT_WIDE_LEFT + victim, left);
+    vga_font_write_glyph(VGA_FONT_WIDE_RIGHT + victim, right);
+    vga_font_plane_end();
+
+    vga_font_slots[victim].code = code;
+    vga_font_slots[victim].last_used = vga_font_clock;
+    return victim;
+}
+
+/* void vga_font_put_wide(uint8_t x, uint8_t y, uint16_t code)
+ * @input: x, y - left of the two cells of a Chinese character on active terminal
+ *         code - unicode of the character
+ * @output: the two cells show the character, or are left as is if it can't be shown
+ * @description: text mode counterpart of qemu_vga_put_wide. Attributes
+ *     of the cells are kept.
+ */
+void vga_font_put_wide(uint8_t x, uint8_t y, uint16_t code) {
+    if(qemu_vga_enabled || !vga_font_loaded) return;
+    if(x + 1 >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return;
+    uint32_t flags;
+    cli_and_save(flags);
+    int32_t slot = vga_font_get_slot(code);
+    if(FAIL != slot) {
+        video_mem[(y * SCREEN_WIDTH + x) << 1] = VGA_FONT_WIDE_LEFT + slot;
+        video_mem[(y * SCREEN_WIDTH + x + 1) << 1] = VGA_FONT_WIDE_RIGHT + slot;
+    }
+    restore_flags(flags);
+}
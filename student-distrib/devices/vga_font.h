@@ -0,0 +1,45 @@
+#ifndef _VGA_FONT_H_
+#define _VGA_FONT_H_
+
+#include "../lib/lib.h"
+#include "vga_text.h"
+
+// Character generator RAM, plane 2 mapped here while it's being written
+#define VGA_FONT_MEM 0xa0000
+#define VGA_FONT_GLYPHS 256
+#define VGA_FONT_GLYPH_SIZE 32  // Bytes per character, first 16 used
+
+#define VGA_SEQ_INDEX 0x3c4
+#define VGA_SEQ_DATA 0x3c5
+#define VGA_SEQ_MAP_MASK 0x02
+#define VGA_SEQ_MEMORY_MODE 0x04
+#define VGA_GC_INDEX 0x3ce
+#define VGA_GC_DATA 0x3cf
+#define VGA_GC_READ_MAP 0x04
+#define VGA_GC_MODE 0x05
+#define VGA_GC_MISC 0x06
+
+// Plane 2 only, sequential addressing, mapped at 0xa0000
+#define VGA_FONT_MAP_MASK 0x04
+#define VGA_FONT_MEMORY_MODE 0x07
+#define VGA_FONT_READ_MAP 0x02
+#define VGA_FONT_MODE 0x00
+#define VGA_FONT_MISC 0x04
+
+// Halves of Chinese characters on screen replace the line drawing glyphs.
+// Left halves are where the adapter copies the 8th pixel column into the
+// 9th, so strokes continue into the right half.
+#define VGA_FONT_WIDE_SLOTS 32
+#define VGA_FONT_WIDE_LEFT 0xc0
+#define VGA_FONT_WIDE_RIGHT 0xe0
+#define VGA_FONT_SLOT_FREE 0
+
+typedef struct {
+    uint16_t code;          // Unicode of the character, VGA_FONT_SLOT_FREE if unused
+    uint32_t last_used;     // Value of vga_font_clock on last use
+} vga_font_slot_t;
+
+void vga_font_init();
+void vga_font_put_wide(uint8_t x, uint8_t y, uint16_t code);
+
+#endif
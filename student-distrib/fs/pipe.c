@@ -0,0 +1,269 @@
+#include "pipe.h"
+#include "../interrupts/multiprocessing.h"
+#include "../lib/shm.h"
+
+static pipe_t pipes[PIPE_COUNT];
+static uint8_t pipe_buffers[PIPE_COUNT][PIPE_BUFFER_SIZE] __attribute__((aligned(PIPE_BUFFER_SIZE)));
+
+unified_fs_interface_t pipe_read_if = {
+    .open = NULL,
+    .read = pipe_read,
+    .write = NULL,
+    .ioctl = NULL,
+    .close = pipe_read_close,
+    .dup = pipe_read_dup
+};
+
+unified_fs_interface_t pipe_write_if = {
+    .open = NULL,
+    .read = NULL,
+    .write = pipe_write,
+    .ioctl = NULL,
+    .close = pipe_write_close,
+    .dup = pipe_write_dup
+};
+
+/* int32_t pipe_create(fd_array_t* fd_array, int32_t* fds)
+ * @input: fd_array - file descriptor array of the caller
+ *         fds - receives descriptors of read end, then write end
+ * @output: ret val - SUCCESS / FAIL
+ * @description: actual code for the pipe system call. The two lowest
+ *     free descriptors are used. The pipe goes away when both ends are
+ *     closed by every process holding them.
+ */
+int32_t pipe_create(fd_array_t* fd_array, int32_t* fds) {
+    if(NULL == fd_array || NULL == fds) return FAIL;
+    int32_t read_fd = 0;
+    while(read_fd < MAX_OPEN_FILES && fd_array[read_fd].interface != NULL) read_fd++;
+    int32_t write_fd = read_fd + 1;
+    while(write_fd < MAX_OPEN_FILES && fd_array[write_fd].interface != NULL) write_fd++;
+    if(write_fd >= MAX_OPEN_FILES) return FAIL;
+
+    uint32_t flags;
+    int32_t id;
+    cli_and_save(flags);
+    for(id = 0; id < PIPE_COUNT && pipes[id].used; id++);
+    if(id >= PIPE_COUNT) {
+        restore_flags(flags);
+        return FAIL;
+    }
+    pipes[id].used = 1;
+    pipes[id].readers = 1;
+    pipes[id].writers = 1;
+    pipes[id].head = 0;
+    pipes[id].tail = 0;
+    pipes[id].direct_pid = PIPE_NO_READER;
+    restore_flags(flags);
+
+    fd_array[read_fd].interface = &pipe_read_if;
+    fd_array[read_fd].inode = id;
+    fd_array[read_fd].pos = 0;
+    fd_array[read_fd].flags = 0;
+    fd_array[write_fd].interface = &pipe_write_if;
+    fd_array[write_fd].inode = id;
+    fd_array[write_fd].pos = 0;
+    fd_array[write_fd].flags = 0;
+    fds[0] = read_fd;
+    fds[1] = write_fd;
+    return SUCCESS;
+}
+
+/* uint32_t pipe_direct_transfer(pipe_t* pipe, const char* buf, uint32_t len)
+ * @input: pipe - an empty pipe
+ *         buf, len - data being written
+ * @output: ret val - bytes put straight into the buffer of the waiting
+ *     reader, 0 if there's none
+ * @description: the reader's user page is mapped for the kernel, or its
+ *     shared memory frames are written, so the data is copied once,
+ *     instead of into the ring and out of it again.
+ *     Must be called with interrupts off.
+ */
+static uint32_t pipe_direct_transfer(pipe_t* pipe, const char* buf, uint32_t len) {
+    int32_t pid = pipe->direct_pid;
+    if(PIPE_NO_READER == pid || pipe->tail != pipe->head) return 0;
+    // Offer is only good while the reader is still waiting in pipe_read
+    process_t* reader = process_get_pcb(pid);
+    if(NULL == reader || !reader->present || reader->wait_channel != pipe) {
+        pipe->direct_pid = PIPE_NO_READER;
+        return 0;
+    }
+    if(len > pipe->direct_len) len = pipe->direct_len;
+    if(pipe->direct_buf >= USER_SHM_BASE) {
+        // Buffer in shared memory of the reader
+        shm_copy_in(pipe->direct_buf, buf, len);
+    } else {
+        uint8_t* page = process_map_user_page(pid);
+        if(NULL == page) return 0;
+        memcpy(page + (pipe->direct_buf - USER_PAGE_BASE), buf, len);
+        process_unmap_user_page(pid);
+    }
+    *pipe->direct_done = len;
+    pipe->direct_pid = PIPE_NO_READER;
+    return len;
+}
+
+/* int32_t pipe_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len)
+ * @input: inode - id of the pipe
+ *         offset - ignored
+ *         buf, len - buffer to receive data
+ * @output: ret val - bytes read, 0 if all write ends are closed,
+ *     FAIL on invalid input or when interrupted by a signal
+ * @description: waits until there's data, then returns what's there, up
+ *     to len. While waiting, a user buffer is offered to writers, which may
+ *     fill it directly with a large write.
+ */
+int32_t pipe_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len) {
+    if(NULL == buf) return FAIL;
+    if(0 == len) return 0;
+    pipe_t* pipe = &pipes[*inode];
+    uint32_t flags;
+    cli_and_save(flags);
+    while(pipe->tail == pipe->head && pipe->writers > 0) {
+        uint32_t direct_done = 0;
+        if(PIPE_NO_READER == pipe->direct_pid && len >= PIPE_DIRECT_MIN
+            && -1 != active_process_id && !bad_userspace_addr(buf, len)) {
+            pipe->direct_pid = active_process_id;
+            pipe->direct_buf = (uint32_t) buf;
+            pipe->direct_len = len;
+            pipe->direct_done = &direct_done;
+        }
+        int32_t ret = process_wait(pipe);
+        // Withdraw the offer if nobody took it
+        if(pipe->direct_pid == active_process_id && pipe->direct_done == &direct_done) {
+            pipe->direct_pid = PIPE_NO_READER;
+        }
+        if(direct_done > 0) {
+            restore_flags(flags);
+            return direct_done;
+        }
+        if(FAIL == ret) {
+            restore_flags(flags);
+            return FAIL;
+        }
+    }
+
+    uint32_t count = pipe->tail - pipe->head;
+    if(count > len) count = len;
+    uint32_t start = pipe->head % PIPE_BUFFER_SIZE;
+    uint32_t first = PIPE_BUFFER_SIZE - start;
+    if(first > count) first = count;
+    memcpy(buf, pipe_buffers[*inode] + start, first);
+    memcpy(buf + first, pipe_buffers[*inode], count - first);
+    pipe->head += count;
+    // Writers waiting for space
+    if(count > 0) process_wake_all(pipe);
+    restore_flags(flags);
+    return count;
+}
+
+/* int32_t pipe_write(int32_t* inode, uint32_t* offset, const char* buf, uint32_t len)
+ * @input: inode - id of the pipe
+ *         offset - ignored
+ *         buf, len - data to be written
+ * @output: ret val - bytes written, FAIL if all read ends are closed
+ *     before anything is written
+ * @description: waits for space until all data is written, or the
+ *     read ends are closed, or a signal is to be handled.
+ */
+int32_t pipe_write(int32_t* inode, uint32_t* offset, const char* buf, uint32_t len) {
+    if(NULL == buf) return FAIL;
+    pipe_t* pipe = &pipes[*inode];
+    uint32_t done = 0;
+    uint32_t flags;
+    cli_and_save(flags);
+    while(done < len && pipe->readers > 0) {
+        if(len - done >= PIPE_DIRECT_MIN) {
+            uint32_t direct = pipe_direct_transfer(pipe, buf + done, len - done);
+            if(direct > 0) {
+                done += direct;
+                process_wake_all(pipe);
+                continue;
+            }
+        }
+
+        uint32_t space = PIPE_BUFFER_SIZE - (pipe->tail - pipe->head);
+        if(0 == space) {
+            if(FAIL == process_wait(pipe)) break;
+            continue;
+        }
+        uint32_t count = len - done;
+        if(count > space) count = space;
+        uint32_t start = pipe->tail % PIPE_BUFFER_SIZE;
+        uint32_t first = PIPE_BUFFER_SIZE - start;
+        if(first > count) first = count;
+        memcpy(pipe_buffers[*inode] + start, buf + done, first);
+        memcpy(pipe_buffers[*inode], buf + done + first, count - first);
+        pipe->tail += count;
+        done += count;
+        // Readers waiting for data
+        process_wake_all(pipe);
+    }
+    restore_flags(flags);
+    if(0 == done && len > 0) return FAIL;
+    return done;
+}
+
+/* void pipe_release(pipe_t* pipe)
+ * @input: pipe - a pipe with one of its ends just closed
+ * @output: the pipe freed if neither end is open, others waiting on it
+ *     woken up to see the end closed
+ * @description: must be called with interrupts off.
+ */
+static void pipe_release(pipe_t* pipe) {
+    if(0 == pipe->readers && 0 == pipe->writers) pipe->used = 0;
+    process_wake_all(pipe);
+}
+
+/* int32_t pipe_read_close(int32_t* inode)
+ * @input: inode - id of the pipe
+ * @output: ret val - SUCCESS
+ */
+int32_t pipe_read_close(int32_t* inode) {
+    pipe_t* pipe = &pipes[*inode];
+    uint32_t flags;
+    cli_and_save(flags);
+    pipe->readers--;
+    // Closed by a reader halting while it waits with its buffer offered
+    if(pipe->direct_pid == active_process_id) pipe->direct_pid = PIPE_NO_READER;
+    pipe_release(pipe);
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* int32_t pipe_write_close(int32_t* inode)
+ * @input: inode - id of the pipe
+ * @output: ret val - SUCCESS
+ */
+int32_t pipe_write_close(int32_t* inode) {
+    pipe_t* pipe = &pipes[*inode];
+    uint32_t flags;
+    cli_and_save(flags);
+    pipe->writers--;
+    pipe_release(pipe);
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* int32_t pipe_read_dup(int32_t* inode)
+ * @input: inode - id of the pipe
+ * @output: ret val - SUCCESS, read end counted once more
+ */
+int32_t pipe_read_dup(int32_t* inode) {
+    uint32_t flags;
+    cli_and_save(flags);
+    pipes[*inode].readers++;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* int32_t pipe_write_dup(int32_t* inode)
+ * @input: inode - id of the pipe
+ * @output: ret val - SUCCESS, write end counted once more
+ */
+int32_t pipe_write_dup(int32_t* inode) {
+    uint32_t flags;
+    cli_and_save(flags);
+    pipes[*inode].writers++;
+    restore_flags(flags);
+    return SUCCESS;
+}
@@ -0,0 +1,37 @@
+#ifndef _PIPE_H_
+#define _PIPE_H_
+
+#include "../lib/lib.h"
+#include "unified_fs.h"
+
+#define PIPE_COUNT 8
+#define PIPE_BUFFER_SIZE 4096   // One page of ring buffer per pipe
+// Writes at least this long go straight into the buffer of a waiting reader
+#define PIPE_DIRECT_MIN 512
+#define PIPE_NO_READER (-1)
+
+typedef struct {
+    uint8_t used;
+    uint32_t readers;           // Descriptors of the read end
+    uint32_t writers;           // Descriptors of the write end
+    uint32_t head;              // Bytes read so far, ring position is head % PIPE_BUFFER_SIZE
+    uint32_t tail;              // Bytes written so far
+    int32_t direct_pid;         // Reader waiting with its buffer offered, PIPE_NO_READER if none
+    uint32_t direct_buf;        // The buffer, user address in that process
+    uint32_t direct_len;
+    uint32_t* direct_done;      // Set to bytes put into the buffer, on reader's kernel stack
+} pipe_t;
+
+int32_t pipe_create(fd_array_t* fd_array, int32_t* fds);
+
+int32_t pipe_read(int32_t* inode, uint32_t* offset, char* buf, uint32_t len);
+int32_t pipe_write(int32_t* inode, uint32_t* offset, const char* buf, uint32_t len);
+int32_t pipe_read_close(int32_t* inode);
+int32_t pipe_write_close(int32_t* inode);
+int32_t pipe_read_dup(int32_t* inode);
+int32_t pipe_write_dup(int32_t* inode);
+
+extern unified_fs_interface_t pipe_read_if;
+extern unified_fs_interface_t pipe_write_if;
+
+#endif
@@ -8,6 +8,8 @@
 #include "../devices/cmos.h"
 #include "../devices/rng.h"
 #include "../devices/mouse.h"
+#include "../devices/qemu_vga.h"
+#include "../devices/screen.h"
 
 /* int32_t unified_init(fd_array_t* fd_array)
  * @input: fd_array - pointer to a file descriptor array
@@ -83,6 +85,12 @@ int32_t unified_open(fd_array_t* fd_array, const char* filename) {
     } else if(0 == strncmp("mouse", filename, 6)) {
         // Trying to open CMOS
         fd_array[fd].interface = &mouse_if;
+    } else if(0 == strncmp("vga", filename, 4)) {
+        // Trying to open QEMU VGA double buffer control
+        fd_array[fd].interface = &qemu_vga_if;
+    } else if(0 == strncmp("screen", filename, 7)) {
+        // Trying to open screen capture
+        fd_array[fd].interface = &screen_if;
     } else if(SUCCESS == read_dentry_by_name((char*) filename, &finfo)) {
         // File exists in ECE391FS
         switch(finfo.type) {
@@ -171,3 +179,25 @@ int32_t unified_close(fd_array_t* fd_array, int32_t fd) {
     fd_array[fd].interface = NULL;
     return SUCCESS;
 }
+
+/* int32_t unified_dup(fd_array_t* src_array, int32_t src_fd, fd_array_t* dest_array, int32_t dest_fd)
+ * @input: src_array, src_fd - an open file
+ *         dest_array, dest_fd - descriptor to refer to the same file,
+ *             in the same array or another process's
+ * @output: ret val - SUCCESS / FAIL
+ *          dest_array[dest_fd] - closed if open, then a copy of the source
+ * @description: the copy starts at the same position, and moves on its own.
+ *     Files counting their users, like pipes, are told through the dup handler.
+ */
+int32_t unified_dup(fd_array_t* src_array, int32_t src_fd, fd_array_t* dest_array, int32_t dest_fd) {
+    if(NULL == src_array || NULL == dest_array) return FAIL;
+    if(src_fd < 0 || src_fd >= MAX_OPEN_FILES) return FAIL;
+    if(dest_fd < 0 || dest_fd >= MAX_OPEN_FILES) return FAIL;
+    if(src_array[src_fd].interface == NULL) return FAIL;
+    if(src_array == dest_array && src_fd == dest_fd) return SUCCESS;
+    if(NULL != src_array[src_fd].interface->dup
+        && FAIL == (*src_array[src_fd].interface->dup) (&src_array[src_fd].inode)) return FAIL;
+    if(dest_array[dest_fd].interface != NULL) unified_close(dest_array, dest_fd);
+    dest_array[dest_fd] = src_array[src_fd];
+    return SUCCESS;
+}
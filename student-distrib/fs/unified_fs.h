@@ -9,6 +9,7 @@ typedef struct {
     int32_t (*write)(int32_t*, uint32_t*, const char*, uint32_t);
     int32_t (*ioctl)(int32_t*, uint32_t*, int32_t);
     int32_t (*close)(int32_t*);
+    int32_t (*dup)(int32_t*);   // Optional, another descriptor now refers to the file
 } unified_fs_interface_t;
 
 typedef struct {
@@ -29,5 +30,6 @@ int32_t unified_read(fd_array_t* fd_array, int32_t fd, void* buf, int32_t nbytes
 int32_t unified_write(fd_array_t* fd_array, int32_t fd, const void* buf, int32_t nbytes);
 int32_t unified_ioctl(fd_array_t* fd_array, int32_t fd, int32_t op);
 int32_t unified_close(fd_array_t* fd_array, int32_t fd);
+int32_t unified_dup(fd_array_t* src_array, int32_t src_fd, fd_array_t* dest_array, int32_t dest_fd);
 
 #endif
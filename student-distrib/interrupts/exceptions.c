@@ -1,5 +1,6 @@
 #include "exceptions.h"
 #include "../devices/vga_text.h"
+#include "multiprocessing.h"
 // #include "data/aqua.h"
 
 char *exceptions[20] = {
@@ -25,16 +26,26 @@ char *exceptions[20] = {
     "SIMD Floating Point Exception"
 };
 
-/* void exception_handler_real(char* message)
- * @input: message - reason of this exception
+/* void exception_handler_real(hw_context_t* context)
+ * @input: context - registers saved by exception wrapper, with exception
+ *             number in irq_exc and error code
  * @output: - a picture of anime character Aqua, on bottom right of screen
  *          - a big 00P5
  *          - reason of this exception
  * @effects: - interrupts are disabled
- *           - system put into infinite loop
+ *           - the current process is killed
  * @description: the function to handle all the different exceptions.
+ *     Exceptions in user mode go to the process's signal handler first,
+ *     if it has one.
  */
-void exception_handler_real(uint32_t id, pushal_t pushal, uint32_t err_code, iret_t iret) {
+void exception_handler_real(hw_context_t* context) {
+    uint32_t id = context->irq_exc;
+    uint32_t err_code = context->error_code;
+    if((context->cs & 0x3) == 0x3
+        && SUCCESS == signal_send(active_process_id, id == 0 ? SIGNAL_DIV_ZERO : SIGNAL_SEGFAULT)) {
+        return;
+    }
+
     cli();  // Disable interruption
 
     // Print the big 00P5 and exception message
@@ -47,11 +58,12 @@ void exception_handler_real(uint32_t id, pushal_t pushal, uint32_t err_code, ire
     */
     printf("The following exception happened:\n- %s\n", exceptions[id]);
 
-    printf("PushAL Info:\n");
-    printf("- EAX=0x%x, EBX=0x%x, ECX=0x%x, EDX=0x%x\n", pushal.eax, pushal.ebx, pushal.ecx, pushal.edx);
-    printf("- ESI=0x%x, EDI=0x%x, EBP=0x%x, ESP=0x%x\n", pushal.esi, pushal.edi, pushal.ebp, pushal.esp);
+    printf("Register Info:\n");
+    printf("- EAX=0x%x, EBX=0x%x, ECX=0x%x, EDX=0x%x\n", context->eax, context->ebx, context->ecx, context->edx);
+    printf("- ESI=0x%x, EDI=0x%x, EBP=0x%x\n", context->esi, context->edi, context->ebp);
     printf("IRet Info:\n");
-    printf("- EIP=0x%x, CS=0x%x, EFLAGS=0x%x, ESP=0x%x, SS=0x%x\n", iret.eip, iret.cs, iret.eflags, iret.esp, iret.ss);
+    printf("- EIP=0x%x, CS=0x%x, EFLAGS=0x%x\n", context->eip, context->cs, context->eflags);
+    if((context->cs & 0x3) == 0x3) printf("- ESP=0x%x, SS=0x%x\n", context->esp, context->ss);
     printf("Error Code: 0x%x\n", err_code);
 
     if(id == EXCEPTION_INVALID_TSS
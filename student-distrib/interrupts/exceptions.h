@@ -4,27 +4,9 @@
 #ifndef ASM
     #include "../lib/lib.h"
     #include "sys_calls.h"
+    #include "signal.h"
 
-    typedef struct {
-        uint32_t eip;
-        uint32_t cs;
-        uint32_t eflags;
-        uint32_t esp;
-        uint32_t ss;
-    } iret_t;
-
-    typedef struct {
-        uint32_t edi;
-        uint32_t esi;
-        uint32_t ebp;
-        uint32_t esp;
-        uint32_t ebx;
-        uint32_t edx;
-        uint32_t ecx;
-        uint32_t eax;
-    } pushal_t;
-
-    void exception_handler_real(uint32_t id, pushal_t pushal, uint32_t err_code, iret_t iret);
+    void exception_handler_real(hw_context_t* context);
 
 #endif
 
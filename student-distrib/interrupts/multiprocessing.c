@@ -1,8 +1,11 @@
 #include "multiprocessing.h"
 #include "../devices/keyboard.h"
 #include "../devices/qemu_vga.h"
-#include "../data/uiuc.h"
 #include "../lib/status_bar.h"
+#include "../lib/scrollback.h"
+#include "../devices/pit.h"
+#include "../lib/shm.h"
+#include "../lib/futex.h"
 
 char program_header[PROGRAM_HEADER_LEN] = {0x7f, 0x45, 0x4c, 0x46};
 
@@ -12,6 +15,9 @@ int32_t displayed_terminal_id = 0;
 int32_t active_terminal_id = 0;
 int32_t active_process_id = -1;
 
+// Present bit of the kernel mapping replaced by process_map_user_page
+static uint8_t process_user_page_was_present = 0;
+
 /* process_t* process_get_active_pcb()
  * @output: returns the PCB of currently active process.
  * @description: as stated above.
@@ -30,6 +36,16 @@ process_t* process_get_pcb(int32_t pid) {
     return (process_t*) (KERNEL_STACK_BASE_ADDR - (pid + 1) * USER_KMODE_STACK_SIZE);
 }
 
+/* process_t* process_get_group_pcb()
+ * @output: returns the PCB holding user page, files and arguments of
+ *     currently active process, which is the process itself unless it's a thread.
+ */
+process_t* process_get_group_pcb() {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process) return NULL;
+    return process_get_pcb(process->group_pid);
+}
+
 /* void process_init()
  * @output: multiprocessing structures get initialized
  * @description: as stated above.
@@ -70,6 +86,12 @@ void process_init() {
 
         // Set welcome screen to not shown
         terminals[i].welcome_shown = 0;
+
+        // Default color, full screen scroll region
+        terminals[i].attrib = ATTRIB;
+        terminals[i].scroll_top = 0;
+        terminals[i].scroll_bottom = NUM_ROWS - 1;
+        terminals[i].ansi_state.state = ANSI_STATE_NORMAL;
     }
 }
 
@@ -89,14 +111,13 @@ int32_t process_allocate() {
     return -1;
 }
 
-/* int32_t process_create(const char* command)
+/* int32_t process_load(const char* command)
  * @input: command - command entered via shell
- * @output: current terminal switches to the command called,
- *          or returns FAIL when the command is invalid
- * @description: actual code for the execute system call,
- *     creates a new process with given parameter and switches to it.
+ * @output: ret val - pid of new process with program loaded, paging switched to it,
+ *          or FAIL when the command is invalid
+ * @description: sets up a process on active terminal, without running it.
  */
-int32_t process_create(const char* command) {
+static int32_t process_load(const char* command) {
     if(NULL == command) return FAIL;
     if(command[0] == STRING_END) return FAIL;
 
@@ -149,8 +170,19 @@ int32_t process_create(const char* command) {
     process->esp = USER_STACK_ADDR;
     process->ebp = USER_STACK_ADDR;
     process->terminal = active_terminal_id;
-    terminals[active_terminal_id].active_process = pid;
     process->vidmap = 0;
+    process->background = 0;
+    process->started = 0;
+    process->blocked = 0;
+    process->sleeping = 0;
+    process->wait_channel = NULL;
+    process->shm_attached = 0;
+    process->thread = 0;
+    process->group_pid = pid;
+    process->signal_pending = 0;
+    process->signal_masked = 0;
+    process->alarm_tick = 0;
+    memset(process->signal_handlers, 0, sizeof(process->signal_handlers));
     memcpy(process->cmd, filename, MAX_ARG_LENGTH + 1);
     memcpy(process->arg, argument, MAX_ARG_LENGTH + 1);
 
@@ -164,20 +196,56 @@ int32_t process_create(const char* command) {
     if(FAIL == unified_close(process->fd_array, fd)) return FAIL;
     process->eip = (*(uint32_t*) (USER_PROCESS_ADDR + 24));
 
+    // Standard input / output are inherited, so shell can connect them to pipes.
+    // Done after loading, so a failed load doesn't hold pipe ends open
+    process_t* caller = process_get_group_pcb();
+    if(NULL != caller) {
+        for(fd = FD_STDIN; fd <= FD_STDOUT; fd++) {
+            if(NULL == caller->fd_array[fd].interface) continue;
+            unified_dup(caller->fd_array, fd, process->fd_array, fd);
+        }
+    }
+
     // Patch program
     executable_patching((char*) filename);
+    return pid;
+}
+
+/* int32_t process_create(const char* command)
+ * @input: command - command entered via shell
+ * @output: current terminal switches to the command called,
+ *          or returns FAIL when the command is invalid
+ * @description: actual code for the execute system call,
+ *     creates a new process with given parameter and switches to it.
+ *     Caller waits until it halts. Children of background processes
+ *     are in background too.
+ */
+int32_t process_create(const char* command) {
+    // A thread can't wait in execute, as its process may halt meanwhile
+    process_t* caller = process_get_active_pcb();
+    if(NULL != caller && caller->thread) return FAIL;
+
+    int32_t pid = process_load(command);
+    if(FAIL == pid) return FAIL;
+    process_t* process = process_get_pcb(pid);
 
     // Save the kernel stack of current process
     // Must be done directly in this function, or we'll screw up the kernel stack
     //   and get a page fault when attempting to return to this process
     process_t* ori_process = process_get_pcb(active_process_id);
+    if(NULL != ori_process && ori_process->background) {
+        process->background = 1;
+    } else {
+        terminals[active_terminal_id].active_process = pid;
+    }
     if(NULL != ori_process) {
+        ori_process->blocked = 1;
         asm volatile("movl %%esp, %0":"=r" (ori_process->esp));
         asm volatile("movl %%ebp, %0":"=r" (ori_process->ebp));
     } else if((!terminals[active_terminal_id].welcome_shown) && qemu_vga_enabled) {
-        // This is a terminal starting, show the splash image
+        // This is a terminal starting, splash image is already on it since boot
         terminals[active_terminal_id].welcome_shown = 1;
-        qemu_vga_show_picture(UIUC_IMAGE_WIDTH, UIUC_IMAGE_HEIGHT, 16, (uint8_t*) UIUC_IMAGE_DATA);
+        qemu_vga_skip_picture(qemu_vga_splash_height);
         // and a line indicating Chinese capability
         puts("本系统支持中文显示和输入 Chinese display & input supported\n");
     }
@@ -188,6 +256,194 @@ int32_t process_create(const char* command) {
     return SUCCESS;
 }
 
+/* int32_t process_spawn(const char* command)
+ * @input: command - command entered via shell
+ * @output: ret val - pid of new process, FAIL when the command is invalid
+ * @description: creates a background process on active terminal, and returns
+ *     right away. It's scheduled along with foreground processes of terminals,
+ *     and can't read from keyboard. Nobody waits for it to halt.
+ */
+int32_t process_spawn(const char* command) {
+    int32_t pid = process_load(command);
+    if(FAIL == pid) return FAIL;
+    process_t* process = process_get_pcb(pid);
+    process->background = 1;
+    process->parent_pid = -1;
+    // Loading the program switched paging over, switch it back
+    process_switch_paging(active_process_id);
+    return pid;
+}
+
+/* int32_t process_clone(uint32_t entry, uint32_t stack, uint32_t arg)
+ * @input: entry - where the thread starts in user space
+ *         stack - top of user stack of the thread, in the caller's user page
+ *         arg - passed to entry as its only argument
+ * @output: ret val - pid of new thread, FAIL if there's no pid left or input is invalid
+ * @description: creates a thread of active process. It shares the user page,
+ *     files and arguments of the process, with its own kernel stack and
+ *     registers, and is scheduled on its own. Threads end by calling halt,
+ *     and all of them are killed when their process halts.
+ */
+int32_t process_clone(uint32_t entry, uint32_t stack, uint32_t arg) {
+    process_t* group = process_get_group_pcb();
+    if(NULL == group) return FAIL;
+    uint32_t user_page = USER_PROCESS_ADDR >> PD_ADDR_OFFSET;
+    if((entry >> PD_ADDR_OFFSET) != user_page) return FAIL;
+    if(((stack - 1) >> PD_ADDR_OFFSET) != user_page
+        || ((stack - 2 * sizeof(uint32_t)) >> PD_ADDR_OFFSET) != user_page) return FAIL;
+
+    int32_t pid = process_allocate();
+    if(-1 == pid) return FAIL;
+    process_t* process = process_get_pcb(pid);
+    // Files are the process's, no handles of its own
+    memset(process->fd_array, 0, sizeof(process->fd_array));
+    process->parent_pid = -1;
+    process->group_pid = process_get_active_pcb()->group_pid;
+    process->thread = 1;
+    process->terminal = group->terminal;
+    process->vidmap = 0;
+    process->background = group->background;
+    process->started = 0;
+    process->blocked = 0;
+    process->sleeping = 0;
+    process->wait_channel = NULL;
+    process->shm_attached = 0;
+    process->signal_pending = 0;
+    process->signal_masked = 0;
+    process->alarm_tick = 0;
+    memcpy(process->signal_handlers, group->signal_handlers, sizeof(process->signal_handlers));
+    memcpy(process->cmd, group->cmd, MAX_ARG_LENGTH + 1);
+    memcpy(process->arg, group->arg, MAX_ARG_LENGTH + 1);
+
+    // Stack as if entry is called with arg, returning to an invalid address
+    stack -= sizeof(uint32_t);
+    *(uint32_t*) stack = arg;
+    stack -= sizeof(uint32_t);
+    *(uint32_t*) stack = 0;
+    process->eip = entry;
+    process->esp = stack;
+    process->ebp = stack;
+    return pid;
+}
+
+/* void process_wake(uint32_t pid)
+ * @input: pid - a sleeping process
+ * @output: process runnable again, if its sleep is due
+ * @description: timer event of process_sleep. Checks the deadline,
+ *     as the process may have been woken up early and sleeps again.
+ */
+static void process_wake(uint32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || !process->present || !process->sleeping) return;
+    if((int32_t) (pit_timer - process->wake_tick) < 0) return;
+    process->sleeping = 0;
+}
+
+/* int32_t process_sleep(uint32_t ticks)
+ * @input: ticks - PIT ticks to sleep
+ * @output: ret val - SUCCESS, or FAIL if there's no active process or timer left
+ * @description: takes active process out of scheduling until the ticks
+ *     pass, running other processes meanwhile. If no process can run,
+ *     the CPU idles until the next timer deadline.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t process_sleep(uint32_t ticks) {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process) return FAIL;
+    if(0 == ticks) return SUCCESS;
+    process->wake_tick = pit_timer + ticks;
+    if(FAIL == pit_timer_add(process->wake_tick, process_wake, active_process_id)) return FAIL;
+    process->sleeping = 1;
+    while(process->sleeping) {
+        // Comes back here once this process is woken up and scheduled
+        process_schedule();
+        if(process->sleeping) pit_idle();
+    }
+    // Woken up early by a signal, the timer event isn't needed anymore
+    if((int32_t) (pit_timer - process->wake_tick) < 0) {
+        pit_timer_cancel(process_wake, active_process_id);
+    }
+    return SUCCESS;
+}
+
+/* void process_cancel_sleep(int32_t pid)
+ * @input: pid - a process
+ * @output: process returns from sleep or process_wait on its next turn
+ * @description: used when the process is to be killed with Ctrl+C.
+ */
+void process_cancel_sleep(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process) return;
+    process->sleeping = 0;
+    process->wait_channel = NULL;
+}
+
+/* int32_t process_wait(void* channel)
+ * @input: channel - object the process waits for, like a pipe
+ * @output: ret val - SUCCESS when woken up by process_wake_all,
+ *     FAIL if there's no active process or a signal is to be handled
+ * @description: takes active process out of scheduling until another one
+ *     calls process_wake_all on the channel. Callers check their condition
+ *     again after it returns, as all waiters of a channel are woken up.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t process_wait(void* channel) {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process || NULL == channel) return FAIL;
+    process->wait_channel = channel;
+    while(NULL != process->wait_channel) {
+        // Comes back here once this process is woken up and scheduled
+        process_schedule();
+        if(NULL != process->wait_channel) pit_idle();
+    }
+    if(process->signal_pending & ~process->signal_masked) return FAIL;
+    return SUCCESS;
+}
+
+/* void process_wake_all(void* channel)
+ * @input: channel - object whose state changed
+ * @output: processes waiting on it are runnable again
+ */
+void process_wake_all(void* channel) {
+    int32_t pid;
+    for(pid = 0; pid < PROCESS_COUNT; pid++) {
+        process_t* process = process_get_pcb(pid);
+        if(process->present && process->wait_channel == channel) process->wait_channel = NULL;
+    }
+}
+
+/* void process_release(int32_t pid)
+ * @input: pid - a process or thread going away
+ * @output: its files closed, threads removed, shared memory detached,
+ *     and taken off futex and timer queues. The PCB is still present,
+ *     the caller frees it.
+ * @description: all cleanup of process_halt, also used to remove
+ *     a process that never ran.
+ */
+void process_release(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process) return;
+
+    // Close all files on process halt, as required by gradesheet.
+    // Threads have none of their own
+    int32_t i;
+    for(i = 0; i < MAX_NUM_FD_ENTRY; i++) {
+        unified_close(process->fd_array, i);
+    }
+    // Threads go away with the process whose memory they share
+    for(i = 0; !process->thread && i < PROCESS_COUNT; i++) {
+        process_t* thread = process_get_pcb(i);
+        if(thread->present && thread->thread && thread->group_pid == pid) {
+            process_release(i);
+            thread->present = 0;
+        }
+    }
+    shm_detach_all(&process->shm_attached);
+    futex_cancel(pid);
+    signal_alarm_cancel(pid);
+    pit_timer_cancel(process_wake, pid);
+}
+
 /* int32_t process_halt(uint8_t status)
  * @input: status - return code of the process.
  * @output: system switch to process's parent, if there's any,
@@ -202,13 +458,24 @@ int32_t process_halt(uint8_t status) {
     process_t* process = process_get_pcb(active_process_id);
     if(NULL == process) return FAIL;
 
-    // Close all files on process halt, as required by gradesheet
-    fd_array_t* fd_array = process->fd_array;
-    int i;
-    for(i = 0; i < MAX_NUM_FD_ENTRY; i++) {
-        unified_close(fd_array, i);
+    process_release(active_process_id);
+
+    if(process->thread || (process->background && -1 == process->parent_pid)) {
+        // Nobody waits for this process or thread, run something else.
+        // Its kernel stack is left behind for good, so never return to it,
+        // idle until another process is switched in instead
+        process->present = 0;
+        active_process_id = -1;
+        while(1) {
+            process_schedule();
+            pit_idle();
+        }
     }
 
+    // Don't leave colors or scroll region set by this process to its parent.
+    // Background processes share the terminal with its foreground one
+    if(!process->background) ansi_reset();
+
     if(-1 == process->parent_pid) {
         // This process is shell, need to be restarted
         // Remove this process from the terminal, making terminal empty
@@ -234,7 +501,8 @@ int32_t process_halt(uint8_t status) {
         if(NULL == process) return FAIL;
         // Make parent proces active
         active_process_id = parent;
-        terminals[active_terminal_id].active_process = parent;
+        process->blocked = 0;
+        if(!process->background) terminals[active_terminal_id].active_process = parent;
         // Switch kernel stack to parent process
         asm volatile ("         \n\
             movl %%ecx, %%esp   \n\
@@ -266,6 +534,9 @@ void process_switch_paging(int32_t pid) {
     if(pid < 0 || pid >= PROCESS_COUNT) return;
     process_t* process = process_get_pcb(pid);
     if(NULL == process) return;
+    // Threads use the page of their process
+    process_t* group = process_get_pcb(process->group_pid);
+    if(NULL == group) return;
 
     // get the entry in page directory for the input process
     uint32_t PD_index = (uint32_t) USER_PROCESS_ADDR >> PD_ADDR_OFFSET;
@@ -287,7 +558,7 @@ void process_switch_paging(int32_t pid) {
     page_directory[PD_index].pde_MB.reserved = 0;
     // physical address = PROCESS_PYSC_BASE_ADDR + process_count
     // first process gets 8-12M, second 12-16M, etc.
-    page_directory[PD_index].pde_MB.PB_addr = PROCESS_PYSC_BASE_ADDR + pid;
+    page_directory[PD_index].pde_MB.PB_addr = PROCESS_PYSC_BASE_ADDR + process->group_pid;
 
     // Redirect video mem R/W to main display / alt display based on terminal ids
     if(active_terminal_id == displayed_terminal_id) {
@@ -302,7 +573,9 @@ void process_switch_paging(int32_t pid) {
 
     // Enable video memory map to userspace only when process asked to do so
     // Other elements of this table is initialized in paging.c
-    page_table_usermap[VIDEO_MEM_INDEX].present = process->vidmap;
+    page_table_usermap[VIDEO_MEM_INDEX].present = group->vidmap;
+    // Shared memory segments, same for all threads of a process
+    shm_map(group->shm_attached);
 
     // flush the TLB by writing to the page directory base register (CR3)
     // reference: https://wiki.osdev.org/TLB
@@ -314,6 +587,39 @@ void process_switch_paging(int32_t pid) {
     );
 }
 
+/* uint8_t* process_map_user_page(int32_t pid)
+ * @input: pid - a process, may be other than the active one
+ * @output: ret val - where the process's user page is mapped for the kernel,
+ *     address in it = ret val + (user address - USER_PAGE_BASE),
+ *     NULL if there's no such process
+ * @description: enables the identity mapping of the page's physical address,
+ *     so data can be copied straight into another process's memory.
+ *     Must be undone with process_unmap_user_page before interrupts are enabled.
+ */
+uint8_t* process_map_user_page(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || !process->present) return NULL;
+    uint32_t index = PROCESS_PYSC_BASE_ADDR + process->group_pid;
+    process_user_page_was_present = page_directory[index].pde_MB.present;
+    page_directory[index].pde_MB.present = 1;
+    page_directory[index].pde_MB.read_write = 1;
+    asm volatile("invlpg (%0)" : : "r" (index << PD_ADDR_OFFSET) : "memory");
+    return (uint8_t*) (index << PD_ADDR_OFFSET);
+}
+
+/* void process_unmap_user_page(int32_t pid)
+ * @input: pid - process passed to process_map_user_page
+ * @output: kernel mapping of its user page removed
+ */
+void process_unmap_user_page(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process) return;
+    uint32_t index = PROCESS_PYSC_BASE_ADDR + process->group_pid;
+    page_directory[index].pde_MB.present = process_user_page_was_present;
+    page_directory[index].pde_MB.read_write = 0;
+    asm volatile("invlpg (%0)" : : "r" (index << PD_ADDR_OFFSET) : "memory");
+}
+
 /* void process_switch_context(int32_t pid)
  * @input: pid - pid of process we're switching to
  * @output: system start to execute another process
@@ -325,6 +631,7 @@ void process_switch_context(int32_t pid) {
     process_t* process = process_get_pcb(pid);
     if(NULL == process) return;
     active_process_id = pid;
+    process->started = 1;
     tss.esp0 = KERNEL_STACK_BASE_ADDR - active_process_id * USER_KMODE_STACK_SIZE - 0x4;
     // 1. set up stack: (top) EIP, CS, EFLAGS, ESP, SS (bottom)
     // 2. set DS to point to the correct entry in GDT for the user mode data segment
@@ -348,37 +655,40 @@ void process_switch_context(int32_t pid) {
     );
 }
 
-/* void terminal_switch_active(uint32_t tid)
- * @input: tid - id of terminal we're switching to
- * @output: the process running on terminal #tid is put to active running
- * @description: switch to process running on terminal #tid, to implement
- *     multiprocessing with background process scheduling.
+/* void process_run(int32_t tid, int32_t pid)
+ * @input: tid - terminal of the process
+ *         pid - process to switch to, -1 to start a shell on terminal #tid
+ * @output: process #pid is put to active running
+ * @description: saves the kernel stack of current process, and continues
+ *     on the one of process #pid. All switches between running processes
+ *     go through here, so a stack saved here is always restored here.
  *   Must be wrapped in CLI/STI.
  */
-void terminal_switch_active(uint32_t tid) {
-    if(tid < 0 || tid >= TERMINAL_COUNT) return;
-
+static void __attribute__((noinline)) process_run(int32_t tid, int32_t pid) {
     // Save the kernel stack of current process
     process_t* process = process_get_pcb(active_process_id);
     if(NULL != process) {
         asm volatile("movl %%esp, %0":"=r" (process->esp));
         asm volatile("movl %%ebp, %0":"=r" (process->ebp));
         // printf("saved %d, esp %x, ebp %x\n", active_process_id, process->esp, process->ebp);
+        if(!process->background) terminals[active_terminal_id].active_process = active_process_id;
     }
 
-    terminals[active_terminal_id].active_process = active_process_id;
     // Switch to another terminal and corresponding process
     active_terminal_id = tid;
-    active_process_id = terminals[tid].active_process;
-    if(active_process_id == -1) {
+    active_process_id = pid;
+    process = process_get_pcb(pid);
+    if(NULL == process) {
         // If nothing is running there, create a shell
         process_create("shell");
+    } else if(!process->started) {
+        // Background process running for the first time
+        process_switch_paging(pid);
+        process_switch_context(pid);
     } else {
         // Switch to that process, just as done in process_halt, except the status part
         tss.esp0 = KERNEL_STACK_BASE_ADDR - active_process_id * USER_KMODE_STACK_SIZE - 0x4;
         process_switch_paging(active_process_id);
-        process_t* process = process_get_pcb(active_process_id);
-        if(NULL == process) return;
 
         // printf("restore %d, esp %x, ebp %x\n", active_process_id, process->esp, process->ebp);
         asm volatile ("         \n\
@@ -390,13 +700,63 @@ void terminal_switch_active(uint32_t tid) {
             : "memory"
         );
     }
-    // If a Ctrl+C is scheduled but not yet done, kill the current process
-    if(ctrl_c_pending && (active_terminal_id == displayed_terminal_id)) {
+    // If a Ctrl+C is scheduled but not yet done, kill the current foreground process
+    if(ctrl_c_pending && (active_terminal_id == displayed_terminal_id)
+        && (terminals[active_terminal_id].active_process == active_process_id)) {
         ctrl_c_pending = 0;
         syscall_halt(255);
     }
 }
 
+/* int32_t process_runnable(int32_t pid)
+ * @input: pid - a process
+ * @output: ret val - 1 if it can be scheduled, 0 if not
+ * @description: foreground process of a terminal, a background one,
+ *     or a thread, that isn't waiting for a child to halt or sleeping.
+ */
+static int32_t process_runnable(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || !process->present || process->blocked || process->sleeping) return 0;
+    return process->background || process->thread
+        || terminals[process->terminal].active_process == pid;
+}
+
+/* void process_schedule()
+ * @output: next process in round robin order is put to active running
+ * @description: runs foreground process of each terminal and background
+ *     processes in turn, to implement multiprocessing. Terminals without
+ *     any process start their shells first.
+ *   Must be wrapped in CLI/STI.
+ */
+void process_schedule() {
+    int32_t i;
+    for(i = 1; i <= TERMINAL_COUNT; i++) {
+        int32_t tid = (active_terminal_id + i) % TERMINAL_COUNT;
+        if(-1 == terminals[tid].active_process) {
+            process_run(tid, -1);
+            return;
+        }
+    }
+    for(i = 1; i <= PROCESS_COUNT; i++) {
+        int32_t pid = (active_process_id + i) % PROCESS_COUNT;
+        if(!process_runnable(pid)) continue;
+        process_run(process_get_pcb(pid)->terminal, pid);
+        return;
+    }
+}
+
+/* void terminal_switch_active(uint32_t tid)
+ * @input: tid - id of terminal we're switching to
+ * @output: the foreground process running on terminal #tid is put to active running
+ * @description: switch to process running on terminal #tid, used to handle
+ *     keyboard input in context of the displayed terminal.
+ *   Must be wrapped in CLI/STI.
+ */
+void terminal_switch_active(uint32_t tid) {
+    if(tid < 0 || tid >= TERMINAL_COUNT) return;
+    process_run(tid, terminals[tid].active_process);
+}
+
 /* void terminal_switch_display(uint32_t tid)
  * @input: tid - id of terminal we're switching display to
  * @output: displayed terminal switches to #tid
@@ -405,6 +765,9 @@ void terminal_switch_active(uint32_t tid) {
 void terminal_switch_display(uint32_t tid) {
     if(tid < 0 || tid >= TERMINAL_COUNT) return;
 
+    // Don't save history shown on screen as terminal content
+    scrollback_reset(displayed_terminal_id);
+
     char* addr;
 
     // Copy current terminal content to an alternate location
@@ -10,12 +10,15 @@
 #include "../devices/keyboard.h"
 #include "../devices/qemu_vga.h"
 #include "../lib/chinese_input.h"
+#include "../lib/ansi.h"
+#include "signal.h"
 
 #define STRING_END              '\0'
 #define SPACE                   ' '
 #define USER_PROCESS_ADDR       0x08048000
 #define USER_STACK_ADDR         (0x08400000 - 0x4)
 #define USER_PAGE_SIZE          0x400000               // 4 MB
+#define USER_PAGE_BASE          0x08000000             // 128 MB, virtual address of user page
 #define PD_ADDR_OFFSET          22
 #define PROCESS_PYSC_BASE_ADDR  2                      // 8-12 MB
 #define MAX_NUM_FD_ENTRY        8                      // Up to 8 open files per task
@@ -41,6 +44,19 @@ typedef struct process_control_block {
     uint32_t eip;                           // save eip;
     uint32_t terminal;                      // terminal id
     uint32_t vidmap;                        // is vidmap enabled
+    uint8_t background;                     // scheduled on its own, not as terminal's active process
+    uint8_t started;                        // has entered user mode
+    uint8_t blocked;                        // waiting in execute for a child to halt
+    uint8_t sleeping;                       // waiting in sleep until wake_tick
+    uint32_t wake_tick;                     // value of pit_timer to stop sleeping at
+    void* wait_channel;                     // object waited on by process_wait, NULL if not waiting
+    uint32_t signal_pending;                // bit per signal sent but not yet handled
+    uint32_t signal_masked;                 // signals held while a handler runs
+    void* signal_handlers[SIGNAL_COUNT];    // user handlers, NULL for default action
+    uint32_t alarm_tick;                    // value of pit_timer to send SIGNAL_ALARM at, 0 if none
+    uint32_t shm_attached;                  // bit per shared memory segment mapped
+    uint8_t thread;                         // created by clone, shares another process's memory
+    int32_t group_pid;                      // process whose user page, files and arguments are used
     char cmd[MAX_ARG_LENGTH + 1];           // process executable name
     char arg[MAX_ARG_LENGTH + 1];           // argument to process
 } process_t;
@@ -57,6 +73,10 @@ typedef struct {
     utf8_state_t utf8_state;                        // UTF-8 character state
     chinese_input_buf_t chinese_input_buf;          // Chinese IME state
     uint8_t welcome_shown;                          // Has shown logo on this terminal
+    uint8_t attrib;                                 // Color of printed text
+    uint8_t scroll_top;                             // Rows [scroll_top, scroll_bottom]
+    uint8_t scroll_bottom;                          //   roll up on line feed
+    ansi_state_t ansi_state;                        // Escape sequence parser state
 } terminal_t;
 
 #define TERMINAL_COUNT 3
@@ -84,12 +104,23 @@ extern int32_t active_process_id;
 
 process_t* process_get_active_pcb();
 process_t* process_get_pcb(int32_t pid);
+process_t* process_get_group_pcb();
 void process_init();
 int32_t process_allocate();
 int32_t process_create(const char* command);
+int32_t process_spawn(const char* command);
+int32_t process_clone(uint32_t entry, uint32_t stack, uint32_t arg);
+int32_t process_sleep(uint32_t ticks);
+void process_cancel_sleep(int32_t pid);
+int32_t process_wait(void* channel);
+void process_wake_all(void* channel);
+uint8_t* process_map_user_page(int32_t pid);
+void process_unmap_user_page(int32_t pid);
+void process_release(int32_t pid);
 int32_t process_halt(uint8_t status);
 void process_switch_paging(int32_t pid);
 void process_switch_context(int32_t pid);
+void process_schedule();
 
 void terminal_switch_active(uint32_t tid);
 void terminal_switch_display(uint32_t tid);
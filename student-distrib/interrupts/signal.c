@@ -0,0 +1,195 @@
+#include "signal.h"
+#include "multiprocessing.h"
+#include "sys_calls.h"
+#include "../devices/pit.h"
+
+// Handler returns here, it calls sigreturn
+static const uint8_t signal_trampoline[SIGNAL_TRAMPOLINE_SIZE] = {
+    0xb8, 0x0a, 0x00, 0x00, 0x00,   // movl $10, %eax
+    0xcd, 0x80,                     // int $0x80
+    0x90                            // nop
+};
+
+/* int32_t signal_send(int32_t pid, uint32_t signum)
+ * @input: pid - process to receive the signal
+ *         signum - SIGNAL_*
+ * @output: ret val - SUCCESS if a user handler will run, FAIL if the
+ *     caller should take the default action instead
+ * @description: the handler runs when the process next returns to user mode.
+ *     Default actions are killing the process for DIV_ZERO, SEGFAULT and
+ *     INTERRUPT, and doing nothing for the rest, left to the caller as
+ *     each of them kills the process in its own way.
+ */
+int32_t signal_send(int32_t pid, uint32_t signum) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || !process->present || signum >= SIGNAL_COUNT) return FAIL;
+    if(NULL == process->signal_handlers[signum]) return FAIL;
+    // A fault in a handler can't be handled by running the handler again
+    if((SIGNAL_DIV_ZERO == signum || SIGNAL_SEGFAULT == signum) && process->signal_masked) return FAIL;
+    uint32_t flags;
+    cli_and_save(flags);
+    process->signal_pending |= 1 << signum;
+    restore_flags(flags);
+    // Return from sleep or process_wait to run the handler
+    process->sleeping = 0;
+    process->wait_channel = NULL;
+    return SUCCESS;
+}
+
+/* void signal_send_io(void* interface)
+ * @input: interface - unified_fs_interface_t of a device that has data
+ * @output: SIGNAL_IO sent to processes with the device open and a handler for it
+ * @description: lets event driven programs wait without polling.
+ */
+void signal_send_io(void* interface) {
+    int32_t pid;
+    int fd;
+    for(pid = 0; pid < PROCESS_COUNT; pid++) {
+        process_t* process = process_get_pcb(pid);
+        if(!process->present || NULL == process->signal_handlers[SIGNAL_IO]) continue;
+        // Threads share files of their process
+        process_t* group = process_get_pcb(process->group_pid);
+        for(fd = 0; fd < MAX_NUM_FD_ENTRY; fd++) {
+            if(group->fd_array[fd].interface == interface) {
+                signal_send(pid, SIGNAL_IO);
+                break;
+            }
+        }
+    }
+}
+
+/* void signal_deliver(hw_context_t* context)
+ * @input: context - registers saved on kernel entry, about to be restored
+ * @output: if a signal is pending and not masked, context changed to
+ *     run its handler, with the signal number as argument
+ * @description: called before every return to user mode. The user stack
+ *     gets, from top: return address into the trampoline, signal number,
+ *     the saved context, and the trampoline. Other signals are masked until
+ *     sigreturn. If the stack doesn't fit, the process is killed.
+ */
+void signal_deliver(hw_context_t* context) {
+    if((context->cs & 0x3) != 0x3) return;
+    uint32_t flags;
+    cli_and_save(flags);
+    process_t* process = process_get_active_pcb();
+    if(NULL == process) {
+        restore_flags(flags);
+        return;
+    }
+    uint32_t deliverable = process->signal_pending & ~process->signal_masked;
+    if(0 == deliverable) {
+        restore_flags(flags);
+        return;
+    }
+    uint32_t signum = 0;
+    while(!(deliverable & (1 << signum))) signum++;
+    process->signal_pending &= ~(1 << signum);
+    void* handler = process->signal_handlers[signum];
+    if(NULL == handler) {
+        // Handler removed after the signal was sent
+        restore_flags(flags);
+        return;
+    }
+
+    uint32_t esp = context->esp - SIGNAL_TRAMPOLINE_SIZE;
+    uint32_t trampoline = esp;
+    esp -= sizeof(hw_context_t);
+    uint32_t saved = esp;
+    esp -= 2 * sizeof(uint32_t);
+    if(bad_userspace_addr((void*) esp, context->esp - esp)) {
+        restore_flags(flags);
+        syscall_halt(255);
+        return;
+    }
+    memcpy((void*) trampoline, signal_trampoline, SIGNAL_TRAMPOLINE_SIZE);
+    memcpy((void*) saved, context, sizeof(hw_context_t));
+    ((uint32_t*) esp)[0] = trampoline;
+    ((uint32_t*) esp)[1] = signum;
+
+    process->signal_masked = SIGNAL_MASK_ALL;
+    context->esp = esp;
+    context->eip = (uint32_t) handler;
+    restore_flags(flags);
+}
+
+/* int32_t signal_set_handler(uint32_t signum, void* handler)
+ * @input: signum - SIGNAL_*
+ *         handler - user function taking signal number, NULL for default action
+ * @output: ret val - SUCCESS / FAIL
+ */
+int32_t signal_set_handler(uint32_t signum, void* handler) {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process || signum >= SIGNAL_COUNT) return FAIL;
+    if(NULL != handler && bad_userspace_addr(handler, 1)) return FAIL;
+    process->signal_handlers[signum] = handler;
+    return SUCCESS;
+}
+
+/* int32_t signal_return()
+ * @output: ret val - eax before the handler ran, so the system call
+ *     return path puts it back
+ * @description: sigreturn, restores registers saved by signal_deliver from
+ *     user stack, which the handler may have changed. Segments and
+ *     privileged flags are kept as user mode ones.
+ */
+int32_t signal_return() {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process) return FAIL;
+    hw_context_t* context = (hw_context_t*) (tss.esp0 - sizeof(hw_context_t));
+    // Handler has returned into the trampoline, popping the return address
+    hw_context_t* saved = (hw_context_t*) (context->esp + sizeof(uint32_t));
+    if(bad_userspace_addr(saved, sizeof(hw_context_t))) return FAIL;
+
+    uint32_t eflags = context->eflags;
+    memcpy(context, saved, sizeof(hw_context_t));
+    context->ds = context->es = context->fs = context->ss = USER_DS;
+    context->cs = USER_CS;
+    context->eflags = (context->eflags & SIGNAL_USER_EFLAGS) | (eflags & ~SIGNAL_USER_EFLAGS);
+    process->signal_masked = 0;
+    return context->eax;
+}
+
+/* void signal_alarm_fire(uint32_t pid)
+ * @input: pid - process that set the alarm
+ * @output: SIGNAL_ALARM sent if the alarm is still set for now
+ * @description: timer event of signal_alarm. Checks the deadline,
+ *     as the alarm may have been changed since the event was added.
+ */
+static void signal_alarm_fire(uint32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || !process->present || 0 == process->alarm_tick) return;
+    if((int32_t) (pit_timer - process->alarm_tick) < 0) return;
+    process->alarm_tick = 0;
+    signal_send(pid, SIGNAL_ALARM);
+}
+
+/* int32_t signal_alarm(uint32_t ms)
+ * @input: ms - time until SIGNAL_ALARM is sent, 0 to cancel the alarm
+ * @output: ret val - SUCCESS / FAIL
+ * @description: replaces an alarm set before, whose timer event is removed.
+ */
+int32_t signal_alarm(uint32_t ms) {
+    process_t* process = process_get_active_pcb();
+    if(NULL == process) return FAIL;
+    signal_alarm_cancel(active_process_id);
+    if(0 == ms) return SUCCESS;
+    uint32_t ticks = ms / MS_PER_TICK + (ms % MS_PER_TICK ? 1 : 0);
+    if(ticks > ALARM_MAX_TICKS) return FAIL;
+    // 0 means no alarm
+    uint32_t deadline = pit_timer + ticks;
+    if(0 == deadline) deadline = 1;
+    if(FAIL == pit_timer_add(deadline, signal_alarm_fire, active_process_id)) return FAIL;
+    process->alarm_tick = deadline;
+    return SUCCESS;
+}
+
+/* void signal_alarm_cancel(int32_t pid)
+ * @input: pid - a process
+ * @output: its alarm cleared, and the timer event removed
+ */
+void signal_alarm_cancel(int32_t pid) {
+    process_t* process = process_get_pcb(pid);
+    if(NULL == process || 0 == process->alarm_tick) return;
+    pit_timer_cancel(signal_alarm_fire, pid);
+    process->alarm_tick = 0;
+}
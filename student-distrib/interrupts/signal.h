@@ -0,0 +1,90 @@
+#ifndef _SIGNAL_H_
+#define _SIGNAL_H_
+
+// Signal numbers, same as enum signums of user programs
+#define SIGNAL_DIV_ZERO     0
+#define SIGNAL_SEGFAULT     1
+#define SIGNAL_INTERRUPT    2
+#define SIGNAL_ALARM        3
+#define SIGNAL_USER1        4
+#define SIGNAL_IO           5   // A device the process has open has data
+#define SIGNAL_COUNT        6
+
+#define SIGNAL_MASK_ALL     ((1 << SIGNAL_COUNT) - 1)
+
+// "movl $10, %eax; int $0x80", copied onto user stack for handlers to return to
+#define SIGNAL_TRAMPOLINE_SIZE 8
+
+#define HW_CONTEXT_EAX      24  // Offset of eax in hw_context_t
+
+// EFLAGS bits a handler may change in saved context: CF, PF, AF, ZF, SF, TF, DF, OF
+#define SIGNAL_USER_EFLAGS  0x0dd5
+// Longest alarm, so the deadline doesn't wrap around pit_timer
+#define ALARM_MAX_TICKS     0x7fffffff
+
+/* Save / restore all registers into / from hw_context_t, on kernel stack.
+ * Before HW_CONTEXT_SAVE, error code and interrupt / exception number
+ * have to be pushed after what the CPU pushed. HW_CONTEXT_RESTORE returns
+ * to where the interrupt came from.
+ */
+#define HW_CONTEXT_SAVE \
+    pushl %fs       ;\
+    pushl %es       ;\
+    pushl %ds       ;\
+    pushl %eax      ;\
+    pushl %ebp      ;\
+    pushl %edi      ;\
+    pushl %esi      ;\
+    pushl %edx      ;\
+    pushl %ecx      ;\
+    pushl %ebx
+
+#define HW_CONTEXT_RESTORE \
+    popl %ebx       ;\
+    popl %ecx       ;\
+    popl %edx       ;\
+    popl %esi       ;\
+    popl %edi       ;\
+    popl %ebp       ;\
+    popl %eax       ;\
+    popl %ds        ;\
+    popl %es        ;\
+    popl %fs        ;\
+    addl $8, %esp   ;\
+    iret
+
+#ifndef ASM
+    #include "../lib/lib.h"
+
+    // Registers saved on kernel entry, also put on user stack for signal handlers.
+    // esp and ss are only there when coming from user mode.
+    typedef struct {
+        uint32_t ebx;
+        uint32_t ecx;
+        uint32_t edx;
+        uint32_t esi;
+        uint32_t edi;
+        uint32_t ebp;
+        uint32_t eax;
+        uint32_t ds;
+        uint32_t es;
+        uint32_t fs;
+        uint32_t irq_exc;
+        uint32_t error_code;
+        uint32_t eip;
+        uint32_t cs;
+        uint32_t eflags;
+        uint32_t esp;
+        uint32_t ss;
+    } hw_context_t;
+
+    int32_t signal_send(int32_t pid, uint32_t signum);
+    void signal_send_io(void* interface);
+    void signal_deliver(hw_context_t* context);
+    int32_t signal_set_handler(uint32_t signum, void* handler);
+    int32_t signal_return();
+    int32_t signal_alarm(uint32_t ms);
+    void signal_alarm_cancel(int32_t pid);
+#endif
+
+#endif
@@ -5,6 +5,10 @@
 #include "../devices/vga_text.h"
 #include "../devices/qemu_vga.h"
 #include "../lib/status_bar.h"
+#include "../lib/scrollback.h"
+#include "../fs/pipe.h"
+#include "../lib/shm.h"
+#include "../lib/futex.h"
 // System calls for checkpoint 3.
 
 /*
@@ -25,11 +29,24 @@ int32_t syscall_halt (uint8_t status)
 /*
  * int32_t syscall_execute (const uint8_t* command)
  * system call execute
- * INPUT: command - command for system call
+ * INPUT: command - command for system call,
+ *                  ending with "&" to run it in background without waiting
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_execute (const uint8_t* command)
 {
+    if(NULL == command) return FAIL;
+    int32_t len = strlen((const int8_t*) command);
+    while(len > 0 && command[len - 1] == ' ') len--;
+    if(len > 0 && command[len - 1] == '&') {
+        // Shell gets back right away, as if the job exited normally
+        char job[SPAWN_COMMAND_LEN + 1];
+        if(len - 1 > SPAWN_COMMAND_LEN) return FAIL;
+        memcpy(job, command, len - 1);
+        job[len - 1] = '\0';
+        return (FAIL == syscall_spawn((const uint8_t*) job)) ? FAIL : SUCCESS;
+    }
+
     cli();
     int32_t ret = process_create((const char*) command);
     sti();
@@ -45,7 +62,7 @@ int32_t syscall_execute (const uint8_t* command)
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_read (int32_t fd, void* buf, int32_t nbytes){
-    pcb_t* pcb = process_get_active_pcb();
+    pcb_t* pcb = process_get_group_pcb();
     return unified_read(pcb->fd_array, fd, buf, nbytes);
 }
 
@@ -58,7 +75,7 @@ int32_t syscall_read (int32_t fd, void* buf, int32_t nbytes){
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_write (int32_t fd, const void* buf, int32_t nbytes){
-    pcb_t* pcb = process_get_active_pcb();
+    pcb_t* pcb = process_get_group_pcb();
     return unified_write(pcb->fd_array, fd, buf, nbytes);
 }
 
@@ -69,7 +86,7 @@ int32_t syscall_write (int32_t fd, const void* buf, int32_t nbytes){
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_open (const uint8_t* filename){
-    pcb_t* pcb = process_get_active_pcb();
+    pcb_t* pcb = process_get_group_pcb();
     return unified_open(pcb->fd_array, (const char*) filename);
 }
 
@@ -80,7 +97,7 @@ int32_t syscall_open (const uint8_t* filename){
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_close (int32_t fd){
-    pcb_t* pcb = process_get_active_pcb();
+    pcb_t* pcb = process_get_group_pcb();
     return unified_close(pcb->fd_array, fd);
 }
 
@@ -124,7 +141,7 @@ int32_t syscall_vidmap (uint8_t** screen_start)
         != ((uint32_t) USER_PROCESS_ADDR >> PD_ADDR_OFFSET)) return FAIL;
 
     // Enable vidmap for this process, reset its paging
-    process_get_active_pcb()->vidmap = 1;
+    process_get_group_pcb()->vidmap = 1;
     process_switch_paging(active_process_id);
 
     // Return the address
@@ -133,12 +150,201 @@ int32_t syscall_vidmap (uint8_t** screen_start)
 }
 
 //Extra credit system calls.
+/*
+ * int32_t syscall_spawn (const uint8_t* command)
+ * @input: command - command to run, same as execute
+ * @output: ret val - pid of the background process, FAIL if it can't be created
+ * @description: runs a command in background on current terminal,
+ *     without waiting for it to halt.
+ */
+int32_t syscall_spawn (const uint8_t* command)
+{
+    cli();
+    int32_t ret = process_spawn((const char*) command);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_clone (void* entry, void* stack, void* arg)
+ * @input: entry - function the thread runs, called with arg
+ *         stack - top of the thread's stack, in the process's memory
+ *         arg - argument passed to entry
+ * @output: ret val - pid of the thread, FAIL if it can't be created
+ * @description: starts a thread sharing memory and files with the caller.
+ *     It ends with halt, and shouldn't return from entry.
+ */
+int32_t syscall_clone (void* entry, void* stack, void* arg)
+{
+    cli();
+    int32_t ret = process_clone((uint32_t) entry, (uint32_t) stack, (uint32_t) arg);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_sleep (uint32_t ms)
+ * @input: ms - milliseconds to sleep, rounded up to PIT ticks
+ * @output: ret val - SUCCESS / FAIL
+ * @description: blocks the caller without spinning, other processes run meanwhile.
+ */
+int32_t syscall_sleep (uint32_t ms)
+{
+    cli();
+    int32_t ret = process_sleep(ms / MS_PER_TICK + (ms % MS_PER_TICK ? 1 : 0));
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_nanosleep (uint32_t sec, uint32_t nsec)
+ * @input: sec, nsec - time to sleep, nsec below a second
+ * @output: ret val - SUCCESS / FAIL
+ * @description: same as sleep, with time rounded up to PIT ticks.
+ */
+int32_t syscall_nanosleep (uint32_t sec, uint32_t nsec)
+{
+    if(nsec >= NS_IN_S || sec > NANOSLEEP_MAX_SEC) return FAIL;
+    cli();
+    int32_t ret = process_sleep(sec * PIT_FREQ + (nsec + NS_PER_TICK - 1) / NS_PER_TICK);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_clock_gettime (uint32_t clock_id, timespec_t* ts)
+ * @input: clock_id - CLOCK_REALTIME / CLOCK_MONOTONIC
+ *         ts - receives seconds and nanoseconds
+ * @output: ret val - SUCCESS / FAIL
+ * @description: nanosecond resolution if TSC is available, PIT ticks otherwise.
+ */
+int32_t syscall_clock_gettime (uint32_t clock_id, timespec_t* ts)
+{
+    if(bad_userspace_addr(ts, sizeof(timespec_t))) return FAIL;
+    return clock_gettime(clock_id, ts);
+}
+
+/* int32_t syscall_set_handler (int32_t signum, void* handler_address)
+ * @input: signum - signal to be handled
+ *         handler_address - user function taking signal number, NULL for default action
+ * @output: ret val - SUCCESS / FAIL
+ */
 int32_t syscall_set_handler (int32_t signum, void* handler_address){
-    return FAIL;
+    return signal_set_handler(signum, handler_address);
 }
 
+/* int32_t syscall_sigreturn (void)
+ * @output: ret val - eax of the context interrupted by the signal
+ * @description: called by the trampoline a signal handler returns to.
+ */
 int32_t syscall_sigreturn (void){
-    return FAIL;
+    return signal_return();
+}
+
+/* int32_t syscall_alarm (uint32_t ms)
+ * @input: ms - time until ALARM signal, 0 to cancel
+ * @output: ret val - SUCCESS / FAIL
+ */
+int32_t syscall_alarm (uint32_t ms)
+{
+    cli();
+    int32_t ret = signal_alarm(ms);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_pipe (int32_t* fds)
+ * @input: fds - receives descriptors of read end, then write end
+ * @output: ret val - SUCCESS / FAIL
+ * @description: reads wait for data, writes wait for space. Read returns 0
+ *     once all write ends are closed, write fails once all read ends are.
+ */
+int32_t syscall_pipe (int32_t* fds)
+{
+    if(bad_userspace_addr(fds, 2 * sizeof(int32_t))) return FAIL;
+    cli();
+    int32_t ret = pipe_create(process_get_group_pcb()->fd_array, fds);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_dup2 (int32_t fd, int32_t new_fd)
+ * @input: fd - an open file
+ *         new_fd - descriptor to refer to the same file, closed first if open
+ * @output: ret val - SUCCESS / FAIL
+ * @description: lets shell point standard input / output of the
+ *     commands it runs to pipes, as they're inherited.
+ */
+int32_t syscall_dup2 (int32_t fd, int32_t new_fd)
+{
+    pcb_t* pcb = process_get_group_pcb();
+    cli();
+    int32_t ret = unified_dup(pcb->fd_array, fd, pcb->fd_array, new_fd);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_shm_create (uint32_t key, uint32_t size)
+ * @input: key - chosen by programs sharing the segment
+ *         size - bytes needed
+ * @output: ret val - id of the segment, attached to the caller, FAIL if
+ *     it can't be created. An existing segment with the key is attached.
+ */
+int32_t syscall_shm_create (uint32_t key, uint32_t size)
+{
+    cli();
+    int32_t ret = shm_create(key, size);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_shm_attach (int32_t id)
+ * @input: id - a segment from shm_create
+ * @output: ret val - address of the segment, the same in every process, or FAIL
+ */
+int32_t syscall_shm_attach (int32_t id)
+{
+    cli();
+    int32_t ret = shm_attach(id);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_shm_detach (int32_t id)
+ * @input: id - a segment attached to the caller
+ * @output: ret val - SUCCESS / FAIL
+ * @description: segments are also detached on halt.
+ */
+int32_t syscall_shm_detach (int32_t id)
+{
+    cli();
+    int32_t ret = shm_detach(id);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_futex_wait (uint32_t* addr, uint32_t val)
+ * @input: addr - a word in user memory, in the user page or shared memory
+ *         val - value the caller saw in it
+ * @output: ret val - SUCCESS when woken up, FAIL if the word has changed
+ * @description: lets user mutexes and condition variables block only
+ *     when contended, without spinning.
+ */
+int32_t syscall_futex_wait (uint32_t* addr, uint32_t val)
+{
+    cli();
+    int32_t ret = futex_wait(addr, val);
+    sti();
+    return ret;
+}
+
+/* int32_t syscall_futex_wake (uint32_t* addr, uint32_t count)
+ * @input: addr - a word in user memory
+ *         count - most waiters to wake up
+ * @output: ret val - waiters woken up, or FAIL
+ */
+int32_t syscall_futex_wake (uint32_t* addr, uint32_t count)
+{
+    cli();
+    int32_t ret = futex_wake(addr, count);
+    sti();
+    return ret;
 }
 
 /*
@@ -149,7 +355,7 @@ int32_t syscall_sigreturn (void){
  * OUTPUT: SUCCESS and FAIL
  */
 int32_t syscall_ioctl (int32_t fd, int32_t op){
-    pcb_t* pcb = process_get_active_pcb();
+    pcb_t* pcb = process_get_group_pcb();
     return unified_ioctl(pcb->fd_array, fd, op);
 }
 
@@ -185,6 +391,12 @@ int32_t syscall_ps(void) {
             if(terminals[pcb->terminal].active_process == pid) {
                 puts(" (active)");
             }
+            if(pcb->background) {
+                puts(" (background)");
+            }
+            if(pcb->thread) {
+                printf(" (thread of %d)", pcb->group_pid);
+            }
             puts("\n    Files: ");
             int fd;
             for(fd = 0; fd < MAX_NUM_FD_ENTRY; fd++) {
@@ -222,15 +434,99 @@ int32_t syscall_poke(uint32_t x, uint32_t y, uint32_t data) {
 
     // printf("%d %d %x\n", x, y, data);
 
+    // Don't let history on screen be copied back over the poked cell later
+    scrollback_reset(active_terminal_id);
     *(uint8_t *)(video_mem + ((NUM_COLS * y + x) << 1)) = ch;
     *(uint8_t *)(video_mem + ((NUM_COLS * y + x) << 1) + 1) = attrib;
 
-    qemu_vga_putc(x * FONT_ACTUAL_WIDTH, y * FONT_ACTUAL_HEIGHT,
-        ch, qemu_vga_get_terminal_color(attrib), qemu_vga_get_terminal_color(attrib >> 4));
+    qemu_vga_putc_attr(x * FONT_ACTUAL_WIDTH, y * FONT_ACTUAL_HEIGHT,
+        ch, attrib);
 
     return SUCCESS;
 }
 
+/* int32_t syscall_poke_batch(const poke_t* pokes, uint32_t count)
+ * @input: pokes - array of cell updates, each in the format of syscall_poke
+ *         count - number of entries in the array
+ * @output: ret val - number of cells changed, or FAIL on a bad buffer
+ * @description: applies many pokes in one kernel entry. All cells are written
+ *     into the text buffer first, then every touched cell is rendered in a
+ *     single pass in screen order, so a cell poked twice is drawn once.
+ *     Entries outside the screen are skipped.
+ */
+int32_t syscall_poke_batch(const poke_t* pokes, uint32_t count) {
+    if(count > USER_PAGE_SIZE / sizeof(poke_t)) return FAIL;
+    if(bad_userspace_addr(pokes, count * sizeof(poke_t))) return FAIL;
+
+    // A bit per cell, so it fits on the kernel stack
+    uint32_t dirty[SCREEN_HEIGHT][POKE_DIRTY_WORDS];
+    int32_t changed = 0;
+    uint32_t i;
+    int x, y;
+    memset(dirty, 0, sizeof(dirty));
+
+    scrollback_reset(active_terminal_id);
+    for(i = 0; i < count; i++) {
+        if(pokes[i].x >= SCREEN_WIDTH || pokes[i].y >= SCREEN_HEIGHT) continue;
+        *(uint16_t *)(video_mem + ((NUM_COLS * pokes[i].y + pokes[i].x) << 1)) = pokes[i].data;
+        dirty[pokes[i].y][pokes[i].x / POKE_DIRTY_BITS] |= 1 << (pokes[i].x % POKE_DIRTY_BITS);
+        changed++;
+    }
+
+    // Render each run of dirty cells on a row with one call
+    for(y = 0; y < SCREEN_HEIGHT; y++) {
+        for(x = 0; x < SCREEN_WIDTH; x++) {
+            if(!POKE_DIRTY(dirty, x, y)) continue;
+            int start = x;
+            while(x < SCREEN_WIDTH && POKE_DIRTY(dirty, x, y)) x++;
+            qemu_vga_draw_cells(start, y, x - start);
+        }
+    }
+    return changed;
+}
+
+/* int32_t syscall_blit(const uint16_t* cells, uint32_t pos, uint32_t size)
+ * @input: cells - row major block of cells, each in the format of syscall_poke
+ *         pos - bit 0 - 15: x of top left corner, bit 16 - 31: y
+ *         size - bit 0 - 15: width of the block, bit 16 - 31: height
+ * @output: the rectangle on screen replaced with the block
+ * @description: copies a rectangular cell block onto the screen in one
+ *     kernel entry, rendering it row by row. Parts falling off the screen
+ *     are clipped.
+ */
+int32_t syscall_blit(const uint16_t* cells, uint32_t pos, uint32_t size) {
+    uint32_t x = pos & 0xffff;
+    uint32_t y = pos >> 16;
+    uint32_t width = size & 0xffff;
+    uint32_t height = size >> 16;
+    uint32_t i;
+
+    if(x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return FAIL;
+    if(width * height > USER_PAGE_SIZE / sizeof(uint16_t)) return FAIL;
+    if(bad_userspace_addr(cells, width * height * sizeof(uint16_t))) return FAIL;
+
+    uint32_t copy_width = (x + width > SCREEN_WIDTH) ? SCREEN_WIDTH - x : width;
+    uint32_t copy_height = (y + height > SCREEN_HEIGHT) ? SCREEN_HEIGHT - y : height;
+    scrollback_reset(active_terminal_id);
+    for(i = 0; i < copy_height; i++) {
+        memcpy(video_mem + ((NUM_COLS * (y + i) + x) << 1), cells + i * width,
+            copy_width * sizeof(uint16_t));
+        qemu_vga_draw_cells(x, y + i, copy_width);
+    }
+    return SUCCESS;
+}
+
+/* int32_t syscall_set_mode(uint32_t xres, uint32_t yres, uint32_t bpp)
+ * @input: xres, yres - resolution, at least 720x480
+ *         bpp - color depth, 8 (palette), 16 or 32
+ * @output: ret val - SUCCESS / FAIL
+ * @description: changes QEMU VGA display mode for all terminals.
+ */
+int32_t syscall_set_mode(uint32_t xres, uint32_t yres, uint32_t bpp) {
+    if(xres > 0xffff || yres > 0xffff || bpp > 0xffff) return FAIL;
+    return qemu_vga_set_mode(xres, yres, bpp);
+}
+
 /* int32_t syscall_status_msg(char* msg, uint32_t len, uint8_t attr)
  * @input: msg, len - data and length of message for status bar
  * @output: attr - attribute
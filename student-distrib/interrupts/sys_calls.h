@@ -2,10 +2,31 @@
 #define _SYS_CALL_H
 
 #include "../lib/lib.h"
+#include "../fs/ece391fs.h"
+#include "../devices/pit.h"
+#include "../devices/clock.h"
 
 // 128 MB + 4 MB + 0xB8000 (VIDEO)
 #define USER_VIDEO              (33 * 0x400000 + 0xb8000)
 
+// Longest command run in background, program name and argument
+#define SPAWN_COMMAND_LEN (ECE391FS_MAX_FILENAME_LEN + 1 + MAX_ARG_LENGTH)
+
+// Longest nanosleep, so the deadline doesn't wrap around pit_timer
+#define NANOSLEEP_MAX_SEC (0x7fffffff / PIT_FREQ - 1)
+
+// Cell update for syscall_poke_batch, same data format as syscall_poke
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint16_t data;      // bit 0 - 7: character, bit 8 - 15: attribute
+} poke_t;
+
+// Cells touched by a poke batch are tracked with one bit each, per row
+#define POKE_DIRTY_BITS 32
+#define POKE_DIRTY_WORDS ((SCREEN_WIDTH + POKE_DIRTY_BITS - 1) / POKE_DIRTY_BITS)
+#define POKE_DIRTY(dirty, x, y) ((dirty)[y][(x) / POKE_DIRTY_BITS] & (1 << ((x) % POKE_DIRTY_BITS)))
+
 // System calls for checkpoint 3.
 int32_t syscall_halt (uint8_t status);
 int32_t syscall_execute (const uint8_t* command);
@@ -27,5 +48,21 @@ int32_t syscall_reboot(void);
 int32_t syscall_ps(void);
 int32_t syscall_poke(uint32_t x, uint32_t y, uint32_t data);
 int32_t syscall_status_msg(char* msg, uint32_t len, uint8_t attr);
+int32_t syscall_poke_batch(const poke_t* pokes, uint32_t count);
+int32_t syscall_blit(const uint16_t* cells, uint32_t pos, uint32_t size);
+int32_t syscall_set_mode(uint32_t xres, uint32_t yres, uint32_t bpp);
+int32_t syscall_spawn(const uint8_t* command);
+int32_t syscall_clone(void* entry, void* stack, void* arg);
+int32_t syscall_sleep(uint32_t ms);
+int32_t syscall_nanosleep(uint32_t sec, uint32_t nsec);
+int32_t syscall_clock_gettime(uint32_t clock_id, timespec_t* ts);
+int32_t syscall_alarm(uint32_t ms);
+int32_t syscall_pipe(int32_t* fds);
+int32_t syscall_dup2(int32_t fd, int32_t new_fd);
+int32_t syscall_shm_create(uint32_t key, uint32_t size);
+int32_t syscall_shm_attach(int32_t id);
+int32_t syscall_shm_detach(int32_t id);
+int32_t syscall_futex_wait(uint32_t* addr, uint32_t val);
+int32_t syscall_futex_wake(uint32_t* addr, uint32_t count);
 
 #endif
@@ -21,8 +21,10 @@
 #include "devices/pit.h"
 #include "devices/qemu_vga.h"
 #include "devices/cmos.h"
+#include "devices/clock.h"
 #include "devices/rng.h"
 #include "devices/mouse.h"
+#include "devices/vga_font.h"
 
 #include "data/uiuc.h"
 #include "data/vga_fonts.h"
@@ -46,6 +48,10 @@ void entry(unsigned long magic, unsigned long addr) {
 
     multiboot_info_t *mbi;
 
+    // Boot time is counted from here, before the PIT runs
+    cpuid_init();       // No need of querying every time
+    clock_mark_boot();
+
     // Init the PIC
     i8259_init();
 
@@ -170,7 +176,7 @@ void entry(unsigned long magic, unsigned long addr) {
      * PIC, any other initialization stuff... */
     // All other devices are auto initialized when used
     acpi_init();        // Find the ACPI tables, so we can leave space for them when paging
-    cpuid_init();       // No need of querying every time
+    clock_init();       // Measures TSC with PIT, needs CPUID and ACPI for CMOS century
     keyboard_init();    // Required for user input
     mouse_init();       // Mouse support
     pci_init();         // Required for QEMU VGA
@@ -180,8 +186,12 @@ void entry(unsigned long magic, unsigned long addr) {
     qemu_vga_init(QEMU_VGA_DEFAULT_WIDTH, QEMU_VGA_DEFAULT_HEIGHT, QEMU_VGA_DEFAULT_BPP);
 
     init_paging();
+    vga_font_init();    // Text mode only, font in VGA memory is mapped by paging
     process_init();     // Initialize multiprocessing structures
     rtc_init();         // Initialize RTC virtualization
+    // Splash image decompressed once here, instead of as each terminal starts
+    qemu_vga_preload_picture_lzss(UIUC_IMAGE_WIDTH, UIUC_IMAGE_HEIGHT, 16,
+        UIUC_IMAGE_LZSS, UIUC_IMAGE_LZSS_SIZE);
 
     // Show build info on status bar
     char build_ver[] = "nullOS by Team NULL, build " __DATE__ " " __TIME__;
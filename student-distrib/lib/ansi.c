@@ -0,0 +1,262 @@
+#include "ansi.h"
+#include "../interrupts/multiprocessing.h"
+#include "scrollback.h"
+
+// SGR color number to VGA color number
+static const uint8_t ansi_colors[ANSI_COLOR_COUNT] = {
+    0x0,    // Black
+    0x4,    // Red
+    0x2,    // Green
+    0x6,    // Yellow (brown)
+    0x1,    // Blue
+    0x5,    // Magenta
+    0x3,    // Cyan
+    0x7     // White (light gray)
+};
+
+/* void ansi_reset()
+ * @output: colors, scroll region and escape sequence state of
+ *     active terminal set back to default
+ * @description: used when a process halts, so it doesn't leave
+ *     its settings behind for the shell.
+ */
+void ansi_reset() {
+    volatile terminal_t* t = &terminals[active_terminal_id];
+    t->attrib = ATTRIB;
+    t->scroll_top = 0;
+    t->scroll_bottom = NUM_ROWS - 1;
+    t->ansi_state.state = ANSI_STATE_NORMAL;
+    t->ansi_state.saved_x = 0;
+    t->ansi_state.saved_y = 0;
+}
+
+/* uint16_t ansi_param(int idx, uint16_t def)
+ * @input: idx - index of parameter
+ *         def - value to use if parameter is missing or 0
+ * @output: ret val - value of parameter
+ */
+static uint16_t ansi_param(int idx, uint16_t def) {
+    volatile ansi_state_t* s = &terminals[active_terminal_id].ansi_state;
+    if(idx >= s->param_count || 0 == s->params[idx]) return def;
+    return s->params[idx];
+}
+
+/* void ansi_move_cursor(int32_t x, int32_t y)
+ * @input: x, y - new cursor position, clamped to screen
+ * @output: cursor of active terminal moved
+ */
+static void ansi_move_cursor(int32_t x, int32_t y) {
+    volatile terminal_t* t = &terminals[active_terminal_id];
+    if(x < 0) x = 0;
+    if(x >= NUM_COLS) x = NUM_COLS - 1;
+    if(y < 0) y = 0;
+    if(y >= NUM_ROWS) y = NUM_ROWS - 1;
+    t->screen_x = x;
+    t->screen_y = y;
+    vga_text_set_cursor_pos(x, y);
+    qemu_vga_set_cursor_pos(x, y);
+}
+
+/* void ansi_erase(int32_t row, int32_t from, int32_t to)
+ * @input: row - row to erase on
+ *         from, to - erase cells [from, to) of that row
+ * @output: cells filled with spaces of current background color
+ */
+static void ansi_erase(int32_t row, int32_t from, int32_t to) {
+    uint8_t attrib = terminals[active_terminal_id].attrib;
+    int32_t i;
+    if(from >= to) return;
+    for(i = from; i < to; i++) {
+        *(uint8_t *)(video_mem + ((NUM_COLS * row + i) << 1)) = ' ';
+        *(uint8_t *)(video_mem + ((NUM_COLS * row + i) << 1) + 1) = attrib;
+    }
+    memset(qemu_vga_wide_row(active_terminal_id, row) + from, 0, (to - from) * sizeof(uint16_t));
+    qemu_vga_draw_cells(from, row, to - from);
+}
+
+/* void ansi_sgr()
+ * @output: color of active terminal changed, by parameters of ESC [ ... m
+ * @description: supports reset, bold as bright colors,
+ *     normal and bright foreground / background colors.
+ */
+static void ansi_sgr() {
+    volatile terminal_t* t = &terminals[active_terminal_id];
+    int i;
+    // ESC [ m is the same as ESC [ 0 m
+    int count = t->ansi_state.param_count ? t->ansi_state.param_count : 1;
+    for(i = 0; i < count; i++) {
+        uint16_t p = t->ansi_state.params[i];
+        if(0 == p) {
+            t->attrib = ATTRIB;
+        } else if(1 == p) {
+            t->attrib |= ANSI_BRIGHT;
+        } else if(22 == p) {
+            t->attrib &= ~ANSI_BRIGHT;
+        } else if(p >= 30 && p < 30 + ANSI_COLOR_COUNT) {
+            t->attrib = (t->attrib & 0xf8) | ansi_colors[p - 30];
+        } else if(39 == p) {
+            t->attrib = (t->attrib & 0xf0) | (ATTRIB & 0x0f);
+        } else if(p >= 40 && p < 40 + ANSI_COLOR_COUNT) {
+            t->attrib = (t->attrib & 0x0f) | (ansi_colors[p - 40] << 4);
+        } else if(49 == p) {
+            t->attrib = (t->attrib & 0x0f) | (ATTRIB & 0xf0);
+        } else if(p >= 90 && p < 90 + ANSI_COLOR_COUNT) {
+            t->attrib = (t->attrib & 0xf0) | ansi_colors[p - 90] | ANSI_BRIGHT;
+        } else if(p >= 100 && p < 100 + ANSI_COLOR_COUNT) {
+            t->attrib = (t->attrib & 0x0f) | ((ansi_colors[p - 100] | ANSI_BRIGHT) << 4);
+        }
+    }
+}
+
+/* void ansi_csi(uint8_t cmd)
+ * @input: cmd - final character of a CSI sequence
+ * @output: the command is carried out on active terminal
+ * @description: supports cursor movement (A B C D G H d f s u),
+ *     erasing (J K), colors (m) and scroll region (r).
+ *     Anything else, including private modes, is ignored.
+ */
+static void ansi_csi(uint8_t cmd) {
+    volatile terminal_t* t = &terminals[active_terminal_id];
+    int32_t x = t->screen_x;
+    int32_t y = t->screen_y;
+    int32_t i;
+    if(t->ansi_state.private_mode) return;
+
+    // Erasing and cursor moves act on live screen, not history shown over it
+    scrollback_reset(active_terminal_id);
+    switch(cmd) {
+        case 'A':
+            ansi_move_cursor(x, y - ansi_param(0, 1));
+            break;
+        case 'B':
+            ansi_move_cursor(x, y + ansi_param(0, 1));
+            break;
+        case 'C':
+            ansi_move_cursor(x + ansi_param(0, 1), y);
+            break;
+        case 'D':
+            ansi_move_cursor(x - ansi_param(0, 1), y);
+            break;
+        case 'G':
+            ansi_move_cursor(ansi_param(0, 1) - 1, y);
+            break;
+        case 'd':
+            ansi_move_cursor(x, ansi_param(0, 1) - 1);
+            break;
+        case 'H':
+        case 'f':
+            ansi_move_cursor(ansi_param(1, 1) - 1, ansi_param(0, 1) - 1);
+            break;
+        case 'J':
+            switch(ansi_param(0, 0)) {
+                case 0:     // Cursor to end of screen
+                    ansi_erase(y, x, NUM_COLS);
+                    for(i = y + 1; i < NUM_ROWS; i++) ansi_erase(i, 0, NUM_COLS);
+                    break;
+                case 1:     // Start of screen to cursor
+                    for(i = 0; i < y; i++) ansi_erase(i, 0, NUM_COLS);
+                    ansi_erase(y, 0, x + 1);
+                    break;
+                case 2:     // Whole screen
+                    for(i = 0; i < NUM_ROWS; i++) ansi_erase(i, 0, NUM_COLS);
+                    break;
+            }
+            break;
+        case 'K':
+            switch(ansi_param(0, 0)) {
+                case 0:     // Cursor to end of line
+                    ansi_erase(y, x, NUM_COLS);
+                    break;
+                case 1:     // Start of line to cursor
+                    ansi_erase(y, 0, x + 1);
+                    break;
+                case 2:     // Whole line
+                    ansi_erase(y, 0, NUM_COLS);
+                    break;
+            }
+            break;
+        case 'm':
+            ansi_sgr();
+            break;
+        case 'r': {
+            int32_t top = ansi_param(0, 1) - 1;
+            int32_t bottom = ansi_param(1, NUM_ROWS) - 1;
+            if(bottom >= NUM_ROWS) bottom = NUM_ROWS - 1;
+            if(top >= bottom) break;
+            t->scroll_top = top;
+            t->scroll_bottom = bottom;
+            ansi_move_cursor(0, 0);
+            break;
+        }
+        case 's':
+            t->ansi_state.saved_x = x;
+            t->ansi_state.saved_y = y;
+            break;
+        case 'u':
+            ansi_move_cursor(t->ansi_state.saved_x, t->ansi_state.saved_y);
+            break;
+    }
+}
+
+/* void ansi_putc(uint8_t c)
+ * @input: c - character to print
+ * @output: character printed onto active terminal, or consumed
+ *     as part of an escape sequence
+ * @description: putc with support of ANSI / VT100 escape sequences,
+ *     used for output of user programs. State is kept in terminal_t,
+ *     so a sequence can be split between writes.
+ */
+void ansi_putc(uint8_t c) {
+    volatile ansi_state_t* s = &terminals[active_terminal_id].ansi_state;
+    switch(s->state) {
+        case ANSI_STATE_NORMAL:
+            if(ANSI_ESC == c) {
+                s->state = ANSI_STATE_ESCAPE;
+            } else {
+                putc(c);
+            }
+            break;
+        case ANSI_STATE_ESCAPE:
+            if(ANSI_CSI == c) {
+                s->state = ANSI_STATE_CSI;
+                s->private_mode = 0;
+                s->param_count = 0;
+                memset((void*) s->params, 0, sizeof(s->params));
+            } else {
+                // ESC c resets terminal, other escapes are not supported
+                s->state = ANSI_STATE_NORMAL;
+                if('c' == c) {
+                    ansi_reset();
+                    clear();
+                }
+            }
+            break;
+        case ANSI_STATE_CSI:
+            if(c >= '0' && c <= '9') {
+                if(0 == s->param_count) s->param_count = 1;
+                if(s->param_count <= ANSI_MAX_PARAMS) {
+                    uint16_t* p = (uint16_t*) &s->params[s->param_count - 1];
+                    *p = *p * 10 + (c - '0');
+                    if(*p > ANSI_MAX_PARAM_VALUE) *p = ANSI_MAX_PARAM_VALUE;
+                }
+            } else if(ANSI_SEPARATOR == c) {
+                // A leading separator means the first parameter is missing
+                if(0 == s->param_count) s->param_count = 1;
+                if(s->param_count <= ANSI_MAX_PARAMS) s->param_count++;
+            } else if(ANSI_PRIVATE == c) {
+                s->private_mode = 1;
+            } else if(c >= '@' && c <= '~') {
+                // Final character, run the command
+                s->state = ANSI_STATE_NORMAL;
+                if(s->param_count > ANSI_MAX_PARAMS) s->param_count = ANSI_MAX_PARAMS;
+                ansi_csi(c);
+            } else if(ANSI_ESC == c) {
+                // Broken sequence, start over
+                s->state = ANSI_STATE_ESCAPE;
+            }
+            break;
+        default:
+            s->state = ANSI_STATE_NORMAL;
+            break;
+    }
+}
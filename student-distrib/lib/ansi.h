@@ -0,0 +1,34 @@
+#ifndef _ANSI_H_
+#define _ANSI_H_
+
+#include "lib.h"
+
+#define ANSI_ESC 0x1b
+#define ANSI_CSI '['
+#define ANSI_PRIVATE '?'
+#define ANSI_SEPARATOR ';'
+#define ANSI_MAX_PARAMS 8
+// Large enough for any row / column, small enough for uint16_t
+#define ANSI_MAX_PARAM_VALUE 9999
+
+#define ANSI_STATE_NORMAL 0
+#define ANSI_STATE_ESCAPE 1     // Got ESC
+#define ANSI_STATE_CSI 2        // Got ESC [, reading parameters
+
+// Color order of SGR 30-37, in VGA color numbers
+#define ANSI_COLOR_COUNT 8
+#define ANSI_BRIGHT 0x8
+
+typedef struct {
+    uint8_t state;                      // ANSI_STATE_*
+    uint8_t private_mode;               // Whether sequence started with ESC [ ?
+    uint8_t param_count;                // Parameters got, including the one being read
+    uint16_t params[ANSI_MAX_PARAMS];   // Missing parameters are 0
+    int8_t saved_x;                     // Cursor saved by ESC [ s
+    int8_t saved_y;
+} ansi_state_t;
+
+void ansi_reset();
+void ansi_putc(uint8_t c);
+
+#endif
@@ -125,15 +125,9 @@ void chinese_input_draw_utf8_char(uint16_t x, uint16_t y, uint16_t code, uint8_t
     encode[1] = 0x80 | ((code >> 6) & 0x3f);
     encode[2] = 0x80 | (code & 0x3f);
     // Transfer 3 bytes one by one
-    qemu_vga_putc(x, y, encode[0],
-        qemu_vga_get_terminal_color(attr),
-        qemu_vga_get_terminal_color(attr >> 4));
-    qemu_vga_putc(x, y, encode[1],
-        qemu_vga_get_terminal_color(attr),
-        qemu_vga_get_terminal_color(attr >> 4));
-    qemu_vga_putc(x, y, encode[2],
-        qemu_vga_get_terminal_color(attr),
-        qemu_vga_get_terminal_color(attr >> 4));
+    qemu_vga_putc_attr(x, y, encode[0], attr);
+    qemu_vga_putc_attr(x, y, encode[1], attr);
+    qemu_vga_putc_attr(x, y, encode[2], attr);
 }
 
 /* void chinese_input_draw()
@@ -146,26 +140,23 @@ void chinese_input_draw() {
     int i;
     // Draw　user input section
     for(i = 0; i < CHINESE_INPUT_BUF_LEN; i++) {
-        qemu_vga_putc(i * FONT_ACTUAL_WIDTH,
+        qemu_vga_putc_attr(i * FONT_ACTUAL_WIDTH,
             CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
             (i < b->buf_len) ? b->buf[i] : ' ',
-            qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_BUF),
-            qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_BUF >> 4));
+            CHINESE_INPUT_ATTR_BUF);
     }
     // Draw candidate section
     for(i = 0; i < CHINESE_INPUT_CANDIDATES; i++) {
         int x = CHINESE_INPUT_BUF_LEN + CHINESE_INPUT_CANDIDATE_WIDTH * i;
         if(b->page * CHINESE_INPUT_CANDIDATES + i < b->len) {
-            qemu_vga_putc(x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(x * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 '1' + i,
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
-            qemu_vga_putc((x + 1) * FONT_ACTUAL_WIDTH,
+                CHINESE_INPUT_ATTR_CANDIDATE);
+            qemu_vga_putc_attr((x + 1) * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 '.',
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
+                CHINESE_INPUT_ATTR_CANDIDATE);
             // There is a candidate character here
             chinese_input_draw_utf8_char((x + 2) * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
@@ -173,26 +164,22 @@ void chinese_input_draw() {
                 CHINESE_INPUT_ATTR_CANDIDATE);
         } else {
             // No candidate here, clear the position with 4 spaces
-            qemu_vga_putc(x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(x * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 ' ',
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
-            qemu_vga_putc((x + 1) * FONT_ACTUAL_WIDTH,
+                CHINESE_INPUT_ATTR_CANDIDATE);
+            qemu_vga_putc_attr((x + 1) * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 ' ',
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
-            qemu_vga_putc((x + 2) * FONT_ACTUAL_WIDTH,
+                CHINESE_INPUT_ATTR_CANDIDATE);
+            qemu_vga_putc_attr((x + 2) * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 ' ',
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
-            qemu_vga_putc((x + 3) * FONT_ACTUAL_WIDTH,
+                CHINESE_INPUT_ATTR_CANDIDATE);
+            qemu_vga_putc_attr((x + 3) * FONT_ACTUAL_WIDTH,
                 CHINESE_INPUT_Y * FONT_ACTUAL_HEIGHT,
                 ' ',
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE),
-                qemu_vga_get_terminal_color(CHINESE_INPUT_ATTR_CANDIDATE >> 4));
+                CHINESE_INPUT_ATTR_CANDIDATE);
         }
     }
 }
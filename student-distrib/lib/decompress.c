@@ -0,0 +1,89 @@
+#include "decompress.h"
+
+/* void lzss_init(lzss_stream_t* s, const uint8_t* src, uint32_t src_len)
+ * @input: s - stream state to be initialized
+ *         src, src_len - LZSS compressed data
+ * @output: s ready for lzss_read
+ * @description: starts decoding a LZSS stream. The state holds the 4KB
+ *     history window, so don't put it on a kernel stack.
+ */
+void lzss_init(lzss_stream_t* s, const uint8_t* src, uint32_t src_len) {
+    s->src = src;
+    s->src_len = src_len;
+    s->src_pos = 0;
+    s->window_pos = 0;
+    s->flags = 0;
+    s->flags_left = 0;
+    s->match_dist = 0;
+    s->match_left = 0;
+}
+
+/* uint32_t lzss_read(lzss_stream_t* s, uint8_t* buf, uint32_t len)
+ * @input: s - stream state
+ *         buf, len - ptr and size of output buffer
+ * @output: buf - filled with decompressed data
+ *          ret val - bytes written, less than len only at end of stream
+ * @description: decompresses the next len bytes of a LZSS stream,
+ *     so large assets can be decoded piece by piece straight to their target.
+ */
+uint32_t lzss_read(lzss_stream_t* s, uint8_t* buf, uint32_t len) {
+    uint32_t done = 0;
+    while(done < len) {
+        uint8_t byte;
+        if(s->match_left > 0) {
+            // Continue copying a match from history
+            byte = s->window[(s->window_pos - s->match_dist) & (LZSS_WINDOW_SIZE - 1)];
+            s->match_left--;
+        } else {
+            if(s->flags_left == 0) {
+                if(s->src_pos >= s->src_len) break;
+                s->flags = s->src[s->src_pos++];
+                s->flags_left = LZSS_ITEMS_PER_FLAG;
+            }
+            if(s->src_pos >= s->src_len) break;
+            if(s->flags & 1) {
+                // Literal byte
+                byte = s->src[s->src_pos++];
+            } else {
+                // Match: 12 bit distance - 1, 4 bit length - 3
+                if(s->src_pos + 1 >= s->src_len) break;
+                uint8_t lo = s->src[s->src_pos++];
+                uint8_t hi = s->src[s->src_pos++];
+                s->match_dist = (lo | (hi >> 4) << 8) + 1;
+                s->match_left = (hi & 0xf) + LZSS_MIN_MATCH - 1;
+                byte = s->window[(s->window_pos - s->match_dist) & (LZSS_WINDOW_SIZE - 1)];
+            }
+            s->flags >>= 1;
+            s->flags_left--;
+        }
+        s->window[s->window_pos & (LZSS_WINDOW_SIZE - 1)] = byte;
+        s->window_pos++;
+        buf[done++] = byte;
+    }
+    return done;
+}
+
+/* int32_t huffman_decode(const huffman_t* h, bit_stream_t* bits)
+ * @input: h - canonical Huffman code
+ *         bits - stream to read from, MSB first
+ * @output: ret val - decoded symbol, or FAIL on an invalid code
+ * @description: decodes one symbol bit by bit, walking the code lengths
+ *     in order, as canonical codes of one length are consecutive.
+ */
+int32_t huffman_decode(const huffman_t* h, bit_stream_t* bits) {
+    int32_t code = 0;   // Bits read so far
+    int32_t first = 0;  // First code of current length
+    int32_t index = 0;  // Index of first code of current length in symbol table
+    int len;
+    for(len = 1; len <= HUFFMAN_MAX_LEN; len++) {
+        code |= (bits->src[bits->bit_pos >> 3] >> (7 - (bits->bit_pos & 7))) & 1;
+        bits->bit_pos++;
+        int32_t count = h->count[len];
+        if(code - count < first) return h->symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return FAIL;
+}
@@ -0,0 +1,40 @@
+#ifndef _DECOMPRESS_H_
+#define _DECOMPRESS_H_
+
+#include "lib.h"
+
+// LZSS stream format, see helpers/assetenc.c
+#define LZSS_WINDOW_SIZE 4096
+#define LZSS_MIN_MATCH 3
+#define LZSS_ITEMS_PER_FLAG 8
+
+// Canonical Huffman code, see helpers/assetenc.c
+#define HUFFMAN_MAX_LEN 16
+
+typedef struct {
+    const uint8_t* src;     // Compressed data
+    uint32_t src_len;       // Length of compressed data
+    uint32_t src_pos;       // Next byte to read from src
+    uint8_t window[LZSS_WINDOW_SIZE];   // Last 4KB of output
+    uint32_t window_pos;    // Total bytes output so far
+    uint8_t flags;          // Flag byte for current group of items
+    uint8_t flags_left;     // Items left in current group
+    uint16_t match_dist;    // Distance of match being copied
+    uint8_t match_left;     // Bytes left in match being copied
+} lzss_stream_t;
+
+typedef struct {
+    const uint16_t* count;  // Number of codes of each length, 0 to HUFFMAN_MAX_LEN
+    const uint8_t* symbol;  // Symbols ordered by code
+} huffman_t;
+
+typedef struct {
+    const uint8_t* src;     // Huffman coded data
+    uint32_t bit_pos;       // Next bit to read from src
+} bit_stream_t;
+
+void lzss_init(lzss_stream_t* s, const uint8_t* src, uint32_t src_len);
+uint32_t lzss_read(lzss_stream_t* s, uint8_t* buf, uint32_t len);
+int32_t huffman_decode(const huffman_t* h, bit_stream_t* bits);
+
+#endif
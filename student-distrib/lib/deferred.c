@@ -0,0 +1,55 @@
+#include "deferred.h"
+
+static deferred_work_t deferred_works[DEFERRED_QUEUE_SIZE];
+static volatile uint32_t deferred_head = 0;
+static volatile uint32_t deferred_tail = 0;
+
+// Whether deferred work is running, with interrupts enabled
+volatile uint8_t deferred_running = 0;
+// Work items lost because the queue was full
+volatile uint32_t deferred_dropped = 0;
+
+/* int32_t deferred_queue(deferred_func_t func, uint32_t arg)
+ * @input: func, arg - work to be done, func(arg) is called later
+ * @output: ret val - SUCCESS, or FAIL if the queue is full
+ * @description: called by interrupt handlers, so they only acknowledge
+ *     the device and leave the rest to deferred_run. Work runs in the order
+ *     it's queued.
+ */
+int32_t deferred_queue(deferred_func_t func, uint32_t arg) {
+    if(NULL == func) return FAIL;
+    uint32_t flags;
+    cli_and_save(flags);
+    if(deferred_tail - deferred_head >= DEFERRED_QUEUE_SIZE) {
+        deferred_dropped++;
+        restore_flags(flags);
+        return FAIL;
+    }
+    deferred_work_t* work = &deferred_works[deferred_tail % DEFERRED_QUEUE_SIZE];
+    work->func = func;
+    work->arg = arg;
+    deferred_tail++;
+    restore_flags(flags);
+    return SUCCESS;
+}
+
+/* void deferred_run()
+ * @output: all queued work done, including work queued meanwhile
+ * @description: called at the end of interrupt handlers, with interrupts off.
+ *     Work runs with interrupts enabled, so other handlers can queue more.
+ *     If deferred work is already running further up the stack, returns
+ *     right away and leaves new work to it. The scheduler doesn't switch
+ *     processes while deferred_running is set. Returns with interrupts off.
+ */
+void deferred_run() {
+    if(deferred_running) return;
+    deferred_running = 1;
+    while(deferred_head != deferred_tail) {
+        deferred_work_t work = deferred_works[deferred_head % DEFERRED_QUEUE_SIZE];
+        deferred_head++;
+        sti();
+        work.func(work.arg);
+        cli();
+    }
+    deferred_running = 0;
+}
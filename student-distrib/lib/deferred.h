@@ -0,0 +1,22 @@
+#ifndef _DEFERRED_H_
+#define _DEFERRED_H_
+
+#include "lib.h"
+
+// Work items waiting to run, more are dropped
+#define DEFERRED_QUEUE_SIZE 128
+
+typedef void (*deferred_func_t)(uint32_t arg);
+
+typedef struct {
+    deferred_func_t func;
+    uint32_t arg;
+} deferred_work_t;
+
+extern volatile uint8_t deferred_running;
+extern volatile uint32_t deferred_dropped;
+
+int32_t deferred_queue(deferred_func_t func, uint32_t arg);
+void deferred_run();
+
+#endif
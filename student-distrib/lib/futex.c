@@ -0,0 +1,113 @@
+#include "futex.h"
+#include "shm.h"
+#include "../interrupts/multiprocessing.h"
+
+static futex_waiter_t futex_waiters[PROCESS_COUNT];
+static futex_waiter_t* futex_table[FUTEX_HASH_SIZE];
+
+/* uint32_t futex_key(uint32_t* addr)
+ * @input: addr - a word in user memory of active process
+ * @output: ret val - physical address of the word, 0 if it isn't valid
+ * @description: threads of a process share the user page, processes share
+ *     shared memory frames, so the same word gets the same key for all of them.
+ */
+static uint32_t futex_key(uint32_t* addr) {
+    uint32_t vaddr = (uint32_t) addr;
+    if(vaddr & (sizeof(uint32_t) - 1)) return 0;
+    process_t* group = process_get_group_pcb();
+    if(NULL == group) return 0;
+    if(vaddr >= USER_SHM_BASE && vaddr < USER_SHM_BASE + SHM_SEGMENTS * SHM_SEGMENT_PAGES * SHM_PAGE_SIZE) {
+        uint32_t index = (vaddr >> TB_ADDR_OFFSET) & (NUM_PTE - 1);
+        if(!page_table_usermap[index].present) return 0;
+        return (page_table_usermap[index].PB_addr << TB_ADDR_OFFSET) + (vaddr & (SHM_PAGE_SIZE - 1));
+    }
+    // Shared memory passes bad_userspace_addr too, so it's checked first
+    if(!bad_userspace_addr(addr, sizeof(uint32_t))) {
+        return ((PROCESS_PYSC_BASE_ADDR + group->group_pid) << PD_ADDR_OFFSET) + (vaddr - USER_PAGE_BASE);
+    }
+    return 0;
+}
+
+/* uint32_t futex_hash(uint32_t key)
+ * @input: key - physical address of a word
+ * @output: ret val - bucket of futex_table it's queued in
+ */
+static uint32_t futex_hash(uint32_t key) {
+    return (key * FUTEX_HASH_MULTIPLIER) >> (32 - FUTEX_HASH_BITS);
+}
+
+/* void futex_unqueue(futex_waiter_t* waiter)
+ * @input: waiter - a queued waiter
+ * @output: waiter removed from its bucket
+ */
+static void futex_unqueue(futex_waiter_t* waiter) {
+    futex_waiter_t** link = &futex_table[futex_hash(waiter->key)];
+    while(NULL != *link && *link != waiter) link = &(*link)->next;
+    if(NULL != *link) *link = waiter->next;
+    waiter->queued = 0;
+}
+
+/* int32_t futex_wait(uint32_t* addr, uint32_t val)
+ * @input: addr - a word in user memory, in the user page or shared memory
+ *         val - value the caller saw in it
+ * @output: ret val - SUCCESS when woken up by futex_wake, FAIL if the word
+ *     no longer holds val, addr is invalid, or a signal is to be handled
+ * @description: checking the value and queueing happen with interrupts
+ *     off, so a wake between the caller's check and the wait isn't lost.
+ *     Waiters of a word are woken up in the order they came.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t futex_wait(uint32_t* addr, uint32_t val) {
+    uint32_t key = futex_key(addr);
+    if(0 == key || *addr != val) return FAIL;
+
+    futex_waiter_t* waiter = &futex_waiters[active_process_id];
+    waiter->key = key;
+    waiter->queued = 1;
+    waiter->next = NULL;
+    futex_waiter_t** link = &futex_table[futex_hash(key)];
+    while(NULL != *link) link = &(*link)->next;
+    *link = waiter;
+
+    process_wait(waiter);
+    // Still queued if woken up for a signal
+    if(waiter->queued) {
+        futex_unqueue(waiter);
+        return FAIL;
+    }
+    return SUCCESS;
+}
+
+/* int32_t futex_wake(uint32_t* addr, uint32_t count)
+ * @input: addr - a word in user memory, in the user page or shared memory
+ *         count - most waiters to wake up, FUTEX_WAKE_ALL for all of them
+ * @output: ret val - waiters woken up, FAIL if addr is invalid
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t futex_wake(uint32_t* addr, uint32_t count) {
+    uint32_t key = futex_key(addr);
+    if(0 == key) return FAIL;
+    uint32_t woken = 0;
+    futex_waiter_t** link = &futex_table[futex_hash(key)];
+    while(NULL != *link && woken < count) {
+        futex_waiter_t* waiter = *link;
+        if(waiter->key != key) {
+            link = &waiter->next;
+            continue;
+        }
+        *link = waiter->next;
+        waiter->queued = 0;
+        process_wake_all(waiter);
+        woken++;
+    }
+    return woken;
+}
+
+/* void futex_cancel(int32_t pid)
+ * @input: pid - a process or thread going away
+ * @output: removed from the wait table, if it's waiting
+ */
+void futex_cancel(int32_t pid) {
+    if(pid < 0 || pid >= PROCESS_COUNT) return;
+    if(futex_waiters[pid].queued) futex_unqueue(&futex_waiters[pid]);
+}
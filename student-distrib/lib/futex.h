@@ -0,0 +1,22 @@
+#ifndef _FUTEX_H_
+#define _FUTEX_H_
+
+#include "lib.h"
+
+#define FUTEX_HASH_BITS 4
+#define FUTEX_HASH_SIZE (1 << FUTEX_HASH_BITS)
+#define FUTEX_HASH_MULTIPLIER 2654435761U   // Knuth's multiplicative hash
+#define FUTEX_WAKE_ALL 0x7fffffff
+
+// A process waiting in futex_wait, one per process as it waits on one word at a time
+typedef struct futex_waiter {
+    uint32_t key;                   // Physical address of the word
+    uint8_t queued;
+    struct futex_waiter* next;      // In the same hash bucket
+} futex_waiter_t;
+
+int32_t futex_wait(uint32_t* addr, uint32_t val);
+int32_t futex_wake(uint32_t* addr, uint32_t count);
+void futex_cancel(int32_t pid);
+
+#endif
@@ -0,0 +1,104 @@
+#include "glyph_cache.h"
+#include "decompress.h"
+
+static glyph_cache_entry_t glyph_cache[GLYPH_CACHE_SIZE];
+static uint32_t glyph_cache_clock = 0;
+
+/* int32_t chinese_font_find(uint16_t code)
+ * @input: code - unicode of a Chinese character
+ * @output: ret val - index of its glyph in the compressed font,
+ *                    or FAIL if the font doesn't have it
+ * @description: binary search over runs of consecutive characters,
+ *     as the font only stores glyphs that exist and are used.
+ */
+int32_t chinese_font_find(uint16_t code) {
+    int32_t low = 0, high = CHINESE_FONT_RUN_COUNT - 1;
+    while(low <= high) {
+        int32_t mid = (low + high) / 2;
+        const font_run_t* run = &CHINESE_FONT_RUNS[mid];
+        if(code < run->code) {
+            high = mid - 1;
+        } else if(code >= run->code + run->count) {
+            low = mid + 1;
+        } else {
+            return run->glyph + (code - run->code);
+        }
+    }
+    return FAIL;
+}
+
+/* void chinese_font_decode(uint32_t index, uint16_t* rows)
+ * @input: index - index of glyph in the compressed font
+ *         rows - buffer of CHINESE_FONT_HEIGHT rows
+ * @output: rows - bitmap of the character, swapped into native byte order
+ * @description: decodes one glyph. Glyphs are Huffman coded with one code
+ *     for left bytes and one for right bytes, each byte XORed with the one
+ *     above, and the bit offset of every CHINESE_FONT_BLOCK'th glyph is
+ *     known, so at most a block is decoded.
+ */
+static void chinese_font_decode(uint32_t index, uint16_t* rows) {
+    huffman_t huffman[CHINESE_FONT_ROW_SIZE];
+    bit_stream_t bits;
+    uint8_t glyph[CHINESE_FONT_GLYPH_SIZE];
+    uint32_t skip = (index % CHINESE_FONT_BLOCK) * CHINESE_FONT_GLYPH_SIZE;
+    uint32_t i;
+
+    for(i = 0; i < CHINESE_FONT_ROW_SIZE; i++) {
+        huffman[i].count = CHINESE_FONT_HUFFMAN_COUNT[i];
+        huffman[i].symbol = CHINESE_FONT_HUFFMAN_SYMBOL[i];
+    }
+    bits.src = CHINESE_FONT_STREAM;
+    bits.bit_pos = CHINESE_FONT_BLOCK_OFFSET[index / CHINESE_FONT_BLOCK];
+
+    // Skip over earlier glyphs in the same block
+    for(i = 0; i < skip; i++) {
+        huffman_decode(&huffman[i % CHINESE_FONT_ROW_SIZE], &bits);
+    }
+    for(i = 0; i < CHINESE_FONT_GLYPH_SIZE; i++) {
+        glyph[i] = huffman_decode(&huffman[i % CHINESE_FONT_ROW_SIZE], &bits);
+        if(i >= CHINESE_FONT_ROW_SIZE) glyph[i] ^= glyph[i - CHINESE_FONT_ROW_SIZE];
+    }
+    for(i = 0; i < CHINESE_FONT_HEIGHT; i++) {
+        rows[i] = glyph[i * CHINESE_FONT_ROW_SIZE] << 8 | glyph[i * CHINESE_FONT_ROW_SIZE + 1];
+    }
+}
+
+/* int32_t glyph_cache_get(uint16_t code, uint16_t* rows)
+ * @input: code - unicode of a Chinese character
+ *         rows - buffer of CHINESE_FONT_HEIGHT rows
+ * @output: rows - bitmap of the character, MSB is leftmost pixel,
+ *                 all zero if the font doesn't have it
+ *          ret val - SUCCESS / FAIL
+ * @description: returns a glyph from the cache, decoding it and replacing
+ *     the least recently used entry on a miss. The bitmap is copied out
+ *     with interrupts off, so an interrupt drawing text can't evict it
+ *     halfway through.
+ */
+int32_t glyph_cache_get(uint16_t code, uint16_t* rows) {
+    uint32_t flags;
+    int i;
+    int32_t index = chinese_font_find(code);
+    if(FAIL == index) {
+        memset(rows, 0, CHINESE_FONT_GLYPH_SIZE);
+        return FAIL;
+    }
+
+    cli_and_save(flags);
+    glyph_cache_clock++;
+    glyph_cache_entry_t* victim = &glyph_cache[0];
+    for(i = 0; i < GLYPH_CACHE_SIZE; i++) {
+        if(glyph_cache[i].code == code) {
+            victim = &glyph_cache[i];
+            break;
+        }
+        if(glyph_cache[i].last_used < victim->last_used) victim = &glyph_cache[i];
+    }
+    if(victim->code != code) {
+        chinese_font_decode(index, victim->rows);
+        victim->code = code;
+    }
+    victim->last_used = glyph_cache_clock;
+    memcpy(rows, victim->rows, CHINESE_FONT_GLYPH_SIZE);
+    restore_flags(flags);
+    return SUCCESS;
+}
@@ -0,0 +1,20 @@
+#ifndef _GLYPH_CACHE_H_
+#define _GLYPH_CACHE_H_
+
+#include "lib.h"
+#include "../data/chinese_font.h"
+
+// Number of decoded Chinese glyphs kept in memory
+#define GLYPH_CACHE_SIZE 64
+#define GLYPH_CACHE_FREE 0
+
+typedef struct {
+    uint16_t code;                          // Unicode of glyph, GLYPH_CACHE_FREE if unused
+    uint32_t last_used;                     // Value of glyph_cache_clock on last hit
+    uint16_t rows[CHINESE_FONT_HEIGHT];     // Bitmap, native byte order, MSB is leftmost pixel
+} glyph_cache_entry_t;
+
+int32_t chinese_font_find(uint16_t code);
+int32_t glyph_cache_get(uint16_t code, uint16_t* rows);
+
+#endif
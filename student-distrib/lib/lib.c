@@ -5,6 +5,9 @@
 #include "../interrupts/multiprocessing.h"
 #include "../devices/vga_text.h"
 #include "../devices/qemu_vga.h"
+#include "../devices/vga_font.h"
+#include "scrollback.h"
+#include "shm.h"
 
 char* video_mem = (char *)VIDEO;
 uint8_t is_clied = 0;
@@ -31,6 +34,7 @@ void wait_interrupt() {
  * Function: Clears video memory */
 void clear(void) {
     int32_t i;
+    scrollback_reset(active_terminal_id);
     for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
         *(uint8_t *)(video_mem + (i << 1)) = ' ';
         *(uint8_t *)(video_mem + (i << 1) + 1) = ATTRIB;
@@ -195,12 +199,25 @@ int32_t puts(int8_t* s) {
     return index;
 }
 
+/* int32_t below_scroll_region()
+ * @output: ret val - whether cursor of active terminal just went
+ *     below its scroll region, or off the screen
+ */
+static int32_t below_scroll_region() {
+    return terminals[active_terminal_id].screen_y == terminals[active_terminal_id].scroll_bottom + 1
+        || terminals[active_terminal_id].screen_y >= NUM_ROWS;
+}
+
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
  * Function: Output a character to the console */
 void putc(uint8_t c)
 {
+    // Bring back live screen if history is shown
+    scrollback_reset(active_terminal_id);
+    uint8_t attrib = terminals[active_terminal_id].attrib;
+
     // if reach the right bottom of the screen
     if (NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x
         >= NUM_COLS * NUM_ROWS) roll_up();
@@ -212,19 +229,23 @@ void putc(uint8_t c)
     } else if(UTF8_3BYTE_MASK == (c & UTF8_3BYTE_MASK)) {
         // This is the beginning of a 3 byte UTF-8 code
         terminals[active_terminal_id].utf8_state.got = 3;
+        terminals[active_terminal_id].utf8_state.code = c & 0xf;
     } else if(UTF8_2BYTE_MASK == (c & UTF8_2BYTE_MASK)) {
         // This is the beginning of a 2 byte UTF-8 code
         terminals[active_terminal_id].utf8_state.got = 2;
+        terminals[active_terminal_id].utf8_state.code = c & 0x1f;
     } else if(terminals[active_terminal_id].utf8_state.got > 0) {
         // This is the 2nd or 3rd byte of a UTF-8 code
         // Decrease counter of expected length by 1
         terminals[active_terminal_id].utf8_state.got--;
+        terminals[active_terminal_id].utf8_state.code =
+            (terminals[active_terminal_id].utf8_state.code << 6) | (c & 0x3f);
     }
 
     // If input is a line feed
     if(c == '\n' || c == '\r') {
         terminals[active_terminal_id].screen_y++;
-        if (terminals[active_terminal_id].screen_y >= NUM_ROWS) roll_up();
+        if (below_scroll_region()) roll_up();
         clear_row(terminals[active_terminal_id].screen_y);    // Clear the new line for better display
         terminals[active_terminal_id].screen_x = 0;
     } else if(c == BACKSPACE) {
@@ -250,53 +271,57 @@ void putc(uint8_t c)
         }
         // Clear the current character
         *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1)) = ' ';
-        *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = ATTRIB;
-        qemu_vga_putc(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
+        *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = attrib;
+        qemu_vga_putc_attr(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
             terminals[active_terminal_id].screen_y * FONT_ACTUAL_HEIGHT,
-            ' ', qemu_vga_get_terminal_color(ATTRIB), qemu_vga_get_terminal_color(ATTRIB >> 4));
+            ' ', attrib);
     } else {
         if(terminals[active_terminal_id].utf8_state.got == 0) {
             // The input char has no relation to UTF-8, simply print it
             *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1)) = c;
-            *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = ATTRIB;
+            *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = attrib;
         } else if(terminals[active_terminal_id].utf8_state.got < 3) {
             // The input char is the second last char of UTF-8 code
             // As VGA text mode cannot display these characters,
             // Create a space for it, as each Chinese character is 2 letters wide.
             // With one space at got == 2 and one at got == 1, 2 spaces are made.
             *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1)) = ' ';
-            *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = ATTRIB;
+            *(uint8_t *)(video_mem + ((NUM_COLS * terminals[active_terminal_id].screen_y + terminals[active_terminal_id].screen_x) << 1) + 1) = attrib;
         }
 
         if(terminals[active_terminal_id].utf8_state.got == 0) {
             // Tell QEMU VGA to put a character at the same position
-            qemu_vga_putc(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
                 terminals[active_terminal_id].screen_y * FONT_ACTUAL_HEIGHT,
-                c, qemu_vga_get_terminal_color(ATTRIB), qemu_vga_get_terminal_color(ATTRIB >> 4));
+                c, attrib);
             terminals[active_terminal_id].screen_x++;
         } else if(terminals[active_terminal_id].utf8_state.got == 1) {
             // Last call to draw the character.
             // Tell QEMU VGA to put a character at one letter before,
             // in the 2 space for a Chinese character
             if(terminals[active_terminal_id].screen_x > 0) terminals[active_terminal_id].screen_x--;
-            qemu_vga_putc(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
                 terminals[active_terminal_id].screen_y * FONT_ACTUAL_HEIGHT,
-                c, qemu_vga_get_terminal_color(ATTRIB), qemu_vga_get_terminal_color(ATTRIB >> 4));
+                c, attrib);
+            // In VGA text mode, glyphs of the 2 spaces are replaced instead
+            vga_font_put_wide(terminals[active_terminal_id].screen_x,
+                terminals[active_terminal_id].screen_y,
+                terminals[active_terminal_id].utf8_state.code);
             // And then create space for it
             terminals[active_terminal_id].screen_x += 2;
         } else if(terminals[active_terminal_id].utf8_state.got == 2) {
             // Second last call to draw the character.
             // Create the first of the two space for the Chinese Character,
             // and inform QEMU VGA (it won't draw anything yet)
-            qemu_vga_putc(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
                 terminals[active_terminal_id].screen_y * FONT_ACTUAL_HEIGHT,
-                c, qemu_vga_get_terminal_color(ATTRIB), qemu_vga_get_terminal_color(ATTRIB >> 4));
+                c, attrib);
             terminals[active_terminal_id].screen_x++;
         } else {
             // First of the three calls to draw this character, simply inform QEMU VGA
-            qemu_vga_putc(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
+            qemu_vga_putc_attr(terminals[active_terminal_id].screen_x * FONT_ACTUAL_WIDTH,
                 terminals[active_terminal_id].screen_y * FONT_ACTUAL_HEIGHT,
-                c, qemu_vga_get_terminal_color(ATTRIB), qemu_vga_get_terminal_color(ATTRIB >> 4));
+                c, attrib);
         }
 
         // Handle finishing of one line and moving onto next line
@@ -304,7 +329,7 @@ void putc(uint8_t c)
             terminals[active_terminal_id].screen_x = 0;
             terminals[active_terminal_id].screen_y++;
             // if reach the right bottom of the screen
-            if (terminals[active_terminal_id].screen_y >= NUM_ROWS) roll_up();
+            if (below_scroll_region()) roll_up();
             clear_row(terminals[active_terminal_id].screen_y);    // Clear the new line for better display
         }
     }
@@ -317,14 +342,27 @@ void putc(uint8_t c)
 /* void roll_up();
  * Inputs: none
  * Return Value: void
- * Function:roll the page up one line */
+ * Function: roll the scroll region up one line, full screen by default.
+ *     If cursor is below the scroll region, it stays on the last line. */
 void roll_up() {
-    memcpy(video_mem, video_mem + (NUM_COLS << 1), (NUM_ROWS - 1) * NUM_COLS * 2);
-    terminals[active_terminal_id].screen_x = 0;
-    terminals[active_terminal_id].screen_y = NUM_ROWS - 1;
-    qemu_vga_roll_up();
-    qemu_vga_set_cursor_pos(0, NUM_ROWS - 1);
-    clear_row(NUM_ROWS - 1);
+    volatile terminal_t* t = &terminals[active_terminal_id];
+    int32_t top = t->scroll_top;
+    int32_t bottom = t->scroll_bottom;
+    t->screen_x = 0;
+    if(t->screen_y != bottom + 1) {
+        t->screen_y = NUM_ROWS - 1;
+        qemu_vga_set_cursor_pos(0, NUM_ROWS - 1);
+        return;
+    }
+
+    // Only lines leaving the whole screen go to history
+    if(0 == top && NUM_ROWS - 1 == bottom) scrollback_push();
+    memcpy(video_mem + ((top * NUM_COLS) << 1), video_mem + (((top + 1) * NUM_COLS) << 1),
+        (bottom - top) * NUM_COLS * 2);
+    t->screen_y = bottom;
+    qemu_vga_roll_up(top, bottom);
+    qemu_vga_set_cursor_pos(0, bottom);
+    clear_row(bottom);
 }
 
 /* int8_t* itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -610,3 +648,18 @@ int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
     }
     return dest;
 }
+
+/* int32_t bad_userspace_addr(const void* addr, int32_t len)
+ * Inputs: const void* addr = start of the userspace buffer
+ *              int32_t len = length of the buffer in bytes
+ * Return Value: 0 if the whole buffer lies in the user program page, or in
+ *              a shared memory segment attached to the process, 1 otherwise
+ * Function: check a buffer passed in by a system call before the kernel touches it */
+int32_t bad_userspace_addr(const void* addr, int32_t len) {
+    uint32_t start = (uint32_t) addr;
+    uint32_t page = USER_PROCESS_ADDR >> PD_ADDR_OFFSET;
+    if(NULL == addr || len < 0) return 1;
+    if(start >> PD_ADDR_OFFSET != page) return shm_bad_addr(addr, len);
+    if(len > 0 && (start + len - 1) >> PD_ADDR_OFFSET != page) return 1;
+    return 0;
+}
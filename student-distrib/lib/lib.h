@@ -46,6 +46,36 @@ int8_t* strncpy(int8_t* dest, const int8_t*src, uint32_t n);
 int32_t bad_userspace_addr(const void* addr, int32_t len);
 int32_t safe_strncpy(int8_t* dest, const int8_t* src, int32_t n);
 
+/* uint32_t rdtsc_low()
+ * Reads low 32 bits of the time stamp counter,
+ * enough for measuring short intervals. Check CPUID for TSC first. */
+static inline uint32_t rdtsc_low() {
+    uint32_t val;
+    asm volatile ("rdtsc" : "=a"(val) : : "edx");
+    return val;
+}
+
+/* uint64_t rdtsc()
+ * Reads the whole time stamp counter. Check CPUID for TSC first. */
+static inline uint64_t rdtsc() {
+    uint64_t val;
+    asm volatile ("rdtsc" : "=A"(val));
+    return val;
+}
+
+/* uint64_t div64_32(uint64_t n, uint32_t d, uint32_t* rem)
+ * Divides a 64 bit number, as libgcc isn't linked for the compiler's own
+ * 64 bit division. Remainder is stored into rem unless it's NULL. */
+static inline uint64_t div64_32(uint64_t n, uint32_t d, uint32_t* rem) {
+    uint32_t high = n >> 32;
+    uint32_t q_high = high / d;
+    uint32_t q_low, r;
+    high %= d;
+    asm ("divl %4" : "=a"(q_low), "=d"(r) : "a"((uint32_t) n), "d"(high), "rm"(d));
+    if(NULL != rem) *rem = r;
+    return ((uint64_t) q_high << 32) | q_low;
+}
+
 /* Port read functions */
 /* Inb reads a byte and returns its value as a zero-extended 32-bit
  * unsigned int */
@@ -0,0 +1,123 @@
+#include "scrollback.h"
+#include "../interrupts/multiprocessing.h"
+
+// History of each terminal
+static scrollback_t scrollbacks[TERMINAL_COUNT];
+// Live screen of displayed terminal, saved while history is shown over it
+static uint8_t scrollback_live[NUM_ROWS * NUM_COLS << 1];
+
+/* void scrollback_push()
+ * @output: top row of active terminal saved into its history
+ * @description: called by roll_up, right before the row is lost.
+ *     Oldest line is dropped once history is full.
+ */
+void scrollback_push() {
+    scrollback_t* sb = &scrollbacks[active_terminal_id];
+    scrollback_line_t* line = &sb->lines[sb->head];
+    memcpy(line->cells, video_mem, sizeof(line->cells));
+    memcpy(line->wide, qemu_vga_wide_row(active_terminal_id, 0), sizeof(line->wide));
+    sb->head = (sb->head + 1) % SCROLLBACK_LINES;
+    if(sb->count < SCROLLBACK_LINES) sb->count++;
+}
+
+/* void scrollback_draw_row(uint8_t row, const uint8_t* cells, const uint16_t* wide)
+ * @input: row - row on screen to draw on
+ *         cells - character / attribute pairs of that row
+ *         wide - Chinese characters of that row
+ * @output: row shown on displayed terminal, both VGA text mode and QEMU VGA
+ */
+static void scrollback_draw_row(uint8_t row, const uint8_t* cells, const uint16_t* wide) {
+    memcpy(video_mem + ((row * NUM_COLS) << 1), cells, NUM_COLS << 1);
+    qemu_vga_draw_text_row(row, cells, wide);
+}
+
+/* void scrollback_draw_view()
+ * @output: displayed terminal shows history at its current offset,
+ *     or live screen if offset is 0
+ * @description: history lines come from the ring buffer, the rest from
+ *     the saved live screen. Everything is drawn from RAM.
+ */
+static void scrollback_draw_view() {
+    scrollback_t* sb = &scrollbacks[displayed_terminal_id];
+    char* saved_video_mem = video_mem;
+    int32_t saved_tid = active_terminal_id;
+    video_mem = (char*) TERMINAL_DIRECT_ADDR;
+    active_terminal_id = displayed_terminal_id;
+
+    int row;
+    for(row = 0; row < NUM_ROWS; row++) {
+        // Line number counted from oldest line in history
+        uint32_t line = sb->count - sb->offset + row;
+        if(line < sb->count) {
+            scrollback_line_t* l = &sb->lines[(sb->head + SCROLLBACK_LINES - sb->count + line) % SCROLLBACK_LINES];
+            scrollback_draw_row(row, l->cells, l->wide);
+        } else {
+            line -= sb->count;
+            scrollback_draw_row(row, scrollback_live + ((line * NUM_COLS) << 1),
+                qemu_vga_wide_row(displayed_terminal_id, line));
+        }
+    }
+
+    video_mem = saved_video_mem;
+    active_terminal_id = saved_tid;
+}
+
+/* void scrollback_scroll(int32_t lines)
+ * @input: lines - lines to scroll back, negative to scroll forward
+ * @output: displayed terminal shows history, or live screen again
+ *     once scrolled to the bottom
+ */
+void scrollback_scroll(int32_t lines) {
+    scrollback_t* sb = &scrollbacks[displayed_terminal_id];
+    int32_t offset = sb->offset + lines;
+    if(offset < 0) offset = 0;
+    if(offset > (int32_t) sb->count) offset = sb->count;
+    if(offset == (int32_t) sb->offset) return;
+
+    if(0 == sb->offset) {
+        // Leaving live screen, save it before drawing over
+        memcpy(scrollback_live, (char*) TERMINAL_DIRECT_ADDR, sizeof(scrollback_live));
+    }
+    sb->offset = offset;
+    scrollback_draw_view();
+}
+
+/* void scrollback_reset(int32_t tid)
+ * @input: tid - terminal about to be written to
+ * @output: if history is shown on that terminal, live screen is restored
+ * @description: called before anything is printed, so output is never
+ *     mixed with history. Only the displayed terminal can show history.
+ */
+void scrollback_reset(int32_t tid) {
+    if(tid != displayed_terminal_id) return;
+    if(0 == scrollbacks[tid].offset) return;
+    scrollbacks[tid].offset = 0;
+    scrollback_draw_view();
+}
+
+/* void scrollback_find_chars(uint8_t first, uint8_t count, uint8_t* found)
+ * @input: first, count - range of character codes to look for
+ * @output: found - found[ch - first] set for codes in history of any terminal,
+ *     or in live screen saved while history is shown. Other entries are kept
+ * @description: used to tell if a character can come back on screen.
+ *     Must be called with interrupts off.
+ */
+void scrollback_find_chars(uint8_t first, uint8_t count, uint8_t* found) {
+    int32_t tid;
+    uint32_t i, j;
+    for(tid = 0; tid < TERMINAL_COUNT; tid++) {
+        scrollback_t* sb = &scrollbacks[tid];
+        for(i = 0; i < sb->count; i++) {
+            const uint8_t* cells = sb->lines[(sb->head + SCROLLBACK_LINES - sb->count + i) % SCROLLBACK_LINES].cells;
+            for(j = 0; j < NUM_COLS; j++) {
+                uint8_t ch = cells[j << 1] - first;
+                if(ch < count) found[ch] = 1;
+            }
+        }
+    }
+    if(0 == scrollbacks[displayed_terminal_id].offset) return;
+    for(j = 0; j < NUM_ROWS * NUM_COLS; j++) {
+        uint8_t ch = scrollback_live[j << 1] - first;
+        if(ch < count) found[ch] = 1;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef _SCROLLBACK_H_
+#define _SCROLLBACK_H_
+
+#include "lib.h"
+
+// Lines of history kept for each terminal.
+// Each line takes sizeof(scrollback_line_t), 320 bytes.
+#define SCROLLBACK_LINES 200
+// Lines moved by one Shift+PgUp / Shift+PgDn
+#define SCROLLBACK_PAGE (NUM_ROWS - 1)
+
+typedef struct {
+    uint8_t cells[NUM_COLS << 1];   // Character / attribute pairs, as in text mode buffer
+    uint16_t wide[NUM_COLS];        // Chinese characters at their left cell, 0 for none
+} scrollback_line_t;
+
+typedef struct {
+    scrollback_line_t lines[SCROLLBACK_LINES];  // Ring buffer of lines rolled off screen
+    uint32_t head;                              // Where the next line goes
+    uint32_t count;                             // Number of lines kept
+    uint32_t offset;                            // Lines scrolled back, 0 if showing live screen
+} scrollback_t;
+
+void scrollback_push();
+void scrollback_scroll(int32_t lines);
+void scrollback_reset(int32_t tid);
+void scrollback_find_chars(uint8_t first, uint8_t count, uint8_t* found);
+
+#endif
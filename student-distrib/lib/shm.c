@@ -0,0 +1,195 @@
+#include "shm.h"
+#include "../interrupts/multiprocessing.h"
+
+static shm_segment_t shm_segments[SHM_SEGMENTS];
+static uint8_t shm_frames[SHM_FRAMES][SHM_PAGE_SIZE] __attribute__((aligned(SHM_PAGE_SIZE)));
+// One reference for the segment holding the frame, one for each process mapping it
+static uint8_t shm_frame_refs[SHM_FRAMES];
+
+/* void shm_frame_put(uint8_t frame)
+ * @input: frame - index in shm_frames
+ * @output: a reference dropped, frame free again when none is left
+ */
+static void shm_frame_put(uint8_t frame) {
+    if(shm_frame_refs[frame] > 0) shm_frame_refs[frame]--;
+}
+
+/* void shm_segment_put(int32_t id)
+ * @input: id - a segment a process is detaching from
+ * @output: references of the process dropped, the segment and
+ *     its frames freed after the last process detaches
+ */
+static void shm_segment_put(int32_t id) {
+    shm_segment_t* segment = &shm_segments[id];
+    uint32_t i;
+    for(i = 0; i < segment->pages; i++) shm_frame_put(segment->frames[i]);
+    if(--segment->users > 0) return;
+    for(i = 0; i < segment->pages; i++) shm_frame_put(segment->frames[i]);
+    segment->used = 0;
+}
+
+/* int32_t shm_create(uint32_t key, uint32_t size)
+ * @input: key - chosen by programs sharing the segment
+ *         size - bytes needed, up to SHM_SEGMENT_PAGES pages
+ * @output: ret val - id of the segment, attached to active process,
+ *     FAIL if it can't be created
+ * @description: if a segment with the key exists, it's attached instead,
+ *     so the producer and consumer can start in any order. New segments
+ *     are filled with zeros.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t shm_create(uint32_t key, uint32_t size) {
+    if(0 == size || size > SHM_SEGMENT_PAGES * SHM_PAGE_SIZE) return FAIL;
+    if(NULL == process_get_group_pcb()) return FAIL;
+    uint32_t pages = (size + SHM_PAGE_SIZE - 1) / SHM_PAGE_SIZE;
+    int32_t id;
+    int32_t free_id = FAIL;
+    for(id = 0; id < SHM_SEGMENTS; id++) {
+        if(!shm_segments[id].used) {
+            if(FAIL == free_id) free_id = id;
+            continue;
+        }
+        if(shm_segments[id].key != key) continue;
+        if(pages > shm_segments[id].pages) return FAIL;
+        return FAIL == shm_attach(id) ? FAIL : id;
+    }
+    if(FAIL == free_id) return FAIL;
+
+    // Take free frames, the segment holds a reference to each
+    shm_segment_t* segment = &shm_segments[free_id];
+    uint32_t i = 0;
+    uint32_t frame;
+    for(frame = 0; frame < SHM_FRAMES && i < pages; frame++) {
+        if(0 == shm_frame_refs[frame]) segment->frames[i++] = frame;
+    }
+    if(i < pages) return FAIL;
+    for(i = 0; i < pages; i++) {
+        shm_frame_refs[segment->frames[i]] = 1;
+        memset(shm_frames[segment->frames[i]], 0, SHM_PAGE_SIZE);
+    }
+    for(; i < SHM_SEGMENT_PAGES; i++) segment->frames[i] = SHM_NO_FRAME;
+    segment->used = 1;
+    segment->key = key;
+    segment->pages = pages;
+    segment->users = 0;
+
+    if(FAIL == shm_attach(free_id)) {
+        for(i = 0; i < pages; i++) shm_frame_put(segment->frames[i]);
+        segment->used = 0;
+        return FAIL;
+    }
+    return free_id;
+}
+
+/* int32_t shm_attach(int32_t id)
+ * @input: id - a segment returned by shm_create
+ * @output: ret val - user address of the segment, the same in every
+ *     process, FAIL if there's no such segment
+ * @description: maps the segment's pages into active process, and its
+ *     threads. Attaching twice maps it once.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t shm_attach(int32_t id) {
+    process_t* process = process_get_group_pcb();
+    if(NULL == process) return FAIL;
+    if(id < 0 || id >= SHM_SEGMENTS || !shm_segments[id].used) return FAIL;
+    shm_segment_t* segment = &shm_segments[id];
+    if(!(process->shm_attached & (1 << id))) {
+        uint32_t i;
+        for(i = 0; i < segment->pages; i++) shm_frame_refs[segment->frames[i]]++;
+        segment->users++;
+        process->shm_attached |= 1 << id;
+        process_switch_paging(active_process_id);
+    }
+    return USER_SHM_BASE + id * SHM_SEGMENT_PAGES * SHM_PAGE_SIZE;
+}
+
+/* int32_t shm_detach(int32_t id)
+ * @input: id - a segment attached to active process
+ * @output: ret val - SUCCESS / FAIL
+ * @description: unmaps the segment, which goes away after the last
+ *     process detaches from it.
+ *   Must be wrapped in CLI/STI.
+ */
+int32_t shm_detach(int32_t id) {
+    process_t* process = process_get_group_pcb();
+    if(NULL == process) return FAIL;
+    if(id < 0 || id >= SHM_SEGMENTS || !(process->shm_attached & (1 << id))) return FAIL;
+    process->shm_attached &= ~(1 << id);
+    shm_segment_put(id);
+    process_switch_paging(active_process_id);
+    return SUCCESS;
+}
+
+/* void shm_detach_all(uint32_t* attached)
+ * @input: attached - shm_attached of a process that's halting
+ * @output: all its segments detached, attached cleared
+ * @description: paging isn't updated, as the process won't run again.
+ */
+void shm_detach_all(uint32_t* attached) {
+    int32_t id;
+    for(id = 0; id < SHM_SEGMENTS; id++) {
+        if(*attached & (1 << id)) shm_segment_put(id);
+    }
+    *attached = 0;
+}
+
+/* int32_t shm_bad_addr(const void* addr, int32_t len)
+ * @input: addr, len - a buffer passed in by a system call
+ * @output: ret val - 0 if the whole buffer lies in one segment attached
+ *     to active process, 1 otherwise
+ */
+int32_t shm_bad_addr(const void* addr, int32_t len) {
+    uint32_t start = (uint32_t) addr;
+    process_t* process = process_get_group_pcb();
+    if(NULL == process || len < 0 || start < USER_SHM_BASE) return 1;
+    uint32_t id = (start - USER_SHM_BASE) / (SHM_SEGMENT_PAGES * SHM_PAGE_SIZE);
+    if(id >= SHM_SEGMENTS || !(process->shm_attached & (1 << id))) return 1;
+    uint32_t end = USER_SHM_BASE + id * SHM_SEGMENT_PAGES * SHM_PAGE_SIZE + shm_segments[id].pages * SHM_PAGE_SIZE;
+    if(start >= end || (uint32_t) len > end - start) return 1;
+    return 0;
+}
+
+/* void shm_copy_in(uint32_t addr, const void* src, uint32_t len)
+ * @input: addr - user address in a segment, checked by shm_bad_addr
+ *             for the process it's attached to
+ *         src, len - data to be copied
+ * @output: data in the segment's frames
+ * @description: works whichever process is active, as frames are kernel
+ *     memory. Used to fill a buffer of a process waiting in another one.
+ */
+void shm_copy_in(uint32_t addr, const void* src, uint32_t len) {
+    uint32_t offset = addr - USER_SHM_BASE;
+    shm_segment_t* segment = &shm_segments[offset / (SHM_SEGMENT_PAGES * SHM_PAGE_SIZE)];
+    offset %= SHM_SEGMENT_PAGES * SHM_PAGE_SIZE;
+    while(len > 0) {
+        // Frames of a segment aren't next to each other, copy page by page
+        uint32_t count = SHM_PAGE_SIZE - offset % SHM_PAGE_SIZE;
+        if(count > len) count = len;
+        memcpy(shm_frames[segment->frames[offset / SHM_PAGE_SIZE]] + offset % SHM_PAGE_SIZE, src, count);
+        src = (const uint8_t*) src + count;
+        offset += count;
+        len -= count;
+    }
+}
+
+/* void shm_map(uint32_t attached)
+ * @input: attached - shm_attached of the process being switched to
+ * @output: page_table_usermap entries of segments set up for it
+ * @description: called by process_switch_paging, which flushes the TLB.
+ */
+void shm_map(uint32_t attached) {
+    int32_t id;
+    uint32_t i;
+    for(id = 0; id < SHM_SEGMENTS; id++) {
+        shm_segment_t* segment = &shm_segments[id];
+        uint8_t present = segment->used && (attached & (1 << id));
+        for(i = 0; i < SHM_SEGMENT_PAGES; i++) {
+            uint32_t index = SHM_PAGE_INDEX + id * SHM_SEGMENT_PAGES + i;
+            page_table_usermap[index].present = present && i < segment->pages;
+            if(page_table_usermap[index].present) {
+                page_table_usermap[index].PB_addr = (uint32_t) shm_frames[segment->frames[i]] >> TB_ADDR_OFFSET;
+            }
+        }
+    }
+}
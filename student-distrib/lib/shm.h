@@ -0,0 +1,34 @@
+#ifndef _SHM_H_
+#define _SHM_H_
+
+#include "lib.h"
+#include "../paging.h"
+
+#define SHM_PAGE_SIZE 4096
+#define SHM_SEGMENTS 8
+#define SHM_SEGMENT_PAGES 16        // Up to 64KB per segment
+#define SHM_FRAMES 64               // Pages of kernel memory handed out to segments
+#define SHM_NO_FRAME 0xff
+
+// Segments are mapped at the same address in every process, after the
+// time page in page_table_usermap, SHM_SEGMENT_PAGES pages apart
+#define SHM_PAGE_INDEX 0x100
+#define USER_SHM_BASE ((PAGE_TABLE_USERMAP_LOCATION << TB_ADDR_OFFSET_MB) + SHM_PAGE_INDEX * SHM_PAGE_SIZE)
+
+typedef struct {
+    uint8_t used;
+    uint32_t key;                           // Chosen by programs to find the segment
+    uint32_t pages;
+    uint32_t users;                         // Processes with it attached
+    uint8_t frames[SHM_SEGMENT_PAGES];      // Index in shm_frames of each page
+} shm_segment_t;
+
+int32_t shm_create(uint32_t key, uint32_t size);
+int32_t shm_attach(int32_t id);
+int32_t shm_detach(int32_t id);
+void shm_detach_all(uint32_t* attached);
+void shm_map(uint32_t attached);
+int32_t shm_bad_addr(const void* addr, int32_t len);
+void shm_copy_in(uint32_t addr, const void* src, uint32_t len);
+
+#endif
@@ -1,7 +1,10 @@
 #include "status_bar.h"
 #include "../devices/cmos.h"
+#include "../devices/pit.h"
+#include "../devices/clock.h"
 #include "../devices/qemu_vga.h"
 #include "../interrupts/multiprocessing.h"
+#include "deferred.h"
 
 /* void status_bar_switch_terminal(uint8_t tid)
  * @input: tid - new terminal
@@ -14,7 +17,30 @@ void status_bar_switch_terminal(uint8_t tid) {
     char s[] = "Switched to terminal #0";
     s[strlen(s) - 1] = '0' + tid;
     status_bar_update_message(s, strlen(s), ATTR_YELLOW_ON_BLACK);
-    status_bar_update_clock();
+    // Clock is drawn onto all terminals already
+}
+
+/* void status_bar_report_boot()
+ * @output: time taken to get the first shell prompt shown on status bar, once
+ * @description: called when a program first waits for keyboard input.
+ *     Counted by TSC from the start of kernel entry, including kernel init.
+ *     Without a TSC, PIT counts from when scheduling starts, and it's labeled so.
+ */
+void status_bar_report_boot() {
+    static uint8_t reported = 0;
+    if(reported) return;
+    reported = 1;
+    int32_t ms = clock_boot_ms();
+    char s[STATUS_BAR_X_MSG_END] = "First prompt after boot: ";
+    if(FAIL == ms) {
+        strcpy(s, "First prompt after scheduler start: ");
+        ms = pit_timer * MS_PER_TICK;
+    }
+    uint32_t len = strlen(s);
+    itoa(ms, s + len, 10);
+    len = strlen(s);
+    strcpy(s + len, " ms");
+    status_bar_update_message(s, strlen(s), ATTR_YELLOW_ON_BLACK);
 }
 
 /* void status_bar_update_message(char* msg, uint32_t len, uint8_t attr)
@@ -27,40 +53,79 @@ void status_bar_update_message(char* msg, uint32_t len, uint8_t attr) {
     if(NULL == msg) return;
     int i;
     for(i = 0; i < len && i < STATUS_BAR_X_MSG_END; i++) {
-        qemu_vga_putc((STATUS_BAR_X_MSG_START + i) * FONT_ACTUAL_WIDTH,
+        qemu_vga_putc_attr((STATUS_BAR_X_MSG_START + i) * FONT_ACTUAL_WIDTH,
             (STATUS_BAR_Y_END - 1) * FONT_ACTUAL_HEIGHT,
-            msg[i], qemu_vga_get_terminal_color(attr),
-            qemu_vga_get_terminal_color(attr >> 4));
+            msg[i], attr);
     }
     for(i = len; i < STATUS_BAR_X_MSG_END; i++) {
-        qemu_vga_putc((STATUS_BAR_X_MSG_START + i) * FONT_ACTUAL_WIDTH,
+        qemu_vga_putc_attr((STATUS_BAR_X_MSG_START + i) * FONT_ACTUAL_WIDTH,
             (STATUS_BAR_Y_END - 1) * FONT_ACTUAL_HEIGHT,
-            ' ', qemu_vga_get_terminal_color(attr),
-            qemu_vga_get_terminal_color(attr >> 4));
+            ' ', attr);
     }
 }
 
 /* void status_bar_update_clock()
  * @output: clock on right bottom corner of screen gets updated
- * @description: updates the clock with CMOS time
+ * @description: updates the clock with CMOS time. Changed digits are
+ *     rendered into an off-screen strip, then the changed part of the strip
+ *     is copied onto all terminals at once.
+ *     Reads CMOS, so don't call this from an interrupt handler;
+ *     use status_bar_request_clock instead.
  */
-char prev_time[STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START] = {0};
+char prev_time[STATUS_BAR_TIME_LEN] = {0};
+static uint8_t clock_strip[STATUS_BAR_TIME_LEN * FONT_ACTUAL_WIDTH
+    * FONT_ACTUAL_HEIGHT * STATUS_BAR_MAX_PIXEL_SIZE];
 void status_bar_update_clock() {
     if(!qemu_vga_enabled) return;
-    char time[STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START] = "0000-00-00 00:00:00 ";
+    char time[STATUS_BAR_TIME_LEN] = "0000-00-00 00:00:00 ";
     uint32_t i = 0;
-    cmos_read(NULL, &i, time, STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START);
-    time[STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START - 1] = ' ';
-    int active_tid = active_terminal_id;
-    for(i = 0; i < STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START; i++) {
+    cmos_read(NULL, &i, time, STATUS_BAR_TIME_LEN);
+    time[STATUS_BAR_TIME_LEN - 1] = ' ';
+
+    uint32_t char_size = FONT_ACTUAL_WIDTH * qemu_vga_ops->bytes_per_pixel;
+    uint32_t pitch = STATUS_BAR_TIME_LEN * char_size;
+    int32_t first = -1, last = -1;
+    for(i = 0; i < STATUS_BAR_TIME_LEN; i++) {
         if(time[i] == prev_time[i]) continue;
-        for(active_terminal_id = 0; active_terminal_id < TERMINAL_COUNT; active_terminal_id++) {
-            qemu_vga_putc((STATUS_BAR_X_TIME_START + i) * FONT_ACTUAL_WIDTH,
-                (STATUS_BAR_Y_END - 1) * FONT_ACTUAL_HEIGHT,
-                time[i], qemu_vga_get_terminal_color(ATTR_WHITE_ON_BLUE),
-                qemu_vga_get_terminal_color(ATTR_WHITE_ON_BLUE >> 4));
-        }
+        qemu_vga_render_char(clock_strip + i * char_size, pitch, time[i],
+            qemu_vga_attrs[ATTR_WHITE_ON_BLUE].fg, qemu_vga_attrs[ATTR_WHITE_ON_BLUE].bg);
+        if(first < 0) first = i;
+        last = i;
     }
-    active_terminal_id = active_tid;
-    memcpy(prev_time, time, STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START);
+    memcpy(prev_time, time, STATUS_BAR_TIME_LEN);
+    if(first < 0) return;
+
+    qemu_vga_blit_all_terminals(clock_strip + first * char_size, pitch,
+        (STATUS_BAR_X_TIME_START + first) * FONT_ACTUAL_WIDTH,
+        (STATUS_BAR_Y_END - 1) * FONT_ACTUAL_HEIGHT,
+        (last - first + 1) * FONT_ACTUAL_WIDTH, FONT_ACTUAL_HEIGHT);
+}
+
+/* void status_bar_redraw()
+ * @output: clock drawn again on all terminals
+ * @description: used after screen content is lost, like on a mode switch.
+ */
+void status_bar_redraw() {
+    memset(prev_time, 0, sizeof(prev_time));
+    status_bar_update_clock();
+}
+
+/* void status_bar_deferred_clock(uint32_t arg)
+ * @input: arg - ignored
+ * @output: clock updated, as requested by status_bar_request_clock
+ */
+volatile uint8_t status_bar_clock_pending = 0;
+static void status_bar_deferred_clock(uint32_t arg) {
+    status_bar_clock_pending = 0;
+    status_bar_update_clock();
+}
+
+/* void status_bar_request_clock()
+ * @output: clock will be updated as deferred work
+ * @description: cheap enough to be called from an interrupt handler.
+ */
+void status_bar_request_clock() {
+    if(status_bar_clock_pending) return;
+    status_bar_clock_pending = 1;
+    if(FAIL == deferred_queue(status_bar_deferred_clock, 0)) status_bar_clock_pending = 0;
 }
@@ -13,11 +13,18 @@
 #define STATUS_BAR_X_TIME_START 60
 #define STATUS_BAR_X_TIME_END 80
 
+#define STATUS_BAR_TIME_LEN (STATUS_BAR_X_TIME_END - STATUS_BAR_X_TIME_START)
+// Enough for 32 bit color
+#define STATUS_BAR_MAX_PIXEL_SIZE 4
+
 #define ATTR_YELLOW_ON_BLACK 0x0e
 #define ATTR_WHITE_ON_BLUE 0x1f
 
 void status_bar_switch_terminal(uint8_t tid);
+void status_bar_report_boot();
 void status_bar_update_message(char* msg, uint32_t len, uint8_t attr);
 void status_bar_update_clock();
+void status_bar_redraw();
+void status_bar_request_clock();
 
 #endif
@@ -5,6 +5,7 @@
 #include "paging.h"
 #include "devices/acpi.h"
 #include "devices/qemu_vga.h"
+#include "devices/clock.h"
 
 /* void init_paging()
  * @output: page table and page directory initialized.
@@ -25,6 +26,7 @@ void init_paging()
                 || (index >= VIDEO_MEM_ALT_START && index < VIDEO_MEM_ALT_END)
                 || (index >= SB16_MEM_BEGIN && index < SB16_MEM_END)
                 || (index >= ACPI_MEM_BEGIN && index < ACPI_MEM_END)
+                || (index >= VGA_FONT_MEM_BEGIN && index < VGA_FONT_MEM_END)
             ) ? 1 : 0;
         page_table[index].read_write = 0;
         page_table[index].user_supervisor = 0;
@@ -66,6 +68,10 @@ void init_paging()
         page_table_usermap[index].avail = 0;
         page_table_usermap[index].PB_addr = index;
     }
+    // Time page is always there for user programs to read
+    page_table_usermap[CLOCK_PAGE_INDEX].present = 1;
+    page_table_usermap[CLOCK_PAGE_INDEX].read_write = 0;
+    page_table_usermap[CLOCK_PAGE_INDEX].PB_addr = (uint32_t) clock_page >> TB_ADDR_OFFSET;
     // initialize the first 4MB memory (4kB page, where video memory is)
     page_directory[0].pde_KB.present = 1;
     page_directory[0].pde_KB.read_write = 0;
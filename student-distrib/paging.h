@@ -28,6 +28,10 @@
 #define ACPI_MEM_BEGIN 0xe0 // 0xe0000 >> 12
 #define ACPI_MEM_END 0x100  // 0x100000 >> 12
 
+// VGA character generator RAM, while text mode font is written. Takes 8KB space.
+#define VGA_FONT_MEM_BEGIN 0xa0 // 0xa0000 >> 12
+#define VGA_FONT_MEM_END 0xa2   // 0xa2000 >> 12
+
 #define PAGE_TABLE_USERMAP_LOCATION 33  // 132-136M
 
 // function used to initial paging
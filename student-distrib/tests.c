@@ -6,6 +6,21 @@
 #include "devices/rtc.h"	// Added by jinghua3.
 #include "devices/sb16.h"
 #include "devices/keyboard.h"
+#include "devices/qemu_vga.h"
+#include "data/uiuc.h"
+#include "devices/vga2d.h"
+#include "devices/mouse_cursor.h"
+#include "devices/screen.h"
+#include "lib/glyph_cache.h"
+#include "devices/vga_font.h"
+#include "lib/scrollback.h"
+#include "lib/ansi.h"
+#include "lib/deferred.h"
+#include "devices/pit.h"
+#include "devices/clock.h"
+#include "fs/pipe.h"
+#include "lib/shm.h"
+#include "lib/futex.h"
 #include "interrupts/sys_calls.h"
 #include "interrupts/multiprocessing.h"
 
@@ -800,6 +815,869 @@ int sb16_play_music(fd_array_t* fd_array) {
 	return PASS;
 }
 
+/* int poke_batch_test()
+ * @output: PASS / FAIL
+ * @description: Tests batched pokes and blits from a user page buffer:
+ *     cells outside the screen are skipped and not counted, a block
+ *     falling off the screen is clipped, and kernel pointers are refused.
+ */
+int poke_batch_test() {
+	TEST_HEADER;
+
+	int32_t pid = process_spawn("counter");
+	int32_t active = active_process_id;
+	int result = PASS;
+	if(FAIL == pid) return FAIL;
+	uint16_t* screen = (uint16_t*) video_mem;
+	uint16_t blank = ' ' | ATTRIB << 8;
+	int i;
+
+	// Buffers are in the user page of the spawned process
+	active_process_id = pid;
+	process_switch_paging(pid);
+	poke_t* pokes = (poke_t*) (USER_PROCESS_ADDR + 0x100000);
+	uint16_t* cells = (uint16_t*) (USER_PROCESS_ADDR + 0x100000);
+	clear();
+
+	pokes[0].x = 1;
+	pokes[0].y = 2;
+	pokes[0].data = 0x0741;
+	pokes[1].x = SCREEN_WIDTH;
+	pokes[1].y = 0;
+	pokes[1].data = 0x0758;
+	pokes[2].x = 1;
+	pokes[2].y = 2;
+	pokes[2].data = 0x0742;
+	if(syscall_poke_batch(pokes, 3) != 2) result = FAIL;
+	if(screen[2 * SCREEN_WIDTH + 1] != 0x0742 || screen[0] != blank) result = FAIL;
+
+	// 3x2 block at bottom right corner, only 2x2 of it is on screen
+	for(i = 0; i < 6; i++) cells[i] = 0x0761 + i;
+	if(FAIL == syscall_blit(cells, (SCREEN_HEIGHT - 2) << 16 | (SCREEN_WIDTH - 2), 2 << 16 | 3)) result = FAIL;
+	if(screen[(SCREEN_HEIGHT - 1) * SCREEN_WIDTH - 2] != cells[0]
+		|| screen[(SCREEN_HEIGHT - 1) * SCREEN_WIDTH - 1] != cells[1]) result = FAIL;
+	if(screen[SCREEN_HEIGHT * SCREEN_WIDTH - 2] != cells[3]
+		|| screen[SCREEN_HEIGHT * SCREEN_WIDTH - 1] != cells[4]) result = FAIL;
+	// Clipped column doesn't wrap onto the next row
+	if(screen[(SCREEN_HEIGHT - 1) * SCREEN_WIDTH] != blank) result = FAIL;
+	if(syscall_blit(cells, SCREEN_WIDTH, 1 << 16 | 1) != FAIL) result = FAIL;
+
+	// Kernel memory is refused
+	if(!bad_userspace_addr(video_mem, 1)) result = FAIL;
+	if(syscall_poke_batch((poke_t*) video_mem, 1) != FAIL) result = FAIL;
+	if(syscall_blit((uint16_t*) video_mem, 0, 1 << 16 | 1) != FAIL) result = FAIL;
+
+	clear();
+	active_process_id = active;
+	process_switch_paging(active);
+	process_release(pid);
+	process_get_pcb(pid)->present = 0;
+	return result;
+}
+
+/* int unified_fs_rtc_latency(fd_array_t* fd_array)
+ * @output: PASS / FAIL
+ * @description: Tests that RTC handler timing is collected while it ticks
+ *     at 1024Hz, and prints the worst case.
+ */
+int unified_fs_rtc_latency(fd_array_t* fd_array) {
+	TEST_HEADER;
+
+	int32_t fd;
+	if(FAIL == (fd = unified_open(fd_array, "rtc"))) return FAIL;
+	if(FAIL == unified_ioctl(fd_array, fd, RTC_IOCTL_RESET_STATS)) return FAIL;
+
+	// Wait for a few clock updates, 1024 ticks at 1024Hz
+	uint32_t freq = 1024;
+	if(FAIL == unified_write(fd_array, fd, &freq, sizeof(uint32_t))) return FAIL;
+	int i;
+	for(i = 0; i < 1024; i++) {
+		if(FAIL == unified_read(fd_array, fd, NULL, 0)) return FAIL;
+	}
+
+	int32_t cycles = unified_ioctl(fd_array, fd, RTC_IOCTL_MAX_HANDLER_CYCLES);
+	if(FAIL == cycles) return FAIL;
+	printf("Worst case RTC handler: %d cycles\n", cycles);
+	if(FAIL == unified_close(fd_array, fd)) return FAIL;
+	return PASS;
+}
+
+/* int qemu_vga_mode_switch_test()
+ * @output: PASS / FAIL
+ * @description: Tests that unsupported modes are refused without changing
+ *     anything, and that 8 bit mode uses its own routines and palette colors.
+ */
+int qemu_vga_mode_switch_test() {
+	TEST_HEADER;
+
+	if(!qemu_vga_enabled) return FAIL;
+	if(FAIL != qemu_vga_set_mode(320, 200, QEMU_VGA_DEFAULT_BPP)) return FAIL;
+	if(FAIL != qemu_vga_set_mode(QEMU_VGA_DEFAULT_WIDTH, QEMU_VGA_DEFAULT_HEIGHT, 24)) return FAIL;
+	if(qemu_vga_ops->bpp != QEMU_VGA_DEFAULT_BPP) return FAIL;
+
+	if(FAIL == qemu_vga_set_mode(QEMU_VGA_DEFAULT_WIDTH, QEMU_VGA_DEFAULT_HEIGHT, 8)) return FAIL;
+	if(qemu_vga_ops->bytes_per_pixel != 1) return FAIL;
+	if(qemu_vga_pitch != QEMU_VGA_DEFAULT_WIDTH) return FAIL;
+	// Palette mode uses terminal colors as palette index
+	if(qemu_vga_get_terminal_color(0x1f).val != 0xf) return FAIL;
+
+	if(FAIL == qemu_vga_set_mode(QEMU_VGA_DEFAULT_WIDTH, QEMU_VGA_DEFAULT_HEIGHT, QEMU_VGA_DEFAULT_BPP)) return FAIL;
+	return PASS;
+}
+
+/* int unified_fs_vga_double_buffer(fd_array_t* fd_array)
+ * @output: PASS / FAIL
+ * @description: Tests that drawing goes to the back page once double
+ *     buffering is on, and that present flips the pages.
+ */
+int unified_fs_vga_double_buffer(fd_array_t* fd_array) {
+	TEST_HEADER;
+
+	int32_t vga_fd;
+	if(FAIL == (vga_fd = unified_open(fd_array, "vga"))) return FAIL;
+	uint8_t front = qemu_vga_buffers[active_terminal_id].front;
+	if(qemu_vga_active_window_addr() != qemu_vga_page_addr(active_terminal_id, front)) return FAIL;
+
+	if(FAIL == unified_ioctl(fd_array, vga_fd, QEMU_VGA_IOCTL_DOUBLE_BUFFER_ON)) return FAIL;
+	if(qemu_vga_active_window_addr() != qemu_vga_page_addr(active_terminal_id, !front)) return FAIL;
+	if(FAIL == unified_ioctl(fd_array, vga_fd, QEMU_VGA_IOCTL_PRESENT)) return FAIL;
+	if(qemu_vga_buffers[active_terminal_id].front == front) return FAIL;
+	if(qemu_vga_active_window_addr() != qemu_vga_page_addr(active_terminal_id, front)) return FAIL;
+	if(FAIL == unified_ioctl(fd_array, vga_fd, QEMU_VGA_IOCTL_GET_FPS)) return FAIL;
+
+	if(FAIL == unified_close(fd_array, vga_fd)) return FAIL;
+	if(qemu_vga_buffers[active_terminal_id].enabled) return FAIL;
+	return PASS;
+}
+
+/* int glyph_cache_test()
+ * @output: PASS / FAIL
+ * @description: Tests that a glyph decoded into the cache, and read from it
+ *     again, matches the uncompressed font data, and that characters outside
+ *     the font are reported as missing.
+ */
+#define TEST_GLYPH_CODE 0x4e2d		// Chinese character "middle"
+// Its rows in the uncompressed font, before it was Huffman coded
+uint16_t glyph_cache_test_rows[CHINESE_FONT_HEIGHT] = {
+	0x0000, 0x0180, 0x0180, 0x0180, 0x3ffc, 0x2184, 0x2184, 0x2184,
+	0x2184, 0x2184, 0x3ffc, 0x2184, 0x0180, 0x0180, 0x0180, 0x0180
+};
+int glyph_cache_test() {
+	TEST_HEADER;
+
+	uint16_t first[CHINESE_FONT_HEIGHT];
+	uint16_t second[CHINESE_FONT_HEIGHT];
+	int i;
+	if(FAIL == glyph_cache_get(TEST_GLYPH_CODE, first)) return FAIL;
+	if(FAIL == glyph_cache_get(TEST_GLYPH_CODE, second)) return FAIL;
+	for(i = 0; i < CHINESE_FONT_HEIGHT; i++) {
+		if(first[i] != glyph_cache_test_rows[i]) return FAIL;
+		if(second[i] != glyph_cache_test_rows[i]) return FAIL;
+	}
+	if(FAIL != glyph_cache_get(CHINESE_ENCODE_END, first)) return FAIL;
+	return PASS;
+}
+
+/* int scrollback_row_is(int row, char* str)
+ * @input: row - row on displayed terminal
+ *         str - text expected at its start
+ * @output: 1 if the row starts with str, 0 if not
+ */
+int scrollback_row_is(int row, char* str) {
+	char* cell = (char*) TERMINAL_DIRECT_ADDR + ((row * NUM_COLS) << 1);
+	int i;
+	for(i = 0; str[i]; i++) {
+		if(cell[i << 1] != str[i]) return 0;
+	}
+	return 1;
+}
+
+/* int scrollback_test()
+ * @output: PASS / FAIL
+ * @description: Tests that lines rolled off screen are kept in history,
+ *     shown when scrolled back, and that printing returns to live screen.
+ */
+int scrollback_test() {
+	TEST_HEADER;
+
+	int i;
+	clear();
+	// Roll 2 lines off the screen
+	for(i = 0; i < NUM_ROWS + 1; i++) {
+		printf("line %d\n", i);
+	}
+	if(!scrollback_row_is(0, "line 2")) return FAIL;
+	scrollback_scroll(1);
+	if(!scrollback_row_is(0, "line 1")) return FAIL;
+	if(!scrollback_row_is(1, "line 2")) return FAIL;
+	scrollback_scroll(-1);
+	if(!scrollback_row_is(0, "line 2")) return FAIL;
+	scrollback_scroll(1);
+	// Printing brings back live screen
+	printf("\n");
+	if(!scrollback_row_is(0, "line 3")) return FAIL;
+	return PASS;
+}
+
+/* void ansi_puts(char* s)
+ * @input: s - text with escape sequences
+ * @output: text put on active terminal through the escape parser
+ */
+void ansi_puts(char* s) {
+	while(*s) ansi_putc(*(s++));
+}
+
+/* int ansi_escape_test()
+ * @output: PASS / FAIL
+ * @description: Tests colors, cursor movement, screen clearing and scroll
+ *     regions, including a sequence split between writes, and erasing
+ *     while scrolled back into history.
+ */
+int ansi_escape_test() {
+	TEST_HEADER;
+
+	volatile terminal_t* t = &terminals[active_terminal_id];
+	int i;
+	clear();
+	ansi_puts("\x1b[31;44mA");
+	if(video_mem[0] != 'A' || video_mem[1] != 0x14) return FAIL;
+	ansi_puts("\x1b[m\x1b[5;10H");
+	if(t->attrib != ATTRIB) return FAIL;
+	if(t->screen_x != 9 || t->screen_y != 4) return FAIL;
+	// Sequence split between writes
+	ansi_puts("\x1b[");
+	ansi_puts("2J");
+	if(video_mem[0] != ' ') return FAIL;
+	ansi_puts("\x1b[3;5r");
+	if(t->scroll_top != 2 || t->scroll_bottom != 4) return FAIL;
+	ansi_puts("\x1b[5;1HB\n");
+	// Line feed on last line of region scrolls only the region
+	if(t->screen_y != 4) return FAIL;
+	if(video_mem[(3 * NUM_COLS) << 1] != 'B') return FAIL;
+	ansi_reset();
+	if(t->scroll_bottom != NUM_ROWS - 1) return FAIL;
+
+	// Erasing while history is shown erases live screen, and keeps it erased.
+	// Roll one line into history first
+	clear();
+	for(i = 0; i < NUM_ROWS; i++) ansi_puts("C\n");
+	scrollback_scroll(1);
+	ansi_puts("\x1b[2J");
+	ansi_putc(' ');
+	if(video_mem[0] != ' ' || video_mem[NUM_COLS << 1] != ' ') return FAIL;
+	return PASS;
+}
+
+/* int vga2d_test()
+ * @output: PASS / FAIL
+ * @description: Tests 2D fill, color expansion in opaque and transparent
+ *     modes, and copies between overlapping areas in both directions.
+ */
+uint8_t vga2d_test_buf[4 * 64];
+int vga2d_test() {
+	TEST_HEADER;
+
+	uint8_t mask[2] = {0xa5, 0x80};
+	uint16_t* row = (uint16_t*) vga2d_test_buf;
+	int i;
+
+	// Odd width, so the tail of the fill is a single word
+	memset(vga2d_test_buf, 0, sizeof(vga2d_test_buf));
+	vga2d_fill_16((uint32_t) vga2d_test_buf, 64, 7, 2, 0x1234);
+	for(i = 0; i < 7; i++) {
+		if(row[i] != 0x1234 || row[32 + i] != 0x1234) return FAIL;
+	}
+	if(row[7] != 0 || row[64] != 0) return FAIL;
+
+	vga2d_expand_16((uint32_t) vga2d_test_buf, 64, mask, 2, 9, 1, 1, 2, VGA2D_OPAQUE);
+	if(row[0] != 1 || row[1] != 2 || row[7] != 1 || row[8] != 1) return FAIL;
+	vga2d_expand_16((uint32_t) vga2d_test_buf, 64, mask, 2, 9, 1, 3, 0, VGA2D_TRANSPARENT);
+	if(row[0] != 3 || row[1] != 2) return FAIL;
+
+	// Overlapping copy, one row down and one pixel right
+	for(i = 0; i < 64; i++) vga2d_test_buf[i] = i;
+	vga2d_copy((uint32_t) vga2d_test_buf + 64 + 2, 64, (uint32_t) vga2d_test_buf, 64, 62, 2);
+	for(i = 0; i < 62; i++) {
+		if(vga2d_test_buf[64 + 2 + i] != i) return FAIL;
+	}
+	// And back up again
+	vga2d_copy((uint32_t) vga2d_test_buf, 64, (uint32_t) vga2d_test_buf + 64 + 2, 64, 62, 1);
+	for(i = 0; i < 62; i++) {
+		if(vga2d_test_buf[i] != i) return FAIL;
+	}
+	return PASS;
+}
+
+/* int mouse_cursor_test()
+ * @output: PASS / FAIL
+ * @description: Tests that the cursor is clamped to the screen, drawn in
+ *     its fill color, and that hiding it restores the pixels under it.
+ */
+int mouse_cursor_test() {
+	TEST_HEADER;
+
+	if(!qemu_vga_enabled) return FAIL;
+	uint32_t bytes_per_pixel = qemu_vga_ops->bytes_per_pixel;
+	uint8_t* pixel = (uint8_t*) (qemu_vga_page_addr(displayed_terminal_id,
+		qemu_vga_buffers[displayed_terminal_id].front) + 2 * qemu_vga_pitch + bytes_per_pixel);
+	uint32_t mask = bytes_per_pixel == 4 ? 0xffffff : (1 << (bytes_per_pixel * 8)) - 1;
+	uint32_t saved;
+	uint32_t fill = qemu_vga_get_terminal_color(MOUSE_CURSOR_FILL_COLOR).val & mask;
+
+	mouse_cursor_set_visible(0);
+	mouse_cursor_move(-qemu_vga_xres, -qemu_vga_yres);
+	if(mouse_cursor_get_pos() != 0) return FAIL;
+
+	// Pixel (1, 2) is inside the arrow
+	saved = *(uint32_t*) pixel & mask;
+	mouse_cursor_set_visible(1);
+	if((*(uint32_t*) pixel & mask) != fill) return FAIL;
+	mouse_cursor_set_visible(0);
+	if((*(uint32_t*) pixel & mask) != saved) return FAIL;
+	mouse_cursor_set_visible(1);
+	return PASS;
+}
+
+uint8_t screen_test_buf[8192];
+/* uint32_t screen_check_rect(const uint8_t* data, const screen_rect_t* rect, uint32_t bytes_per_pixel)
+ * @input: data - run length encoded pixels of a rectangle read from screen device
+ *         rect - position and size of the rectangle
+ *         bytes_per_pixel - of current mode
+ * @output: bytes of data used, or 0 if the pixels don't match the front page
+ */
+uint32_t screen_check_rect(const uint8_t* data, const screen_rect_t* rect, uint32_t bytes_per_pixel) {
+	const uint8_t* start = data;
+	int row, x, k;
+	for(row = 0; row < rect->height; row++) {
+		const uint8_t* pixel = (uint8_t*) (qemu_vga_page_addr(active_terminal_id, qemu_vga_buffers[active_terminal_id].front)
+			+ (rect->y + row) * qemu_vga_pitch + rect->x * bytes_per_pixel);
+		x = 0;
+		while(x < rect->width) {
+			uint8_t control = *data++;
+			int count = control < SCREEN_RLE_REPEAT ? control + 1 : control - SCREEN_RLE_REPEAT + SCREEN_RLE_MIN_REPEAT;
+			for(k = 0; k < count * bytes_per_pixel; k++) {
+				const uint8_t* expected = control < SCREEN_RLE_REPEAT ? data + k : data + k % bytes_per_pixel;
+				if(pixel[x * bytes_per_pixel + k] != *expected) return 0;
+			}
+			x += count;
+			data += control < SCREEN_RLE_REPEAT ? count * bytes_per_pixel : bytes_per_pixel;
+		}
+	}
+	return data - start;
+}
+
+/* int unified_fs_screen_capture(fd_array_t* fd_array)
+ * @input: fd_array - file descriptor array
+ * @output: PASS / FAIL
+ * @description: Tests that the first reads of screen device cover the whole
+ *     frame, and later ones only rectangles drawn since.
+ */
+int unified_fs_screen_capture(fd_array_t* fd_array) {
+	TEST_HEADER;
+
+	int32_t fd, len, i;
+	uint32_t area = 0;
+	if(FAIL == (fd = unified_open(fd_array, "screen"))) return FAIL;
+	// Captured frames don't have the mouse cursor, front page does
+	mouse_cursor_set_visible(0);
+	screen_header_t* header = (screen_header_t*) screen_test_buf;
+
+	// Full frame first, split over reads by rows
+	for(i = 0; i < 1000 && area < qemu_vga_xres * qemu_vga_yres; i++) {
+		if(FAIL == (len = unified_read(fd_array, fd, screen_test_buf, sizeof(screen_test_buf)))) return FAIL;
+		if(header->width != qemu_vga_xres || header->bytes_per_pixel != qemu_vga_ops->bytes_per_pixel) return FAIL;
+		if(0 == header->rect_count) return FAIL;
+		uint8_t* data = screen_test_buf + sizeof(screen_header_t);
+		int r;
+		for(r = 0; r < header->rect_count; r++) {
+			screen_rect_t* rect = (screen_rect_t*) data;
+			uint32_t size = screen_check_rect(data + sizeof(screen_rect_t), rect, header->bytes_per_pixel);
+			if(0 == size) return FAIL;
+			data += sizeof(screen_rect_t) + size;
+			area += rect->width * rect->height;
+		}
+		if(data != screen_test_buf + len) return FAIL;
+	}
+
+	// Then only what's drawn
+	qemu_vga_putc(0, 0, 'A', qemu_vga_get_terminal_color(0xf), qemu_vga_get_terminal_color(0));
+	if(FAIL == (len = unified_read(fd_array, fd, screen_test_buf, sizeof(screen_test_buf)))) return FAIL;
+	screen_rect_t* rect = (screen_rect_t*) (screen_test_buf + sizeof(screen_header_t));
+	if(header->rect_count < 1 || rect->x != 0 || rect->y != 0) return FAIL;
+	if(rect->width < FONT_ACTUAL_WIDTH || rect->height < FONT_ACTUAL_HEIGHT) return FAIL;
+	if(0 == screen_check_rect((uint8_t*) (rect + 1), rect, header->bytes_per_pixel)) return FAIL;
+
+	mouse_cursor_set_visible(1);
+	if(FAIL == unified_close(fd_array, fd)) return FAIL;
+	return PASS;
+}
+
+/* int qemu_vga_lazy_text_test()
+ * @output: PASS / FAIL
+ * @description: Tests that text updates of a hidden terminal aren't
+ *     rendered until the terminal is flushed.
+ */
+int qemu_vga_lazy_text_test() {
+	TEST_HEADER;
+
+	if(!qemu_vga_enabled) return FAIL;
+	int32_t tid = (displayed_terminal_id + 1) % TERMINAL_COUNT;
+	int32_t saved_tid = active_terminal_id;
+	char* saved_video_mem = video_mem;
+	volatile uint8_t* pixel = (uint8_t*) qemu_vga_page_addr(tid, qemu_vga_buffers[tid].front);
+	int result = PASS;
+
+	// Marker on hidden window, text update shouldn't touch it
+	*pixel = 0x5a;
+	active_terminal_id = tid;
+	video_mem = (char*) (TERMINAL_ALT_START + tid * TERMINAL_ALT_SIZE);
+	qemu_vga_draw_cells(0, 0, 1);
+	qemu_vga_roll_up(0, 1);
+	video_mem = saved_video_mem;
+	active_terminal_id = saved_tid;
+	if(*pixel != 0x5a) result = FAIL;
+
+	// Rendered once needed
+	qemu_vga_text_flush(tid);
+	if(*pixel == 0x5a) result = FAIL;
+	return result;
+}
+
+/* int qemu_vga_attr_test()
+ * @output: PASS / FAIL
+ * @description: Tests that packed attribute colors match the terminal
+ *     colors of current color depth.
+ */
+int qemu_vga_attr_test() {
+	TEST_HEADER;
+
+	int i;
+	for(i = 0; i < QEMU_VGA_ATTRS; i++) {
+		if(qemu_vga_attrs[i].fg.val != qemu_vga_get_terminal_color(i).val) return FAIL;
+		if(qemu_vga_attrs[i].bg.val != qemu_vga_get_terminal_color(i >> 4).val) return FAIL;
+	}
+	return PASS;
+}
+
+/* int qemu_vga_splash_test()
+ * @output: PASS / FAIL
+ * @description: Tests that the boot picture is pre-rendered onto every
+ *     terminal, that a starting terminal's cursor skips it, and that a
+ *     mode switch drops it.
+ */
+int qemu_vga_splash_test() {
+	TEST_HEADER;
+
+	if(!qemu_vga_enabled) return FAIL;
+	int32_t tid = TERMINAL_COUNT - 1;
+	uint32_t row_bytes = UIUC_IMAGE_WIDTH * QEMU_VGA_DEFAULT_BPP / BITS_IN_BYTE;
+	int32_t saved_x = terminals[active_terminal_id].screen_x;
+	int32_t saved_y = terminals[active_terminal_id].screen_y;
+	int result = PASS;
+
+	// Same picture on first and last terminal
+	qemu_vga_preload_picture_lzss(UIUC_IMAGE_WIDTH, UIUC_IMAGE_HEIGHT, QEMU_VGA_DEFAULT_BPP,
+		UIUC_IMAGE_LZSS, UIUC_IMAGE_LZSS_SIZE);
+	if(qemu_vga_splash_height != UIUC_IMAGE_HEIGHT) result = FAIL;
+	uint8_t* first = (uint8_t*) qemu_vga_page_addr(0, qemu_vga_buffers[0].front);
+	uint8_t* last = (uint8_t*) qemu_vga_page_addr(tid, qemu_vga_buffers[tid].front);
+	uint32_t i;
+	for(i = 0; i < row_bytes; i++) {
+		if(first[i] != last[i]) result = FAIL;
+	}
+
+	// Cursor moves below it, unless already there
+	terminals[active_terminal_id].screen_x = 3;
+	terminals[active_terminal_id].screen_y = 0;
+	qemu_vga_skip_picture(qemu_vga_splash_height);
+	if(terminals[active_terminal_id].screen_y != UIUC_IMAGE_HEIGHT / FONT_ACTUAL_HEIGHT + 1
+		|| terminals[active_terminal_id].screen_x != 0) result = FAIL;
+	terminals[active_terminal_id].screen_x = 3;
+	qemu_vga_skip_picture(qemu_vga_splash_height);
+	if(terminals[active_terminal_id].screen_x != 3) result = FAIL;
+
+	// Mode switch clears pages, so nothing left to skip
+	if(FAIL == qemu_vga_set_mode(qemu_vga_xres, qemu_vga_yres, QEMU_VGA_DEFAULT_BPP)) result = FAIL;
+	if(qemu_vga_splash_height != 0) result = FAIL;
+	terminals[active_terminal_id].screen_y = 0;
+	qemu_vga_skip_picture(qemu_vga_splash_height);
+	if(terminals[active_terminal_id].screen_y != 0) result = FAIL;
+
+	terminals[active_terminal_id].screen_x = saved_x;
+	terminals[active_terminal_id].screen_y = saved_y;
+	return result;
+}
+
+/* int vga_font_test()
+ * @output: PASS / FAIL
+ * @description: Tests that a Chinese character in text mode goes into a
+ *     pair of font slots, and that printing it again reuses them.
+ */
+int vga_font_test() {
+	TEST_HEADER;
+
+	if(qemu_vga_enabled) return FAIL;
+	uint8_t* cell = (uint8_t*) video_mem;
+	clear();
+	// "middle" in UTF-8, goes into a pair of slots
+	puts("\xe4\xb8\xad");
+	uint8_t left = cell[0];
+	if(left < VGA_FONT_WIDE_LEFT || left >= VGA_FONT_WIDE_LEFT + VGA_FONT_WIDE_SLOTS) return FAIL;
+	if(cell[2] != VGA_FONT_WIDE_RIGHT + left - VGA_FONT_WIDE_LEFT) return FAIL;
+
+	// Same character again reuses its slot
+	puts("\xe4\xb8\xad");
+	if(cell[4] != left) return FAIL;
+	clear();
+	return PASS;
+}
+
+/* int process_spawn_test()
+ * @output: PASS / FAIL
+ * @description: Tests that a spawned process runs in background without
+ *     taking over the terminal, and that bad commands fail.
+ */
+int process_spawn_test() {
+	TEST_HEADER;
+
+	int32_t tid = active_terminal_id;
+	int32_t foreground = terminals[tid].active_process;
+	int32_t pid = process_spawn("counter");
+	if(FAIL == pid) return FAIL;
+	process_t* process = process_get_pcb(pid);
+	int result = PASS;
+
+	// Runs on its own, terminal keeps its foreground process
+	if(!process->background || process->started || process->parent_pid != -1) result = FAIL;
+	if(process->terminal != tid || terminals[tid].active_process != foreground) result = FAIL;
+	if(FAIL != process_spawn("nonexistent")) result = FAIL;
+	// Same cleanup as halt, so its files don't outlive the test
+	process_release(pid);
+	process->present = 0;
+	return result;
+}
+
+/* int process_clone_test()
+ * @output: PASS / FAIL
+ * @description: Tests that a thread shares its process's memory and
+ *     terminal, starts on the given stack, and goes away with the process.
+ */
+int process_clone_test() {
+	TEST_HEADER;
+
+	int32_t pid = process_spawn("counter");
+	if(FAIL == pid) return FAIL;
+	process_t* process = process_get_pcb(pid);
+	int32_t active = active_process_id;
+	int result = PASS;
+	uint32_t stack = USER_PROCESS_ADDR + 0x100000;
+
+	// Clone as if the spawned process called it, its page is mapped
+	active_process_id = pid;
+	int32_t tid = process_clone(USER_PROCESS_ADDR, stack, 0x391);
+	if(FAIL == tid) {
+		result = FAIL;
+	} else {
+		process_t* thread = process_get_pcb(tid);
+		if(!thread->thread || thread->group_pid != pid || thread->started) result = FAIL;
+		if(thread->terminal != process->terminal || thread->fd_array[0].interface != NULL) result = FAIL;
+		if(thread->esp != stack - 8 || *(uint32_t*) (stack - 4) != 0x391) result = FAIL;
+	}
+	// Entry and stack must be in the user page
+	if(FAIL != process_clone(0, stack, 0)) result = FAIL;
+	if(FAIL != process_clone(USER_PROCESS_ADDR, (USER_PROCESS_ADDR >> PD_ADDR_OFFSET) << PD_ADDR_OFFSET, 0)) result = FAIL;
+	active_process_id = active;
+	process_switch_paging(active);
+	// Removes the thread too
+	process_release(pid);
+	if(FAIL != tid && process_get_pcb(tid)->present) result = FAIL;
+	process->present = 0;
+	return result;
+}
+
+/* void deferred_test_work(uint32_t arg)
+ * @input: arg - digit to append to deferred_test_sum
+ * @output: deferred_test_sum records the order work ran in
+ */
+static uint32_t deferred_test_sum;
+static void deferred_test_work(uint32_t arg) {
+	// Work runs in order, with interrupts on
+	deferred_test_sum = deferred_test_sum * 10 + arg;
+}
+
+/* int deferred_test()
+ * @output: PASS / FAIL
+ * @description: Tests that deferred work runs in order it's queued, and
+ *     that a full queue drops work instead of overwriting it.
+ */
+int deferred_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	int i;
+	deferred_test_sum = 0;
+	if(FAIL == deferred_queue(deferred_test_work, 1)) result = FAIL;
+	if(FAIL == deferred_queue(deferred_test_work, 2)) result = FAIL;
+	if(FAIL != deferred_queue(NULL, 0)) result = FAIL;
+	cli();
+	deferred_run();
+	sti();
+	if(deferred_test_sum != 12 || deferred_running) result = FAIL;
+
+	// Full queue drops work instead of overwriting it
+	cli();
+	uint32_t dropped = deferred_dropped;
+	for(i = 0; i <= DEFERRED_QUEUE_SIZE; i++) deferred_queue(deferred_test_work, 0);
+	if(deferred_dropped == dropped) result = FAIL;
+	deferred_run();
+	sti();
+	return result;
+}
+
+/* void pit_timer_test_event(uint32_t arg)
+ * @input: arg - digit to append to pit_timer_test_order
+ * @output: pit_timer_test_order records the order events fired in
+ */
+static uint32_t pit_timer_test_order;
+static void pit_timer_test_event(uint32_t arg) {
+	pit_timer_test_order = pit_timer_test_order * 10 + arg;
+}
+
+/* int pit_timer_test()
+ * @output: PASS / FAIL
+ * @description: Tests that timer events fire by deadline, not by order added.
+ */
+int pit_timer_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	uint32_t now = pit_timer;
+	pit_timer_test_order = 0;
+	// Fired by deadline, not by order added
+	if(FAIL == pit_timer_add(now + 3, pit_timer_test_event, 3)) result = FAIL;
+	if(FAIL == pit_timer_add(now + 1, pit_timer_test_event, 1)) result = FAIL;
+	if(FAIL == pit_timer_add(now + 2, pit_timer_test_event, 2)) result = FAIL;
+	if(pit_timer_test_order != 0) result = FAIL;
+	pit_sleep(5 * MS_PER_TICK);
+	if(pit_timer_test_order != 123) result = FAIL;
+
+	// No process to put to sleep
+	if(FAIL != process_sleep(1)) result = FAIL;
+	return result;
+}
+
+/* int clock_test()
+ * @output: PASS / FAIL
+ * @description: Tests that monotonic time goes forward by about the time
+ *     slept, that realtime is sane, and that bad input fails.
+ */
+int clock_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	timespec_t a, b;
+	uint32_t nsec;
+	if(FAIL == clock_gettime(CLOCK_MONOTONIC, &a)) return FAIL;
+	pit_sleep(2 * MS_PER_TICK);
+	if(FAIL == clock_gettime(CLOCK_MONOTONIC, &b)) return FAIL;
+	// Goes forward, by about the time slept
+	if(b.sec < a.sec || (b.sec == a.sec && b.nsec <= a.nsec)) result = FAIL;
+	if(a.nsec >= NS_IN_S || b.nsec >= NS_IN_S) result = FAIL;
+	if(FAIL != clock_gettime(CLOCK_MONOTONIC + 1, &a)) result = FAIL;
+	if(FAIL != clock_gettime(CLOCK_REALTIME, NULL)) result = FAIL;
+
+	// Realtime is after 2020-01-01
+	if(FAIL == clock_gettime(CLOCK_REALTIME, &a) || a.sec < 1577836800) result = FAIL;
+	if(div64_32(0x500000003ULL, 2, &nsec) != 0x280000001ULL || nsec != 1) result = FAIL;
+	return result;
+}
+
+/* int clock_page_test()
+ * @output: PASS / FAIL
+ * @description: Tests that the time page is mapped read only, holds the
+ *     kernel's data, and is updated on every tick.
+ */
+int clock_page_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	const clock_page_t* page = (const clock_page_t*) USER_CLOCK_PAGE;
+	// Mapped read only for user programs, same data as the kernel's copy
+	if(!page_table_usermap[CLOCK_PAGE_INDEX].present || page_table_usermap[CLOCK_PAGE_INDEX].read_write) result = FAIL;
+	if(page->boot_sec != clock_page->boot_sec || page->tsc_khz != clock_tsc_khz) result = FAIL;
+	if(page->seq & 1) result = FAIL;
+
+	uint32_t seq = page->seq;
+	pit_sleep(2 * MS_PER_TICK);
+	if(page->seq == seq || (page->seq & 1)) result = FAIL;
+	if(pit_timer - page->ticks > 1) result = FAIL;
+	return result;
+}
+
+/* int signal_test()
+ * @output: PASS / FAIL
+ * @description: Tests the context layout user programs rely on, default
+ *     actions without a handler, and that nothing is delivered to kernel code.
+ */
+int signal_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	hw_context_t context;
+	int32_t pid;
+	// Layout user programs rely on, signal number is followed by the context
+	if(sizeof(hw_context_t) != 17 * sizeof(uint32_t)) result = FAIL;
+	if((uint32_t) &context.eax - (uint32_t) &context != HW_CONTEXT_EAX) result = FAIL;
+	if(signal_set_handler(SIGNAL_COUNT, NULL) != FAIL) result = FAIL;
+
+	// No handler or no process, caller takes default action
+	for(pid = 0; pid < PROCESS_COUNT; pid++) {
+		process_t* process = process_get_pcb(pid);
+		if(!process->present && signal_send(pid, SIGNAL_USER1) != FAIL) result = FAIL;
+		if(process->present && NULL == process->signal_handlers[SIGNAL_INTERRUPT]
+			&& signal_send(pid, SIGNAL_INTERRUPT) != FAIL) result = FAIL;
+	}
+	if(signal_send(PROCESS_COUNT, SIGNAL_USER1) != FAIL) result = FAIL;
+
+	// Nothing is delivered on return to kernel code
+	memset(&context, 0, sizeof(hw_context_t));
+	context.cs = KERNEL_CS;
+	context.eip = 0x12345678;
+	signal_deliver(&context);
+	if(context.eip != 0x12345678 || context.esp != 0 || context.cs != KERNEL_CS) result = FAIL;
+	return result;
+}
+
+/* int pipe_test()
+ * @output: PASS / FAIL
+ * @description: Tests pipe reads and writes wrapping around the ring, a full
+ *     pipe, and end of file once every write end is closed.
+ */
+int pipe_test() {
+	TEST_HEADER;
+
+	int result = PASS;
+	fd_array_t fd_array[MAX_OPEN_FILES];
+	int32_t fds[2];
+	static char buf[PIPE_BUFFER_SIZE];
+	int i;
+	if(FAIL == unified_init(fd_array)) return FAIL;
+	if(FAIL == pipe_create(fd_array, fds)) return FAIL;
+	if(fds[0] != 2 || fds[1] != 3) result = FAIL;
+	if(unified_read(fd_array, fds[1], buf, 1) != FAIL) result = FAIL;
+	if(unified_write(fd_array, fds[0], buf, 1) != FAIL) result = FAIL;
+
+	// Wrap around the end of the ring
+	for(i = 0; i < 3; i++) {
+		memset(buf, 'a' + i, PIPE_BUFFER_SIZE);
+		if(unified_write(fd_array, fds[1], buf, PIPE_BUFFER_SIZE - 100) != PIPE_BUFFER_SIZE - 100) result = FAIL;
+		memset(buf, 0, PIPE_BUFFER_SIZE);
+		if(unified_read(fd_array, fds[0], buf, PIPE_BUFFER_SIZE) != PIPE_BUFFER_SIZE - 100) result = FAIL;
+		if(buf[0] != 'a' + i || buf[PIPE_BUFFER_SIZE - 101] != 'a' + i) result = FAIL;
+	}
+	// Full pipe takes no more without a process to wait
+	if(unified_write(fd_array, fds[1], buf, PIPE_BUFFER_SIZE + 1) != PIPE_BUFFER_SIZE) result = FAIL;
+	if(unified_read(fd_array, fds[0], buf, PIPE_BUFFER_SIZE) != PIPE_BUFFER_SIZE) result = FAIL;
+
+	// Read end sees end of file only after every write end is closed
+	if(FAIL == unified_dup(fd_array, fds[1], fd_array, FD_STDOUT)) result = FAIL;
+	unified_close(fd_array, fds[1]);
+	if(unified_write(fd_array, FD_STDOUT, "x", 1) != 1) result = FAIL;
+	if(unified_read(fd_array, fds[0], buf, 2) != 1 || buf[0] != 'x') result = FAIL;
+	unified_close(fd_array, FD_STDOUT);
+	if(unified_read(fd_array, fds[0], buf, 1) != 0) result = FAIL;
+	unified_close(fd_array, fds[0]);
+	return result;
+}
+
+/* int shm_test()
+ * @output: PASS / FAIL
+ * @description: Tests that two processes find a segment by key and see the
+ *     same memory, and that it goes away after the last one detaches.
+ */
+int shm_test() {
+	TEST_HEADER;
+
+	int32_t producer = process_spawn("counter");
+	int32_t consumer = process_spawn("counter");
+	int32_t active = active_process_id;
+	int result = PASS;
+	if(FAIL == producer || FAIL == consumer) return FAIL;
+
+	// Producer creates the segment and writes into it
+	active_process_id = producer;
+	process_switch_paging(producer);
+	int32_t id = shm_create(0x391, SHM_PAGE_SIZE + 1);
+	int32_t addr = shm_attach(id);
+	if(FAIL == id || addr != USER_SHM_BASE + id * SHM_SEGMENT_PAGES * SHM_PAGE_SIZE) {
+		result = FAIL;
+	} else {
+		if(!page_table_usermap[SHM_PAGE_INDEX + id * SHM_SEGMENT_PAGES + 1].present
+			|| page_table_usermap[SHM_PAGE_INDEX + id * SHM_SEGMENT_PAGES + 2].present) result = FAIL;
+		if(*(uint32_t*) (addr + SHM_PAGE_SIZE) != 0) result = FAIL;
+		*(uint32_t*) (addr + SHM_PAGE_SIZE) = 0x391;
+	}
+	if(shm_create(0x391, 3 * SHM_PAGE_SIZE) != FAIL) result = FAIL;
+	if(shm_create(0x392, SHM_SEGMENT_PAGES * SHM_PAGE_SIZE + 1) != FAIL) result = FAIL;
+
+	// Consumer finds it by key, sees the same memory
+	active_process_id = consumer;
+	process_switch_paging(consumer);
+	if(shm_create(0x391, 1) != id) result = FAIL;
+	if(FAIL != id && *(uint32_t*) (addr + SHM_PAGE_SIZE) != 0x391) result = FAIL;
+	if(shm_detach(id) != SUCCESS || shm_detach(id) != FAIL) result = FAIL;
+	if(FAIL != id && page_table_usermap[SHM_PAGE_INDEX + id * SHM_SEGMENT_PAGES].present) result = FAIL;
+
+	// Segment goes away with the last process attached
+	active_process_id = producer;
+	process_switch_paging(producer);
+	shm_detach_all(&process_get_pcb(producer)->shm_attached);
+	if(shm_attach(id) != FAIL) result = FAIL;
+
+	active_process_id = active;
+	process_switch_paging(active);
+	process_release(producer);
+	process_release(consumer);
+	process_get_pcb(producer)->present = 0;
+	process_get_pcb(consumer)->present = 0;
+	return result;
+}
+
+/* int futex_test()
+ * @output: PASS / FAIL
+ * @description: Tests that futex wait doesn't block if the word changed,
+ *     and that only aligned words in user memory are accepted.
+ */
+int futex_test() {
+	TEST_HEADER;
+
+	int32_t pid = process_spawn("counter");
+	int32_t active = active_process_id;
+	int result = PASS;
+	if(FAIL == pid) return FAIL;
+	uint32_t* word = (uint32_t*) (USER_PROCESS_ADDR + 0x100000);
+
+	// Nothing waits without a process
+	if(futex_wake(word, 1) != FAIL) result = FAIL;
+
+	active_process_id = pid;
+	process_switch_paging(pid);
+	*word = 1;
+	// Value changed since the caller saw it, no waiting
+	if(futex_wait(word, 0) != FAIL) result = FAIL;
+	if(futex_wake(word, FUTEX_WAKE_ALL) != 0) result = FAIL;
+	// Only aligned words in user memory
+	if(futex_wake((uint32_t*) ((uint32_t) word + 1), 1) != FAIL) result = FAIL;
+	if(futex_wake((uint32_t*) KERNEL_STACK_BASE_ADDR, 1) != FAIL) result = FAIL;
+	if(futex_wake((uint32_t*) USER_SHM_BASE, 1) != FAIL) result = FAIL;
+
+	active_process_id = active;
+	process_switch_paging(active);
+	process_release(pid);
+	process_get_pcb(pid)->present = 0;
+	return result;
+}
+
 /* Test suite entry point */
 void launch_tests(){
 	clear();
@@ -842,6 +1720,30 @@ void launch_tests(){
 	// Extra features
 	// TEST_OUTPUT("Tux Controller Read", test_fdarray_wrapper(unified_fs_tux_read));
 	// TEST_OUTPUT("Tux Controller Write", test_fdarray_wrapper(unified_fs_tux_write));
+	// TEST_OUTPUT("Batched Poke / Blit", poke_batch_test());
+	// TEST_OUTPUT("Unified FS RTC Latency", test_fdarray_wrapper(unified_fs_rtc_latency));
+	// TEST_OUTPUT("QEMU VGA Mode Switch", qemu_vga_mode_switch_test());
+	// TEST_OUTPUT("QEMU VGA Double Buffer", test_fdarray_wrapper(unified_fs_vga_double_buffer));
+	// TEST_OUTPUT("Chinese Glyph Cache", glyph_cache_test());
+	// TEST_OUTPUT("Terminal Scrollback", scrollback_test());
+	// TEST_OUTPUT("ANSI Escape Sequences", ansi_escape_test());
+	// TEST_OUTPUT("VGA 2D Primitives", vga2d_test());
+	// TEST_OUTPUT("Mouse Cursor Sprite", mouse_cursor_test());
+	// TEST_OUTPUT("Screen Capture", test_fdarray_wrapper(unified_fs_screen_capture));
+	// TEST_OUTPUT("QEMU VGA Lazy Background Text", qemu_vga_lazy_text_test());
+	// TEST_OUTPUT("QEMU VGA Attribute Colors", qemu_vga_attr_test());
+	// TEST_OUTPUT("QEMU VGA Boot Splash", qemu_vga_splash_test());
+	// TEST_OUTPUT("VGA Text Mode Chinese Glyphs", vga_font_test());
+	// TEST_OUTPUT("Background Process Spawn", process_spawn_test());
+	// TEST_OUTPUT("Threads Sharing Memory", process_clone_test());
+	// TEST_OUTPUT("Deferred Interrupt Work", deferred_test());
+	// TEST_OUTPUT("PIT Timer Queue", pit_timer_test());
+	// TEST_OUTPUT("TSC Clock", clock_test());
+	// TEST_OUTPUT("Time Page", clock_page_test());
+	// TEST_OUTPUT("Signal Delivery", signal_test());
+	// TEST_OUTPUT("Pipes", pipe_test());
+	// TEST_OUTPUT("Shared Memory", shm_test());
+	// TEST_OUTPUT("Futex", futex_test());
 
 	// Deprecated / No longer works
 	// rtc_test();
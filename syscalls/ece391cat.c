@@ -8,12 +8,10 @@ int main ()
     int32_t fd, cnt;
     uint8_t buf[1024];
 
-    if (0 != ece391_getargs (buf, 1024)) {
-        ece391_fdputs (1, (uint8_t*)"could not read arguments\n");
-	return 3;
-    }
-
-    if (-1 == (fd = ece391_open (buf))) {
+    /* Without a file name, copy standard input, like the end of a pipe */
+    if (0 != ece391_getargs (buf, 1024))
+	fd = 0;
+    else if (-1 == (fd = ece391_open (buf))) {
         ece391_fdputs (1, (uint8_t*)"file not found\n");
 	return 2;
     }
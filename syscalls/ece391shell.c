@@ -5,6 +5,66 @@
 
 #define BUFSIZE 1024
 
+/* Cuts cmd at the first '|', returns the command after it, 0 if there's none */
+static uint8_t* split_pipe (uint8_t* cmd)
+{
+    for (; '\0' != *cmd; cmd++) {
+	if ('|' == *cmd) {
+	    *cmd = '\0';
+	    return cmd + 1;
+	}
+    }
+    return 0;
+}
+
+/* Points descriptor fd back at the terminal */
+static void restore_std (int32_t fd, const uint8_t* name)
+{
+    ece391_close (fd);
+    ece391_open (name);
+}
+
+/* Runs commands separated by '|', each one's output going into the next
+   one's input. All but the last run in background, the last is waited for */
+static int32_t execute_pipeline (uint8_t* cmd)
+{
+    int32_t fds[2];
+    int32_t in = -1;	/* read end for the next command, -1 for keyboard */
+    int32_t rval;
+    uint8_t* next;
+
+    while (0 != (next = split_pipe (cmd))) {
+	if (-1 == ece391_pipe (fds)) {
+	    rval = -1;
+	    break;
+	}
+	if (-1 != in)
+	    ece391_dup2 (in, 0);
+	ece391_dup2 (fds[1], 1);
+	rval = ece391_spawn (cmd);
+	restore_std (1, (uint8_t*)"stdout");
+	ece391_close (fds[1]);
+	if (-1 != in) {
+	    restore_std (0, (uint8_t*)"stdin");
+	    ece391_close (in);
+	}
+	in = fds[0];
+	if (-1 == rval)
+	    break;
+	cmd = next;
+    }
+    if (0 == next) {
+	if (-1 != in)
+	    ece391_dup2 (in, 0);
+	rval = ece391_execute (cmd);
+	if (-1 != in)
+	    restore_std (0, (uint8_t*)"stdin");
+    }
+    if (-1 != in)
+	ece391_close (in);
+    return rval;
+}
+
 int main ()
 {
     int32_t cnt, rval;
@@ -24,7 +84,7 @@ int main ()
 	    return 0;
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	rval = execute_pipeline (buf);
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
@@ -102,3 +102,65 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+/* Mutex states */
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED 1
+#define MUTEX_CONTENDED 2	/* locked, and others may be waiting */
+
+static uint32_t atomic_xchg(volatile uint32_t* addr, uint32_t val)
+{
+    asm volatile ("xchgl %0, %1" : "+r" (val), "+m" (*addr) : : "memory");
+    return val;
+}
+
+static uint32_t atomic_cmpxchg(volatile uint32_t* addr, uint32_t old, uint32_t val)
+{
+    asm volatile ("lock cmpxchgl %2, %1"
+                  : "+a" (old), "+m" (*addr) : "r" (val) : "memory");
+    return old;
+}
+
+void ece391_mutex_lock(ece391_mutex_t* m)
+{
+    uint32_t c = atomic_cmpxchg (m, MUTEX_UNLOCKED, MUTEX_LOCKED);
+
+    if (MUTEX_UNLOCKED == c)
+        return;
+    /* Mark it contended, so unlock wakes us up */
+    if (MUTEX_CONTENDED != c)
+        c = atomic_xchg (m, MUTEX_CONTENDED);
+    while (MUTEX_UNLOCKED != c) {
+        ece391_futex_wait (m, MUTEX_CONTENDED);
+        c = atomic_xchg (m, MUTEX_CONTENDED);
+    }
+}
+
+void ece391_mutex_unlock(ece391_mutex_t* m)
+{
+    if (MUTEX_CONTENDED == atomic_xchg (m, MUTEX_UNLOCKED))
+        ece391_futex_wake (m, 1);
+}
+
+void ece391_cond_wait(ece391_cond_t* c, ece391_mutex_t* m)
+{
+    uint32_t seq = *c;
+
+    ece391_mutex_unlock (m);
+    /* Returns right away if signaled since seq was read */
+    ece391_futex_wait (c, seq);
+    /* Others may be waiting for the mutex too */
+    while (MUTEX_UNLOCKED != atomic_xchg (m, MUTEX_CONTENDED))
+        ece391_futex_wait (m, MUTEX_CONTENDED);
+}
+
+void ece391_cond_signal(ece391_cond_t* c)
+{
+    asm volatile ("lock incl %0" : "+m" (*c) : : "memory");
+    ece391_futex_wake (c, 1);
+}
+
+void ece391_cond_broadcast(ece391_cond_t* c)
+{
+    asm volatile ("lock incl %0" : "+m" (*c) : : "memory");
+    ece391_futex_wake (c, ECE391_FUTEX_WAKE_ALL);
+}
@@ -5,6 +5,47 @@
 
 /* All calls return >= 0 on success or -1 on failure. */
 
+/* One cell update for ece391_poke_batch; data is the same as ece391_poke. */
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint16_t data;
+} ece391_poke_t;
+
+/* Time returned by ece391_clock_gettime */
+#define ECE391_CLOCK_REALTIME 0
+#define ECE391_CLOCK_MONOTONIC 1
+typedef struct {
+	uint32_t sec;
+	uint32_t nsec;
+} ece391_timespec_t;
+
+/* Read-only page the kernel keeps updated, mapped into every program.
+ * Retry reading while seq is odd, or if it changed during the read.
+ * Monotonic ns = ((rdtsc - tsc_base) * tsc_mult) >> tsc_shift if tsc_mult
+ * isn't 0, otherwise (ticks - pit_base) * ns_per_tick.
+ * Realtime seconds = boot_sec + monotonic seconds. */
+#define ECE391_CLOCK_PAGE ((const ece391_clock_page_t*) 0x08400000)
+#define ECE391_CLOCK_PAGE_TERMINALS 3
+typedef struct {
+	int32_t active_process;
+	uint32_t screen_x;
+	uint32_t screen_y;
+} ece391_clock_page_terminal_t;
+typedef struct {
+	volatile uint32_t seq;
+	uint32_t ticks;			/* 100 per second */
+	uint32_t pit_base;
+	uint32_t ns_per_tick;
+	uint64_t tsc_base;
+	uint32_t tsc_mult;
+	uint32_t tsc_shift;
+	uint32_t tsc_khz;
+	uint32_t boot_sec;
+	uint32_t displayed_terminal;
+	ece391_clock_page_terminal_t terminals[ECE391_CLOCK_PAGE_TERMINALS];
+} ece391_clock_page_t;
+
 /*
  * Note that the system call for halt will have to make sure that only
  * the low byte of EBX (the status argument) is returned to the calling
@@ -27,6 +68,38 @@ extern int32_t ece391_reboot (void);
 extern int32_t ece391_ps (void);
 extern int32_t ece391_poke (uint32_t x, uint32_t y, uint32_t data);
 extern int32_t ece391_status_msg (char* msg, uint32_t len, uint8_t attr);
+extern int32_t ece391_poke_batch (const ece391_poke_t* pokes, uint32_t count);
+/* pos is x | (y << 16), size is width | (height << 16) */
+extern int32_t ece391_blit (const uint16_t* cells, uint32_t pos, uint32_t size);
+extern int32_t ece391_set_mode (uint32_t xres, uint32_t yres, uint32_t bpp);
+/* Runs command in background, returns its pid without waiting for it */
+extern int32_t ece391_spawn (const uint8_t* command);
+/* Runs entry(arg) in a thread sharing memory and files, on the given stack top.
+ * The thread ends with ece391_halt, returns its pid */
+extern int32_t ece391_clone (void* entry, void* stack, void* arg);
+/* Block for the given time without spinning, rounded up to 10 ms timer ticks */
+extern int32_t ece391_sleep (uint32_t ms);
+extern int32_t ece391_nanosleep (uint32_t sec, uint32_t nsec);
+extern int32_t ece391_clock_gettime (uint32_t clock_id, ece391_timespec_t* ts);
+/* Sends ALARM signal after the given time, 0 cancels it */
+extern int32_t ece391_alarm (uint32_t ms);
+/* Creates a pipe, fds[0] is read end, fds[1] is write end */
+extern int32_t ece391_pipe (int32_t fds[2]);
+/* Makes new_fd refer to the file open as fd, closing new_fd first.
+ * Programs run with execute / spawn inherit descriptors 0 and 1 */
+extern int32_t ece391_dup2 (int32_t fd, int32_t new_fd);
+/* Shared memory of up to 64KB, found by key. Creating an existing key
+ * attaches it. Attach returns its address, the same in every process.
+ * Segments go away after the last process detaches or halts */
+extern int32_t ece391_shm_create (uint32_t key, uint32_t size);
+extern int32_t ece391_shm_attach (int32_t id);
+extern int32_t ece391_shm_detach (int32_t id);
+/* Blocks while *addr == val, until woken up. The word may be in the
+ * program's memory, shared with its threads, or in shared memory */
+extern int32_t ece391_futex_wait (volatile uint32_t* addr, uint32_t val);
+/* Wakes up to count waiters of *addr, returns how many were woken */
+extern int32_t ece391_futex_wake (volatile uint32_t* addr, uint32_t count);
+#define ECE391_FUTEX_WAKE_ALL 0x7fffffff
 
 enum signums {
 	DIV_ZERO = 0,
@@ -34,6 +107,7 @@ enum signums {
 	INTERRUPT,
 	ALARM,
 	USER1,
+	IO,		/* A device opened, or stdin on Enter, has data */
 	NUM_SIGNALS
 };
 
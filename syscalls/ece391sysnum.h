@@ -17,5 +17,21 @@
 #define SYS_PS 14
 #define SYS_POKE 15
 #define SYS_STATUS_MSG 16
+#define SYS_POKE_BATCH 17
+#define SYS_BLIT 18
+#define SYS_SET_MODE 19
+#define SYS_SPAWN 20
+#define SYS_CLONE 21
+#define SYS_SLEEP 22
+#define SYS_NANOSLEEP 23
+#define SYS_CLOCK_GETTIME 24
+#define SYS_ALARM 25
+#define SYS_PIPE 26
+#define SYS_DUP2 27
+#define SYS_SHM_CREATE 28
+#define SYS_SHM_ATTACH 29
+#define SYS_SHM_DETACH 30
+#define SYS_FUTEX_WAIT 31
+#define SYS_FUTEX_WAKE 32
 
 #endif /* ECE391SYSNUM_H */
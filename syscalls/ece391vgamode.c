@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+#define BUFSIZE 128
+
+/* Reads a decimal number from *s, moving *s past it and following spaces */
+static uint32_t read_number (uint8_t** s)
+{
+    uint32_t val = 0;
+    while (**s >= '0' && **s <= '9') {
+        val = val * 10 + (**s - '0');
+        (*s)++;
+    }
+    while (**s == ' ')
+        (*s)++;
+    return val;
+}
+
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    uint8_t* s = buf;
+    uint32_t xres, yres, bpp;
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*) "usage: vgamode <xres> <yres> <bpp>\n");
+        return 3;
+    }
+    xres = read_number (&s);
+    yres = read_number (&s);
+    bpp = read_number (&s);
+
+    if (-1 == ece391_set_mode (xres, yres, bpp)) {
+        ece391_fdputs (1, (uint8_t*) "mode not supported, bpp can be 8, 16 or 32\n");
+        return 2;
+    }
+
+    return 0;
+}